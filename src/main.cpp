@@ -1,70 +1,441 @@
 #include <llvm/Support/WithColor.h>
-#include <llvm/Bitcode/BitcodeWriter.h>
-#include <llvm/Support/Program.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Pass.h>
 
+#include "seam/build/scheduler.hpp"
 #include "seam/parser/parser.hpp"
 #include "seam/utils/exception.hpp"
+#include "seam/utils/source_map.hpp"
+#include "seam/utils/statistics.hpp"
+#include "seam/utils/thread_pool.hpp"
 #include "seam/types/module.hpp"
 #include "seam/code_generation/code_generation.hpp"
+#include "seam/code_generation/compilation_cache.hpp"
+#include "seam/code_generation/dependency_graph.hpp"
+#include "seam/code_generation/jit.hpp"
 
+#include <fstream>
+#include <iostream>
 #include <memory>
+#include <optional>
+#include <vector>
 
-int main()
+namespace
 {
-	const auto module = std::make_shared<seam::types::module>("test_module");
+	llvm::cl::list<std::string> input_paths{ llvm::cl::Positional, llvm::cl::OneOrMore,
+		llvm::cl::desc("<input files, - for standard input>") };
 
-	seam::parser::parser parser(module, "test", R"(
-fn main()
-{
-	x := 5 + 3
-	return
-}
-	)");
-	
-	try
-	{
-		module->body = parser.parse();
+	llvm::cl::opt<std::string> output_path{ "o", llvm::cl::value_desc("file"),
+		llvm::cl::desc("Generate code and write it to a file, or with several inputs to a file per module in a directory, "
+			"otherwise the sources are only checked") };
+
+	llvm::cl::opt<llvm::CodeGenFileType> file_type{ "filetype", llvm::cl::init(llvm::CGFT_ObjectFile),
+		llvm::cl::desc("Kind of file to write"),
+		llvm::cl::values(
+			clEnumValN(llvm::CGFT_ObjectFile, "obj", "Object file"),
+			clEnumValN(llvm::CGFT_AssemblyFile, "asm", "Assembly")) };
+
+	llvm::cl::opt<seam::code_generation::optimization_level> optimization{ llvm::cl::desc("Optimization level:"),
+		llvm::cl::init(seam::code_generation::optimization_level::o0),
+		llvm::cl::values(
+			clEnumValN(seam::code_generation::optimization_level::o0, "O0", "No optimization"),
+			clEnumValN(seam::code_generation::optimization_level::o1, "O1", "Quick optimizations"),
+			clEnumValN(seam::code_generation::optimization_level::o2, "O2", "Most optimizations"),
+			clEnumValN(seam::code_generation::optimization_level::o3, "O3", "Every optimization, including those trading size for speed"),
+			clEnumValN(seam::code_generation::optimization_level::os, "Os", "Optimizations which do not grow code")) };
+
+	llvm::cl::opt<seam::code_generation::local_storage> locals{ "locals", llvm::cl::init(seam::code_generation::local_storage::stack),
+		llvm::cl::desc("Where to keep local variables"),
+		llvm::cl::values(
+			clEnumValN(seam::code_generation::local_storage::stack, "stack", "Stack slots, promoted to registers by optimization"),
+			clEnumValN(seam::code_generation::local_storage::ssa, "ssa", "Registers, building SSA form directly")) };
 
-		/*seam::code_generation::code_generation code_gen{ module.get() };
-		auto module = code_gen.generate();
-		module->print(llvm::outs(), nullptr);
+	llvm::cl::opt<bool> jit{ "jit",
+		llvm::cl::desc("Generate code and run it in process, calling every constructor") };
 
+	llvm::cl::opt<bool> jit_eager{ "jit-eager",
+		llvm::cl::desc("Compile the whole program before running it with --jit, rather than each function when first called") };
+
+	llvm::cl::opt<std::string> cache_directory{ "cache-dir", llvm::cl::value_desc("directory"),
+		llvm::cl::desc("Reuse code compiled before from a cache in a directory, and add what is compiled to it") };
+
+	llvm::cl::opt<unsigned> thread_count{ "j", llvm::cl::init(1), llvm::cl::value_desc("threads"),
+		llvm::cl::desc("Number of threads to compile with, or to build several inputs on, 0 for one per hardware thread") };
+
+	llvm::cl::opt<bool> multi_pass{ "multi-pass",
+		llvm::cl::desc("Run semantic analysis as separate passes over the tree, for debugging") };
+
+	llvm::cl::list<std::string> disabled_passes{ "disable-pass", llvm::cl::CommaSeparated, llvm::cl::value_desc("passes"),
+		llvm::cl::desc("Passes not to run, along with every pass depending on them") };
+
+	llvm::cl::opt<std::string> time_trace{ "time-trace", llvm::cl::value_desc("file"),
+		llvm::cl::desc("Write every compilation phase, or with several inputs every task of the build, to a file in the Chrome trace event format") };
+
+	/**
+	 * Reports an error in a source at the line and column it occurred at.
+	 *
+	 * @param sources sources the error may have occurred in.
+	 * @param ex error to report.
+	 */
+	void report_error(const seam::utils::source_map& sources, const seam::utils::exception& ex)
+	{
+		const auto location = sources.resolve(ex.position);
+		llvm::errs() << sources.name(ex.position.file_id) << ':' << location.line << ':' << location.column << ": ";
+		llvm::WithColor::error() << ex.what() << '\n';
+	}
+
+	/**
+	 * Writes generated code to a file.
+	 *
+	 * @param path file to write to.
+	 * @param contents object or assembly to write.
+	 */
+	void write_file(const std::string& path, const llvm::StringRef contents)
+	{
 		std::error_code error_code;
-		llvm::raw_fd_ostream llvm_bitcode {"output.bc", error_code };
+		llvm::raw_fd_ostream output{ path, error_code,
+			file_type == llvm::CGFT_AssemblyFile ? llvm::sys::fs::OF_Text : llvm::sys::fs::OF_None };
+		if (error_code)
+		{
+			throw std::runtime_error("cannot write to '" + path + "': " + error_code.message());
+		}
+		output << contents;
+	}
+
+	/**
+	 * Generates code for a module and writes it to a file.
+	 *
+	 * @param code_gen code generator of the module, once it has been analysed.
+	 * @param cache cache to reuse the code from and add it to, or null.
+	 * @param source source the module was parsed from.
+	 * @param path file to write to.
+	 * @param statistics statistics to record phases in, or null.
+	 */
+	void write_output(seam::code_generation::code_generation& code_gen, seam::code_generation::compilation_cache* cache,
+		const std::string_view source, const std::string& path, seam::utils::statistics* statistics)
+	{
+		// Cached whole, as unchanged sources are the most common by far.
+		std::string key;
+		std::unique_ptr<llvm::MemoryBuffer> cached;
+		if (cache)
+		{
+			seam::utils::statistics::scope phase{ statistics, "look up cached module", "codegen" };
+			key = code_gen.module_cache_key(source, file_type);
+			cached = cache->load(key);
+			phase.set_nodes(cached ? 1 : 0);
+		}
+
+		llvm::SmallVector<char, 0> compiled;
+		llvm::StringRef contents;
+		if (cached)
+		{
+			contents = cached->getBuffer();
+		}
+		else
+		{
+			llvm::raw_svector_ostream stream{ compiled };
+			code_gen.emit(*code_gen.generate(), stream, file_type);
 
-		llvm::WriteBitcodeToFile(*module, llvm_bitcode);
-		llvm_bitcode.close();
+			contents = llvm::StringRef{ compiled.data(), compiled.size() };
+			if (cache)
+			{
+				cache->store(key, contents);
+			}
+		}
 
-		std::string llc_executable{ "C:\\Program Files (x86)\\llvm\\bin\\llc" };
+		// Only opened once the code is generated, so a failed build does not leave an empty file behind.
+		write_file(path, contents);
+	}
 
-		std::vector<llvm::StringRef> llc_args;
-		llc_args.push_back(llc_executable);
+	/**
+	 * Returns the file a module of several is written to, in the output directory.
+	 *
+	 * @param name name of the module.
+	 * @returns path of the file.
+	 */
+	std::string output_file(const std::string& name)
+	{
+		llvm::SmallString<128> path{ output_path };
+		llvm::sys::path::append(path, name + (file_type == llvm::CGFT_AssemblyFile ? ".s" : ".o"));
+		return path.str().str();
+	}
 
-		llc_args.push_back("-o");
-		llc_args.push_back("output.obj");
+	/**
+	 * Builds several sources, each a module named after its file, on a pool.
+	 *
+	 * Modules are generated on one thread each, so phases are not recorded,
+	 * the report of the build takes their place. Each module is written to a
+	 * file of its own, and the entry of the program, which runs the modules
+	 * in the order they import each other, to one more named entry.
+	 *
+	 * @param sources map to add the sources to.
+	 * @param modules filled in with the modules, which own their sources.
+	 * @param pool pool to build on.
+	 * @returns how the build ran.
+	 */
+	seam::build::report build_modules(seam::utils::source_map& sources, std::vector<std::shared_ptr<seam::types::module>>& modules,
+		seam::utils::thread_pool& pool)
+	{
+		if (jit)
+		{
+			throw std::runtime_error("--jit runs a single input");
+		}
 
-		llc_args.push_back("-filetype=obj");
+		std::vector<seam::build::source_file> files;
+		for (const auto& path : input_paths)
+		{
+			if (path == "-")
+			{
+				throw std::runtime_error("standard input can only be built alone");
+			}
 
-		llc_args.push_back("output.bc");
+			const auto& module = modules.emplace_back(std::make_shared<seam::types::module>(llvm::sys::path::stem(path).str()));
+			if (module->name == "entry")
+			{
+				throw std::runtime_error("module 'entry' would be written over the entry of the program");
+			}
+			module->source = seam::utils::mapped_file::open(path);
+			const auto source = module->source->contents();
+			files.push_back({ module, sources.add(path, source), source });
+		}
 
-		auto status = llvm::sys::ExecuteAndWait(llc_executable, llvm::makeArrayRef(llc_args), llvm::None);
-		if (status == -1)
+		std::optional<seam::code_generation::compilation_cache> cache;
+		seam::build::scheduler::compile_module compile;
+		if (!output_path.empty())
 		{
-			throw std::runtime_error("bitcode compiler failed to execute, make sure you have llc in the same folder as the compiler");
+			if (const auto error_code = llvm::sys::fs::create_directories(output_path))
+			{
+				throw std::runtime_error("cannot create directory '" + output_path + "': " + error_code.message());
+			}
+
+			if (!cache_directory.empty())
+			{
+				cache.emplace(cache_directory);
+			}
+
+			compile = [&](seam::types::module& module)
+			{
+				seam::code_generation::code_generation code_gen{ &module, nullptr, nullptr,
+					seam::code_generation::code_generation::default_partition_size, optimization, locals, false };
+				write_output(code_gen, cache ? &*cache : nullptr, module.source->contents(), output_file(module.name), nullptr);
+			};
 		}
-		else if (status == -2)
+
+		seam::build::scheduler scheduler{ pool, multi_pass, { disabled_passes.begin(), disabled_passes.end() } };
+		auto report = scheduler.build(files, compile);
+
+		if (!output_path.empty())
 		{
-			throw std::runtime_error("crash during bitcode compiling process");
-		}*/
+			std::vector<std::string> order;
+			for (const auto index : report.initialization_order())
+			{
+				order.push_back(report.modules[index]);
+			}
+
+			seam::types::module program{ "entry" };
+			seam::code_generation::code_generation code_gen{ &program, nullptr, nullptr,
+				seam::code_generation::code_generation::default_partition_size, optimization, locals };
+
+			llvm::SmallVector<char, 0> compiled;
+			llvm::raw_svector_ostream stream{ compiled };
+			code_gen.emit(*code_gen.generate_program_entry(order), stream, file_type);
+
+			write_file(output_file(program.name), llvm::StringRef{ compiled.data(), compiled.size() });
+		}
+		return report;
+	}
+
+	/**
+	 * Builds a single source, or standard input, into a module named after its file.
+	 *
+	 * @param sources map to add the source to.
+	 * @param modules filled in with the module, which owns its source.
+	 * @param pool pool to compile on in parallel, or null to compile serially.
+	 * @param statistics statistics to record phases in, or null.
+	 */
+	void build_module(seam::utils::source_map& sources, std::vector<std::shared_ptr<seam::types::module>>& modules,
+		seam::utils::thread_pool* pool, seam::utils::statistics* statistics)
+	{
+		const std::string path = input_paths.front();
+		const auto& module = modules.emplace_back(
+			std::make_shared<seam::types::module>(path == "-" ? "stdin" : llvm::sys::path::stem(path).str()));
+
+		// The mapping is owned by the module, so every view of the source stays valid as long as it does.
+		module->source = seam::utils::mapped_file::open(path);
+		const auto source = module->source->contents();
+		const auto file_id = sources.add(path, source);
+
+		seam::parser::parser parser(module, file_id, source, pool, multi_pass, statistics);
+		for (const auto& name : disabled_passes)
+		{
+			parser.passes().disable(name);
+		}
+
+		std::optional<seam::code_generation::code_generation> code_gen;
+		std::optional<seam::code_generation::compilation_cache> cache;
+		if (!output_path.empty() || jit)
+		{
+			code_gen.emplace(module.get(), statistics, pool, seam::code_generation::code_generation::default_partition_size,
+				optimization, locals);
+
+			if (!cache_directory.empty())
+			{
+				cache.emplace(cache_directory);
+			}
+		}
+
+		// Only run by the JIT, functions are compiled one at a time, so only those which changed have to be analysed.
+		std::optional<seam::code_generation::dependency_graph> graph;
+		seam::code_generation::function_keys keys;
+		std::vector<seam::ir::ast::statement::function_definition*> changed;
+		if (cache && jit && output_path.empty())
+		{
+			module->body = parser.parse_syntax();
+			{
+				seam::utils::statistics::scope phase{ statistics, "find changed functions", "frontend" };
+				const auto recorded = cache->load(seam::code_generation::dependency_graph::cache_entry(module->name));
+				graph = recorded ? seam::code_generation::dependency_graph::read(recorded->getBuffer()) : seam::code_generation::dependency_graph{};
+				changed = graph->update(module->body, source, module->symbols, code_gen->configuration_key(), *cache, keys);
+				phase.set_nodes(changed.size());
+			}
+			parser.analyse(module->body, changed);
+		}
+		else
+		{
+			module->body = parser.parse();
+		}
+
+		if (code_gen)
+		{
+			if (!output_path.empty())
+			{
+				write_output(*code_gen, cache ? &*cache : nullptr, source, output_path, statistics);
+			}
+
+			if (jit)
+			{
+				seam::code_generation::jit engine{ optimization, !jit_eager, statistics };
+
+				// Cached a function at a time, so editing a function only compiles that function again.
+				if (cache)
+				{
+					for (auto& object : code_gen->generate_objects(&*cache, graph ? &keys : nullptr))
+					{
+						engine.add_object(std::move(object));
+					}
+
+					if (graph)
+					{
+						graph->record(changed, module->symbols, keys);
+						cache->store(seam::code_generation::dependency_graph::cache_entry(module->name), graph->write());
+					}
+				}
+				else
+				{
+					if (output_path.empty())
+					{
+						code_gen->generate();
+					}
+					engine.add(code_gen->release());
+				}
+				engine.run();
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	llvm::cl::ParseCommandLineOptions(argc, argv, "Seam compiler\n");
+
+	// Every module owns its source, so the views errors are reported from stay valid as long as they do.
+	seam::utils::source_map sources;
+	std::vector<std::shared_ptr<seam::types::module>> modules;
+	const auto build = input_paths.size() > 1;
+
+	std::optional<seam::utils::thread_pool> pool;
+	if (thread_count != 1 || build)
+	{
+		pool.emplace(thread_count);
+	}
+
+	std::optional<seam::utils::statistics> statistics;
+	if (!build && (llvm::TimePassesIsEnabled || !time_trace.empty()))
+	{
+		statistics.emplace();
+	}
+
+	std::optional<seam::build::report> report;
+	try
+	{
+		if (build)
+		{
+			report = build_modules(sources, modules, *pool);
+		}
+		else
+		{
+			build_module(sources, modules, pool ? &*pool : nullptr, statistics ? &*statistics : nullptr);
+		}
 	}
 	catch (const seam::utils::exception& ex)
 	{
-		llvm::errs() << ex.position.line << ':' << ex.position.column << ": ";
-		llvm::WithColor::error() << ex.what() << '\n';
+		report_error(sources, ex);
+		return 1;
+	}
+	catch (const seam::utils::exception_list& ex)
+	{
+		for (const auto& error : ex.errors)
+		{
+			report_error(sources, error);
+		}
+		return 1;
 	}
 	catch (const std::exception& ex)
 	{
 		llvm::WithColor::error();
 		llvm::errs() << ex.what() << '\n';
+		return 1;
+	}
+
+	if (report)
+	{
+		// The build takes the place of phases, as modules are compiled on several threads at once.
+		if (llvm::TimePassesIsEnabled)
+		{
+			report->write_text(std::cerr);
+		}
+
+		if (!time_trace.empty())
+		{
+			std::ofstream trace{ time_trace };
+			report->write_chrome_trace(trace);
+			if (!trace)
+			{
+				llvm::WithColor::error() << "cannot write trace to '" << time_trace << "'\n";
+				return 1;
+			}
+		}
+	}
+
+	if (statistics)
+	{
+		// LLVM owns -time-passes, which also reports its own passes.
+		if (llvm::TimePassesIsEnabled)
+		{
+			statistics->write_text(std::cerr);
+		}
+
+		if (!time_trace.empty())
+		{
+			std::ofstream trace{ time_trace };
+			statistics->write_chrome_trace(trace);
+			if (!trace)
+			{
+				llvm::WithColor::error() << "cannot write trace to '" << time_trace << "'\n";
+				return 1;
+			}
+		}
 	}
 }
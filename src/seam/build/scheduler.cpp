@@ -0,0 +1,397 @@
+#include "scheduler.hpp"
+#include "../parser/parser.hpp"
+#include "../utils/exception.hpp"
+#include "../utils/statistics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace seam::build
+{
+	std::vector<std::size_t> report::initialization_order() const
+	{
+		std::vector<std::size_t> order;
+		std::vector<bool> added(modules.size());
+
+		// Imports cannot form a cycle, so a module is added once every module it imports has been.
+		const std::function<void(std::size_t)> add = [&](const std::size_t module)
+		{
+			if (added[module])
+			{
+				return;
+			}
+			added[module] = true;
+
+			for (const auto dependency : dependencies[module])
+			{
+				add(dependency);
+			}
+			order.push_back(module);
+		};
+
+		for (std::size_t module = 0; module < modules.size(); ++module)
+		{
+			add(module);
+		}
+		return order;
+	}
+
+	double report::work() const
+	{
+		double total = 0;
+		for (const auto& task : tasks)
+		{
+			total += task.duration;
+		}
+		return total;
+	}
+
+	std::vector<task> report::critical_path() const
+	{
+		if (tasks.empty())
+		{
+			return {};
+		}
+
+		const auto end = [](const task& current) { return current.start + current.duration; };
+		constexpr double tolerance = 1e-9; // starts and durations are rounded apart
+
+		const auto* current = &*std::max_element(tasks.cbegin(), tasks.cend(), [&](const task& a, const task& b)
+		{
+			return end(a) < end(b);
+		});
+
+		std::vector<task> path{ *current };
+		while (true)
+		{
+			// Held up by whichever ended last of the parses it needed and the task its worker ran before it.
+			const task* waited_on = nullptr;
+			bool waited_on_input = false;
+			for (const auto& other : tasks)
+			{
+				if (&other == current || end(other) > current->start + tolerance)
+				{
+					continue;
+				}
+
+				const auto& imported = dependencies[current->module];
+				const auto input = current->stage == stage::compile && other.stage == stage::parse
+					&& (other.module == current->module || std::find(imported.cbegin(), imported.cend(), other.module) != imported.cend());
+				if (!input && other.worker != current->worker)
+				{
+					continue;
+				}
+
+				// Inputs win ties, as the worker may have been free before the last of them ended.
+				if (!waited_on || end(other) > end(*waited_on) + tolerance
+					|| (input && !waited_on_input && end(other) + tolerance >= end(*waited_on)))
+				{
+					waited_on = &other;
+					waited_on_input = input;
+				}
+			}
+
+			if (!waited_on)
+			{
+				break;
+			}
+			path.push_back(*waited_on);
+			current = waited_on;
+		}
+
+		std::reverse(path.begin(), path.end());
+		return path;
+	}
+
+	double report::critical_path_length() const
+	{
+		double length = 0;
+		for (const auto& task : critical_path())
+		{
+			length += task.duration;
+		}
+		return length;
+	}
+
+	double report::utilization() const
+	{
+		return duration > 0 && workers > 0 ? work() / (duration * static_cast<double>(workers)) : 0;
+	}
+
+	void report::write_text(std::ostream& stream) const
+	{
+		char line[160];
+		stream << "===-------------------------------------------------------------------------===\n";
+		stream << "                              Seam build schedule\n";
+		stream << "===-------------------------------------------------------------------------===\n";
+		std::snprintf(line, sizeof(line), "%12s %12s %8s  %-8s %s\n", "Start", "Wall time", "Worker", "Stage", "Module");
+		stream << line;
+
+		auto sorted = tasks;
+		std::stable_sort(sorted.begin(), sorted.end(), [](const task& a, const task& b)
+		{
+			return a.start < b.start;
+		});
+		for (const auto& task : sorted)
+		{
+			std::snprintf(line, sizeof(line), "%9.3f ms %9.3f ms %8zu  %-8s %s\n", task.start * 1000.0, task.duration * 1000.0,
+				task.worker, task.stage == stage::parse ? "parse" : "compile", modules[task.module].c_str());
+			stream << line;
+		}
+
+		std::snprintf(line, sizeof(line), "\n%zu modules built in %.3f ms on %zu threads, %.3f ms of work\n",
+			modules.size(), duration * 1000.0, workers, work() * 1000.0);
+		stream << line;
+
+		std::snprintf(line, sizeof(line), "critical path: %.3f ms,", critical_path_length() * 1000.0);
+		stream << line;
+		const auto path = critical_path();
+		for (std::size_t i = 0; i < path.size(); ++i)
+		{
+			stream << (i == 0 ? " " : " then ") << (path[i].stage == stage::parse ? "parse " : "compile ") << modules[path[i].module];
+		}
+
+		std::snprintf(line, sizeof(line), "\ncore utilization: %.1f%%\n", utilization() * 100.0);
+		stream << line;
+	}
+
+	void report::write_chrome_trace(std::ostream& stream) const
+	{
+		stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		for (std::size_t i = 0; i < tasks.size(); ++i)
+		{
+			const auto& task = tasks[i];
+			const auto stage_name = task.stage == stage::parse ? "parse" : "compile";
+			stream << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+			utils::write_json_string(stream, stage_name + (' ' + modules[task.module]));
+			stream << ",\"cat\":\"" << stage_name << '"';
+
+			// Complete events, with times in microseconds.
+			stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << task.worker + 1
+				<< ",\"ts\":" << static_cast<std::uint64_t>(task.start * 1e6)
+				<< ",\"dur\":" << static_cast<std::uint64_t>(task.duration * 1e6) << '}';
+		}
+		stream << "\n]}\n";
+	}
+
+	scheduler::scheduler(utils::thread_pool& pool, const bool multi_pass, std::vector<std::string> disabled_passes) :
+		pool_(pool),
+		multi_pass_(multi_pass),
+		disabled_passes_(std::move(disabled_passes))
+	{}
+
+	report scheduler::build(const std::vector<source_file>& sources, const compile_module& compile)
+	{
+		using clock = std::chrono::steady_clock;
+
+		struct unit
+		{
+			std::unique_ptr<parser::parser> parser; // kept from parsing the module to compiling it
+			ir::ast::statement::restricted_block* root = nullptr;
+			bool parsed = false;
+			std::size_t waiting = 0; // modules it imports which are not parsed yet
+			std::vector<std::size_t> dependents; // modules waiting on it to be parsed
+			std::exception_ptr failure;
+		};
+
+		report result;
+		result.workers = pool_.size();
+		result.dependencies.resize(sources.size());
+
+		std::unordered_map<std::string_view, std::size_t> indices;
+		for (std::size_t i = 0; i < sources.size(); ++i)
+		{
+			const auto& name = sources[i].module->name;
+			if (!indices.emplace(name, i).second)
+			{
+				throw std::runtime_error("more than one source is module '" + name + "'");
+			}
+			result.modules.push_back(name);
+		}
+
+		std::vector<unit> units(sources.size());
+		std::unordered_map<std::thread::id, std::size_t> workers;
+		std::mutex mutex; // guards everything above, and the imports and dependencies of modules
+		std::condition_variable finished;
+		std::size_t running = 0;
+		const auto start = clock::now();
+
+		// Whether a module imports another, directly or not, as far as the modules parsed so far tell.
+		const auto imports = [&](const std::size_t from, const std::size_t to)
+		{
+			std::vector<std::size_t> pending{ from };
+			std::vector<bool> seen(sources.size());
+			while (!pending.empty())
+			{
+				const auto module = pending.back();
+				pending.pop_back();
+				if (module == to)
+				{
+					return true;
+				}
+
+				if (!seen[module])
+				{
+					seen[module] = true;
+					pending.insert(pending.end(), result.dependencies[module].cbegin(), result.dependencies[module].cend());
+				}
+			}
+			return false;
+		};
+
+		std::function<void(std::size_t, stage)> submit;
+
+		// Adds the modules a parsed module imports to its dependencies, then starts compiling every module which can be.
+		const auto parsed = [&](const std::size_t index)
+		{
+			auto& module = *sources[index].module;
+			auto& current = units[index];
+
+			// Modules which are not among the sources are reported as the module is compiled.
+			for (const auto& imported : module.imports)
+			{
+				const auto found = indices.find(imported.name);
+				if (found == indices.cend())
+				{
+					continue;
+				}
+
+				const auto dependency = found->second;
+				auto& dependencies = result.dependencies[index];
+				if (std::find(dependencies.cbegin(), dependencies.cend(), dependency) != dependencies.cend())
+				{
+					continue;
+				}
+
+				if (imports(dependency, index))
+				{
+					std::stringstream error_message;
+					error_message << "cannot import module '" << imported.name << "', as it imports '" << module.name << '\'';
+					throw utils::parser_exception{ imported.position, error_message.str() };
+				}
+
+				dependencies.push_back(dependency);
+				module.dependencies.push_back(sources[dependency].module);
+				if (!units[dependency].parsed)
+				{
+					++current.waiting;
+					units[dependency].dependents.push_back(index);
+				}
+			}
+
+			current.parsed = true;
+			if (current.waiting == 0)
+			{
+				submit(index, stage::compile);
+			}
+
+			// Modules whose own imports were an error are left waiting.
+			for (const auto dependent : current.dependents)
+			{
+				if (--units[dependent].waiting == 0 && !units[dependent].failure)
+				{
+					submit(dependent, stage::compile);
+				}
+			}
+		};
+
+		// Runs a stage of a module on the pool, called with the mutex held.
+		submit = [&](const std::size_t index, const stage kind)
+		{
+			++running;
+			pool_.submit([&, index, kind]()
+			{
+				const auto task_start = clock::now();
+				std::exception_ptr failure;
+				try
+				{
+					auto& current = units[index];
+					const auto& source = sources[index];
+					if (kind == stage::parse)
+					{
+						current.parser = std::make_unique<parser::parser>(source.module, source.file_id, source.source, nullptr, multi_pass_);
+						for (const auto& name : disabled_passes_)
+						{
+							current.parser->passes().disable(name);
+						}
+						current.root = current.parser->parse_syntax();
+					}
+					else
+					{
+						current.parser->analyse(current.root);
+						current.parser.reset();
+						if (compile)
+						{
+							compile(*source.module);
+						}
+					}
+				}
+				catch (...)
+				{
+					failure = std::current_exception();
+				}
+				const auto task_end = clock::now();
+
+				std::lock_guard lock{ mutex };
+				const auto worker = workers.emplace(std::this_thread::get_id(), workers.size()).first->second;
+				result.tasks.push_back({ index, kind, std::chrono::duration<double>(task_start - start).count(),
+					std::chrono::duration<double>(task_end - task_start).count(), worker });
+
+				if (!failure && kind == stage::parse)
+				{
+					// Published under the lock, before modules importing this one can be compiled.
+					sources[index].module->body = units[index].root;
+					try
+					{
+						parsed(index);
+					}
+					catch (...)
+					{
+						failure = std::current_exception();
+					}
+				}
+
+				// A module which failed to parse is not compiled, and neither is any module importing it.
+				if (failure)
+				{
+					units[index].failure = failure;
+				}
+
+				if (--running == 0)
+				{
+					finished.notify_all();
+				}
+			});
+		};
+
+		{
+			std::unique_lock lock{ mutex };
+			for (std::size_t i = 0; i < sources.size(); ++i)
+			{
+				submit(i, stage::parse);
+			}
+			finished.wait(lock, [&] { return running == 0; });
+		}
+
+		// Every module which could be built was, so the errors reported are the same whatever order tasks ran in.
+		std::vector<std::exception_ptr> failures;
+		failures.reserve(units.size());
+		for (const auto& current : units)
+		{
+			failures.push_back(current.failure);
+		}
+		utils::rethrow_all(failures);
+
+		result.duration = std::chrono::duration<double>(clock::now() - start).count();
+		return result;
+	}
+}
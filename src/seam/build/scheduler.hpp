@@ -0,0 +1,162 @@
+#pragma once
+
+#include "../types/module.hpp"
+#include "../utils/thread_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace seam::build
+{
+	/**
+	 * Source of a module to build.
+	 */
+	struct source_file
+	{
+		std::shared_ptr<types::module> module;
+		std::uint32_t file_id; // id of the source, see utils::source_map
+		std::string_view source; // source, which must outlive the module
+	};
+
+	/**
+	 * Stage of building a module, each run as a task of its own.
+	 */
+	enum class stage
+	{
+		parse, // lex and parse, after which the signatures of the module are known
+		compile, // analyse and generate code, once every module it imports is parsed
+	};
+
+	/**
+	 * Stage of a module, as it ran in a build.
+	 */
+	struct task
+	{
+		std::size_t module; // index of the module among the sources of the build
+		build::stage stage;
+		double start; // seconds since the build started
+		double duration; // seconds
+		std::size_t worker; // worker it ran on, numbered in the order workers first ran a task
+	};
+
+	/**
+	 * How a build ran, to tell how long it had to take and how busy it kept the pool.
+	 */
+	struct report
+	{
+		std::vector<std::string> modules; // names of the modules, in the order of the sources
+		std::vector<std::vector<std::size_t>> dependencies; // modules each module imports
+		std::vector<task> tasks; // in the order they finished
+		std::size_t workers = 0; // workers of the pool
+		double duration = 0; // seconds the whole build took
+
+		/**
+		 * Returns the modules in the order their constructors run, each after every module it imports.
+		 *
+		 * Modules which do not import each other keep the order of the sources.
+		 *
+		 * @returns indices of the modules.
+		 */
+		[[nodiscard]] std::vector<std::size_t> initialization_order() const;
+
+		/**
+		 * Returns the time spent in tasks, added up across workers.
+		 *
+		 * @returns seconds of work.
+		 */
+		[[nodiscard]] double work() const;
+
+		/**
+		 * Returns the chain of tasks the build waited on, ending with the task which finished last.
+		 *
+		 * Going back from that task, each task follows whichever ended last of
+		 * the parses it needed and the task its worker ran before it, as found
+		 * from the recorded times. Waiting for a free worker is on the path as
+		 * much as waiting for imports, so it shows what held this build up.
+		 *
+		 * @returns tasks on the path, in the order they ran.
+		 */
+		[[nodiscard]] std::vector<task> critical_path() const;
+
+		/**
+		 * Returns the time the tasks of the critical path take, leaving out the gaps between them.
+		 *
+		 * @returns seconds.
+		 */
+		[[nodiscard]] double critical_path_length() const;
+
+		/**
+		 * Returns the share of the time of every worker spent in tasks, over the whole build.
+		 *
+		 * @returns utilization, from 0 to 1.
+		 */
+		[[nodiscard]] double utilization() const;
+
+		/**
+		 * Writes a summary of the build.
+		 *
+		 * @param stream stream to write to.
+		 */
+		void write_text(std::ostream& stream) const;
+
+		/**
+		 * Writes every task in the Chrome trace event format, a thread per worker.
+		 *
+		 * @param stream stream to write to.
+		 */
+		void write_chrome_trace(std::ostream& stream) const;
+	};
+
+	/**
+	 * Builds modules which import each other, on a pool.
+	 *
+	 * Every module is parsed as soon as a worker is free. Compiling a module
+	 * only needs the signatures of the functions it imports, not their code,
+	 * so a module is compiled as soon as it and every module it imports are
+	 * parsed, alongside the modules it imports. Each module is analysed and
+	 * generated on one thread, as tasks of the pool must not wait on others.
+	 */
+	class scheduler
+	{
+	public:
+		// Generates code for a module once it has been analysed, on a worker.
+		using compile_module = std::function<void(types::module& module)>;
+
+	private:
+		utils::thread_pool& pool_;
+		bool multi_pass_;
+		std::vector<std::string> disabled_passes_;
+
+	public:
+		/**
+		 * Prepares to build on a pool.
+		 *
+		 * @param pool pool to run every task on.
+		 * @param multi_pass whether to analyse with separate passes, see parser::parser.
+		 * @param disabled_passes passes not to run, along with every pass depending on them.
+		 */
+		explicit scheduler(utils::thread_pool& pool, bool multi_pass = false, std::vector<std::string> disabled_passes = {});
+
+		/**
+		 * Builds modules.
+		 *
+		 * Imports name modules among the sources, which become dependencies
+		 * of the module importing them. Imports forming a cycle are an error.
+		 * A module which fails stops only the modules importing it, and once
+		 * every other module is built the errors are thrown in the order of
+		 * the sources.
+		 *
+		 * @param sources modules to build, each with a name of its own.
+		 * @param compile generates code for every module once it is analysed, may be empty to only analyse.
+		 * @returns how the build ran.
+		 * @throws utils::exception_list when several modules fail.
+		 */
+		report build(const std::vector<source_file>& sources, const compile_module& compile);
+	};
+}
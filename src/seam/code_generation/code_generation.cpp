@@ -1,18 +1,116 @@
 #include "code_generation.hpp"
-#include "../ir/ast/visitor.hpp"
+#include "../ir/ast/walker.hpp"
 #include "../ir/ast/type.hpp"
 
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/CFG.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/ValueHandle.h>
 #include <llvm/IR/Verifier.h>
-
+#include <llvm/Linker/Linker.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetOptions.h>
+
+#include <algorithm>
+#include <cstring>
+#include <future>
 #include <iostream>
+#include <sstream>
+#include <unordered_set>
 #include <variant>
 #include <type_traits>
 
 #include "../utils/exception.hpp"
 
+#ifndef SEAM_VERSION
+#define SEAM_VERSION "unknown"
+#endif
+
 namespace seam::code_generation
 {
+    // Raised whenever the same input generates different code, as cached code would otherwise be reused.
+    constexpr std::uint64_t cache_format = 1;
+
+    void initialize_native_target()
+    {
+        // Registering targets is not thread safe, so it is done once, by whichever thread gets here first.
+        static const auto registered = []()
+        {
+            llvm::InitializeNativeTarget();
+            llvm::InitializeNativeTargetAsmPrinter();
+            return true;
+        }();
+        static_cast<void>(registered);
+    }
+
+    llvm::CodeGenOpt::Level codegen_opt_level(const optimization_level level)
+    {
+        switch (level)
+        {
+            case optimization_level::o0: return llvm::CodeGenOpt::None;
+            case optimization_level::o1: return llvm::CodeGenOpt::Less;
+            case optimization_level::o2: return llvm::CodeGenOpt::Default;
+            case optimization_level::o3: return llvm::CodeGenOpt::Aggressive;
+            case optimization_level::os: return llvm::CodeGenOpt::Default;
+        }
+        return llvm::CodeGenOpt::Default;
+    }
+
+    std::unique_ptr<llvm::TargetMachine> code_generation::create_target_machine(const optimization_level level)
+    {
+        initialize_native_target();
+
+        const auto triple = llvm::sys::getDefaultTargetTriple();
+        std::string error;
+        const auto target = llvm::TargetRegistry::lookupTarget(triple, error);
+        if (!target)
+        {
+            throw std::runtime_error("cannot generate code for " + triple + ": " + error);
+        }
+
+        // Generic CPU, so the output does not depend on the machine compiling it, and position independent code, which
+        // links into executables as well as shared libraries.
+        return std::unique_ptr<llvm::TargetMachine>{ target->createTargetMachine(triple, "generic", "", llvm::TargetOptions{},
+            llvm::Reloc::PIC_, llvm::None, codegen_opt_level(level)) };
+    }
+
+    void code_generation::optimize(llvm::Module& module)
+    {
+        llvm::OptimizationLevel pipeline_level;
+        switch (level_)
+        {
+            case optimization_level::o0: return; // nothing to inline or lower at o0, so the pipeline would do nothing
+            case optimization_level::o1: pipeline_level = llvm::OptimizationLevel::O1; break;
+            case optimization_level::o2: pipeline_level = llvm::OptimizationLevel::O2; break;
+            case optimization_level::o3: pipeline_level = llvm::OptimizationLevel::O3; break;
+            case optimization_level::os: pipeline_level = llvm::OptimizationLevel::Os; break;
+        }
+
+        // Declared in this order, so they are destroyed in the order the pass builder expects.
+        llvm::LoopAnalysisManager loop_analyses;
+        llvm::FunctionAnalysisManager function_analyses;
+        llvm::CGSCCAnalysisManager cgscc_analyses;
+        llvm::ModuleAnalysisManager module_analyses;
+
+        // Given the target machine, passes know the costs of the target, which inlining and vectorisation rely on.
+        llvm::PassBuilder builder{ target_machine_.get() };
+        builder.registerModuleAnalyses(module_analyses);
+        builder.registerCGSCCAnalyses(cgscc_analyses);
+        builder.registerFunctionAnalyses(function_analyses);
+        builder.registerLoopAnalyses(loop_analyses);
+        builder.crossRegisterProxies(loop_analyses, function_analyses, cgscc_analyses, module_analyses);
+
+        auto passes = builder.buildPerModuleDefaultPipeline(pipeline_level);
+        passes.run(module, module_analyses);
+    }
+
     llvm::Type* code_generation::get_llvm_type(ir::ast::type* t)
     {
         /*
@@ -27,44 +125,44 @@ namespace seam::code_generation
                 {
                     case ir::ast::type::built_in_type::void_:
                     {
-                        return llvm::Type::getVoidTy(context_);
+                        return llvm::Type::getVoidTy(*context_);
                     }
                     case ir::ast::type::built_in_type::bool_:
                     {
-                        return llvm::Type::getInt1Ty(context_);
+                        return llvm::Type::getInt1Ty(*context_);
                     }
                     case ir::ast::type::built_in_type::u8:
                     case ir::ast::type::built_in_type::i8:
                     {
-                        return llvm::Type::getInt8Ty(context_);
+                        return llvm::Type::getInt8Ty(*context_);
                     }
                     case ir::ast::type::built_in_type::u16:
                     case ir::ast::type::built_in_type::i16:
                     {
-                        return llvm::Type::getInt16Ty(context_);
+                        return llvm::Type::getInt16Ty(*context_);
                     }
                     case ir::ast::type::built_in_type::u32:
                     case ir::ast::type::built_in_type::i32:
                     {
-                        return llvm::Type::getInt32Ty(context_);
+                        return llvm::Type::getInt32Ty(*context_);
                     }
                     case ir::ast::type::built_in_type::u64:
                     case ir::ast::type::built_in_type::i64:
                     {
-                        return llvm::Type::getInt64Ty(context_);
+                        return llvm::Type::getInt64Ty(*context_);
                     }
                     case ir::ast::type::built_in_type::string:
                     {
-                        std::array<llvm::Type*, 2> fields{ size_type, llvm::PointerType::get(llvm::Type::getInt8Ty(context_), 0) };
-                        return llvm::StructType::get(context_, llvm::makeArrayRef(fields), false);
+                        std::array<llvm::Type*, 2> fields{ size_type, llvm::PointerType::get(llvm::Type::getInt8Ty(*context_), 0) };
+                        return llvm::StructType::get(*context_, llvm::makeArrayRef(fields), false);
                     }
                     case ir::ast::type::built_in_type::f32:
                     {
-                        return llvm::Type::getFloatTy(context_);
+                        return llvm::Type::getFloatTy(*context_);
                     }
                     case ir::ast::type::built_in_type::f64:
                     {
-                        return llvm::Type::getDoubleTy(context_);
+                        return llvm::Type::getDoubleTy(*context_);
                     }
                     default:
                     {
@@ -79,9 +177,25 @@ namespace seam::code_generation
         }, t->value);
     }
 
+    /**
+     * Returns whether a function is visible outside its module, extern functions being defined outside of it.
+     *
+     * @param signature signature of the function.
+     * @returns whether the function is extern or exported.
+     */
+    bool is_external(ir::ast::expression::function_signature* signature)
+    {
+        return signature->is_extern || signature->attributes.find("export") != signature->attributes.cend();
+    }
+
+    std::string_view code_generation::function_name(ir::ast::expression::function_signature* signature) const
+    {
+        return mod_->symbols.name(is_external(signature) ? signature->name : signature->mangled_name);
+    }
+
     llvm::FunctionType* code_generation::get_llvm_function_type(utils::position position, ir::ast::expression::function_signature* signature)
     {
-        const auto& name = signature->mangled_name;
+        const auto name = signature->mangled_name;
         const auto& it = function_type_map.find(name);
         if (it != function_type_map.cend())
         {
@@ -89,7 +203,7 @@ namespace seam::code_generation
         }
 
 	    // set return type
-        const auto return_type = get_llvm_type(static_cast<ir::ast::type*>(signature->return_type.get()));
+        const auto return_type = get_llvm_type(static_cast<ir::ast::type*>(signature->return_type));
         if (!llvm::FunctionType::isValidReturnType(return_type))
         {
             throw utils::compiler_exception(position, "internal compiler error: invalid return type"); // func->range doesn't exist
@@ -98,7 +212,7 @@ namespace seam::code_generation
         std::vector<llvm::Type*> param_types;
     	for (const auto& param : signature->parameters)
     	{
-            const auto param_type = get_llvm_type(static_cast<ir::ast::type*>(param->var->type_.get()));
+            const auto param_type = get_llvm_type(static_cast<ir::ast::type*>(param->var->type_));
     		if (!llvm::FunctionType::isValidArgumentType(param_type))
     		{
     			throw utils::compiler_exception(position, "internal compiler error: invalid parameter type"); // functio nrange doesn't exist
@@ -112,25 +226,189 @@ namespace seam::code_generation
         return function_type;
     }
 	
-	struct function_collector : ir::ast::visitor
+	struct function_collector : ir::ast::walker<function_collector>
 	{
 		std::vector<ir::ast::statement::function_definition*> collected_functions;
         std::vector<ir::ast::statement::extern_function_definition*> collected_extern_functions;
 
+        using walker::visit;
+
         bool visit(ir::ast::statement::extern_function_definition* node)
         {
 			collected_extern_functions.push_back(node);
             return false;
         }
 
-		bool visit(ir::ast::statement::function_definition* node) override
+		bool visit(ir::ast::statement::function_definition* node)
 		{
 			collected_functions.push_back(node);
 			return false; // future: might return true for lambda funcs
 		}
 	};
 
-    struct code_gen_visitor : ir::ast::visitor
+    /**
+     * Adds a type to a cache key.
+     *
+     * @param key key to add to.
+     * @param t type to add, null if not known.
+     */
+    void add_type(cache_key& key, ir::ast::type* t)
+    {
+        const auto built_in = t ? std::get_if<ir::ast::type::built_in_type>(&t->value) : nullptr;
+        key.add(built_in ? static_cast<std::uint64_t>(*built_in) : ~std::uint64_t{ 0 });
+    }
+
+    void add_signature(cache_key& key, const utils::interner& symbols, ir::ast::expression::function_signature* signature)
+    {
+        key.add(symbols.name(signature->name)).add(symbols.name(signature->mangled_name)).add(signature->is_extern);
+        add_type(key, signature->return_type);
+        key.add(signature->parameters.size());
+        for (const auto param : signature->parameters)
+        {
+            add_type(key, param->var->type_);
+        }
+
+        // Attributes are a set, so they are sorted to be added in the same order every time.
+        std::vector<std::string_view> attributes{ signature->attributes.begin(), signature->attributes.end() };
+        std::sort(attributes.begin(), attributes.end());
+        key.add(attributes.size());
+        for (const auto attribute : attributes)
+        {
+            key.add(attribute);
+        }
+    }
+
+    /**
+     * Adds a tree to a cache key, along with the signature of every function it calls.
+     *
+     * Positions are left out, so moving a function within its file keeps its
+     * key, as do the names of its variables.
+     */
+    struct ast_hasher : ir::ast::walker<ast_hasher>
+    {
+        cache_key& key;
+        const utils::interner& symbols;
+        std::unordered_map<ir::ast::expression::variable*, std::uint64_t> variables; // numbered in order of first use
+
+        ast_hasher(cache_key& key, const utils::interner& symbols) :
+            key(key), symbols(symbols)
+        {}
+
+        using walker::visit;
+
+        void add_kind(ir::ast::node* node)
+        {
+            key.add(static_cast<std::uint64_t>(node->kind));
+        }
+
+        bool visit(ir::ast::node* node)
+        {
+            add_kind(node);
+            return true;
+        }
+
+        bool visit(ir::ast::expression::function_signature* node)
+        {
+            add_kind(node);
+            add_signature(key, symbols, node);
+            return true;
+        }
+
+        bool visit(ir::ast::statement::normal_block* node)
+        {
+            add_kind(node);
+            key.add(node->body.size());
+            return true;
+        }
+
+        bool visit(ir::ast::statement::ret* node)
+        {
+            add_kind(node);
+            key.add(node->value != nullptr);
+            return true;
+        }
+
+        bool visit(ir::ast::statement::if_stat* node)
+        {
+            add_kind(node);
+            key.add(node->else_body != nullptr);
+            return true;
+        }
+
+        bool visit(ir::ast::expression::unary* node)
+        {
+            add_kind(node);
+            key.add(static_cast<std::uint64_t>(node->operation));
+            return true;
+        }
+
+        bool visit(ir::ast::expression::binary* node)
+        {
+            add_kind(node);
+            key.add(static_cast<std::uint64_t>(node->operation));
+            return true;
+        }
+
+        bool visit(ir::ast::expression::call* node)
+        {
+            add_kind(node);
+            key.add(node->arguments.size());
+            return true;
+        }
+
+        bool visit(ir::ast::expression::symbol_wrapper* node)
+        {
+            add_kind(node);
+            if (const auto resolved = dynamic_cast<ir::ast::expression::resolved_symbol*>(node->value))
+            {
+                add_signature(key, symbols, resolved->signature);
+            }
+            else
+            {
+                key.add(symbols.name(static_cast<ir::ast::expression::unresolved_symbol*>(node->value)->value));
+            }
+            return false;
+        }
+
+        bool visit(ir::ast::expression::variable_ref* node)
+        {
+            add_kind(node);
+            key.add(variables.emplace(node->var, variables.size()).first->second);
+            add_type(key, node->var->type_);
+            return false;
+        }
+
+        bool visit(ir::ast::expression::bool_literal* node)
+        {
+            add_kind(node);
+            key.add(node->value);
+            return false;
+        }
+
+        bool visit(ir::ast::expression::string_literal* node)
+        {
+            add_kind(node);
+            key.add(node->value);
+            return false;
+        }
+
+        bool visit(ir::ast::expression::number_literal* node)
+        {
+            add_kind(node);
+            key.add(node->value.index());
+            std::visit([this](const auto value)
+            {
+                std::uint64_t bits;
+                static_assert(sizeof(value) == sizeof(bits));
+                std::memcpy(&bits, &value, sizeof(bits));
+                key.add(bits);
+            }, node->value);
+            add_type(key, node->eval_type);
+            return false;
+        }
+    };
+
+    struct code_gen_visitor : ir::ast::walker<code_gen_visitor>
     {
 	    explicit code_gen_visitor(llvm::IRBuilder<>& builder, code_generation& gen) :
             builder(builder), gen(gen)
@@ -138,21 +416,243 @@ namespace seam::code_generation
 
         llvm::IRBuilder<>& builder;
         code_generation& gen;
-        std::unordered_map<ir::ast::expression::variable*, llvm::Value*> variables;
+
+        // Stack storage: the slot of each variable, all in the entry block.
+        std::unordered_map<ir::ast::expression::variable*, llvm::AllocaInst*> slots;
+        llvm::AllocaInst* last_slot = nullptr; // slots are created after it, so they stay in declaration order
+
+        // SSA storage, built as in Braun et al., "Simple and Efficient Construction of Static Single Assignment Form".
+        // Definitions follow phi nodes which turn out to be trivial and are replaced.
+        std::unordered_map<ir::ast::expression::variable*, llvm::Type*> variable_types;
+        std::unordered_map<llvm::BasicBlock*, std::unordered_map<ir::ast::expression::variable*, llvm::WeakTrackingVH>> definitions;
+        std::unordered_map<llvm::BasicBlock*, std::vector<std::pair<ir::ast::expression::variable*, llvm::PHINode*>>> incomplete_phis;
+        std::unordered_set<llvm::BasicBlock*> sealed_blocks;
 
         llvm::Value* value = nullptr;
 
-        bool visit(ir::ast::expression::symbol_wrapper* node) override
+        using walker::visit;
+
+        /**
+         * Walks an expression for its value.
+         *
+         * @param node expression to walk.
+         * @returns value of the expression.
+         */
+        llvm::Value* walk_value(ir::ast::node* node)
+        {
+            walk(node);
+            return value;
+        }
+
+        /**
+         * Assigns a variable in the current block.
+         *
+         * @param var variable to assign.
+         * @param new_value value to assign.
+         */
+        void write_variable(ir::ast::expression::variable* var, llvm::Value* new_value)
+        {
+            if (gen.locals() == local_storage::stack)
+            {
+                builder.CreateStore(new_value, slot(var, new_value->getType()));
+                return;
+            }
+
+            variable_types.emplace(var, new_value->getType());
+            definitions[builder.GetInsertBlock()][var] = new_value;
+        }
+
+        /**
+         * Reads a variable in the current block.
+         *
+         * @param var variable to read.
+         * @param position position the variable is read at.
+         * @returns value of the variable.
+         * @throws utils::compiler_exception if the variable is not assigned before in the source.
+         */
+        llvm::Value* read_variable(ir::ast::expression::variable* var, const utils::position position)
+        {
+            // Neither storage knows the type of a variable which has not been assigned.
+            if (gen.locals() == local_storage::stack ? !slots.count(var) : !variable_types.count(var))
+            {
+                throw utils::compiler_exception{ position, "variable used before it is defined" };
+            }
+
+            if (gen.locals() == local_storage::stack)
+            {
+                const auto var_slot = slot(var, nullptr);
+                return builder.CreateLoad(var_slot->getAllocatedType(), var_slot);
+            }
+
+            return read_variable(var, builder.GetInsertBlock());
+        }
+
+        /**
+         * Marks a block as having every predecessor it will have, completing the phi nodes it was given before.
+         *
+         * @param block block to seal.
+         */
+        void seal_block(llvm::BasicBlock* block)
+        {
+            if (gen.locals() == local_storage::stack)
+            {
+                return;
+            }
+
+            sealed_blocks.insert(block);
+
+            const auto it = incomplete_phis.find(block);
+            if (it != incomplete_phis.cend())
+            {
+                const auto phis = std::move(it->second);
+                incomplete_phis.erase(it);
+                for (const auto& [var, phi] : phis)
+                {
+                    add_phi_operands(var, phi);
+                }
+            }
+        }
+
+    private:
+        /**
+         * Returns the slot of a variable, creating it at the top of the entry block the first time.
+         *
+         * @param var variable to find the slot of.
+         * @param type type of the variable if its declaration left it to be inferred, otherwise null.
+         * @returns slot of the variable.
+         */
+        llvm::AllocaInst* slot(ir::ast::expression::variable* var, llvm::Type* type)
+        {
+            auto& var_slot = slots[var];
+            if (!var_slot)
+            {
+                // Slots are only allocated once however often the block declaring them runs, and mem2reg only
+                // promotes slots in the entry block.
+                auto& entry_block = builder.GetInsertBlock()->getParent()->getEntryBlock();
+                llvm::IRBuilder<> entry_builder{ &entry_block,
+                    last_slot ? std::next(last_slot->getIterator()) : entry_block.getFirstInsertionPt() };
+                var_slot = entry_builder.CreateAlloca(var->type_ ? gen.get_llvm_type(var->type_) : type, nullptr);
+                last_slot = var_slot;
+            }
+            return var_slot;
+        }
+
+        llvm::Value* read_variable(ir::ast::expression::variable* var, llvm::BasicBlock* block)
+        {
+            const auto& block_definitions = definitions[block];
+            const auto it = block_definitions.find(var);
+            if (it != block_definitions.cend())
+            {
+                return it->second;
+            }
+
+            // Not assigned in this block, so the value comes from its predecessors.
+            llvm::Value* result;
+            if (!sealed_blocks.count(block))
+            {
+                // More predecessors are still to come, so the phi node is completed when the block is sealed.
+                const auto phi = create_phi(var, block);
+                incomplete_phis[block].emplace_back(var, phi);
+                result = phi;
+            }
+            else if (llvm::pred_empty(block))
+            {
+                result = llvm::UndefValue::get(variable_types.at(var)); // unreachable
+            }
+            else if (const auto predecessor = block->getSinglePredecessor())
+            {
+                result = read_variable(var, predecessor);
+            }
+            else
+            {
+                // Defined before its operands are read, which breaks cycles through loops.
+                const auto phi = create_phi(var, block);
+                definitions[block][var] = phi;
+                result = add_phi_operands(var, phi);
+            }
+
+            definitions[block][var] = result;
+            return result;
+        }
+
+        llvm::PHINode* create_phi(ir::ast::expression::variable* var, llvm::BasicBlock* block)
+        {
+            llvm::IRBuilder<> phi_builder{ block, block->begin() };
+            return phi_builder.CreatePHI(variable_types.at(var), 0);
+        }
+
+        llvm::Value* add_phi_operands(ir::ast::expression::variable* var, llvm::PHINode* phi)
+        {
+            for (const auto predecessor : llvm::predecessors(phi->getParent()))
+            {
+                phi->addIncoming(read_variable(var, predecessor), predecessor);
+            }
+            return try_remove_trivial_phi(phi);
+        }
+
+        /**
+         * Replaces a phi node which only merges one value, other than itself, with that value.
+         *
+         * @param phi phi node to check.
+         * @returns the value replacing the phi node, or the phi node if it is needed.
+         */
+        llvm::Value* try_remove_trivial_phi(llvm::PHINode* phi)
+        {
+            llvm::Value* same = nullptr;
+            for (const auto& operand : phi->incoming_values())
+            {
+                if (operand == same || operand == phi)
+                {
+                    continue;
+                }
+                if (same)
+                {
+                    return phi;
+                }
+                same = operand;
+            }
+
+            if (!same)
+            {
+                same = llvm::UndefValue::get(phi->getType()); // unreachable, or only read before being assigned
+            }
+
+            // Phi nodes using this one may have become trivial in turn. Removing one can remove another, so they are
+            // only held weakly.
+            std::vector<llvm::WeakVH> users;
+            for (const auto user : phi->users())
+            {
+                if (user != phi && llvm::isa<llvm::PHINode>(user))
+                {
+                    users.emplace_back(user);
+                }
+            }
+
+            phi->replaceAllUsesWith(same);
+            phi->eraseFromParent();
+
+            for (const auto& user : users)
+            {
+                if (user)
+                {
+                    try_remove_trivial_phi(llvm::cast<llvm::PHINode>(user));
+                }
+            }
+            return same;
+        }
+
+    public:
+        bool visit(ir::ast::expression::symbol_wrapper* node)
         {
             value = gen.get_or_declare_function(node->range.start,
-                static_cast<ir::ast::expression::resolved_symbol*>(node->value.get())->signature.get());
+                static_cast<ir::ast::expression::resolved_symbol*>(node->value)->signature);
             return false;
         }
     	
-        bool visit(ir::ast::expression::call* node) override
+        bool visit(ir::ast::expression::call* node)
         {
         	// TODO: Handle call expressions in code_gen.
-            node->function->visit(this);
+            walk(node->function);
             if (!llvm::isa<llvm::Function>(value))
             {
                 throw utils::compiler_exception{ node->range.start, "internal compiler error: expected function for call" };
@@ -163,36 +663,26 @@ namespace seam::code_generation
             std::vector<llvm::Value*> arguments;
             for (const auto& arg : node->arguments)
             {
-                arg->visit(this);
-                arguments.emplace_back(value);
+                arguments.emplace_back(walk_value(arg));
             }
             // TODO: More work here...
             value = builder.CreateCall(func, llvm::makeArrayRef(arguments));
             return false;
         }
     	
-        bool visit(ir::ast::expression::bool_literal* node) override
+        bool visit(ir::ast::expression::bool_literal* node)
         {
             value = llvm::ConstantInt::get(builder.getContext(), llvm::APInt(1, node->value));
             return false;
         }
 
-        bool visit(ir::ast::expression::variable_ref* node) override
+        bool visit(ir::ast::expression::variable_ref* node)
         {
-			const auto var = node->var.get();
-			const auto& it = variables.find(var);
-			if (it != variables.cend())
-			{
-				value = it->second;
-            }
-			else
-			{
-				value = builder.CreateAlloca(gen.get_llvm_type(var->type_.get()), nullptr); // TODO: allocate all variables in entry block
-			}
+            value = read_variable(node->var, node->range.start);
             return false;
         }
 
-        bool visit(ir::ast::expression::number_literal* node) override
+        bool visit(ir::ast::expression::number_literal* node)
         {
             value = std::visit(
                 [this, node](auto&& value) -> llvm::Value*
@@ -260,7 +750,7 @@ namespace seam::code_generation
             return false;
         }
 
-        bool visit(ir::ast::statement::while_loop* node) override
+        bool visit(ir::ast::statement::while_loop* node)
         {
             auto start_block = builder.GetInsertBlock();
 
@@ -272,126 +762,105 @@ namespace seam::code_generation
                 builder.CreateBr(loop_start_block);
             }
 
+            // The loop start is not sealed until the body branches back to it.
             builder.SetInsertPoint(loop_start_block);
-            node->condition->visit(this);
-            auto condition_value = value;
+            auto condition_value = walk_value(node->condition);
 
             auto loop_body_block = llvm::BasicBlock::Create(builder.getContext(), "loopbody",
                 start_block->getParent());
+            auto end_block = llvm::BasicBlock::Create(builder.getContext(), "end",
+                start_block->getParent());
+            builder.CreateCondBr(condition_value, loop_body_block, end_block);
+
             builder.SetInsertPoint(loop_body_block);
-            node->body->visit(this);
+            seal_block(loop_body_block);
+            walk(node->body);
 
-            if (!loop_body_block->getTerminator())
+            // The body may have ended in a block of its own, such as after a nested if.
+            if (!builder.GetInsertBlock()->getTerminator())
             {
-                builder.SetInsertPoint(loop_body_block);
                 builder.CreateBr(loop_start_block);
             }
-
-            auto end_block = llvm::BasicBlock::Create(builder.getContext(), "end",
-                start_block->getParent());
-            builder.SetInsertPoint(loop_start_block);
-            builder.CreateCondBr(condition_value, loop_body_block, end_block);
+            seal_block(loop_start_block);
 
             builder.SetInsertPoint(end_block);
+            seal_block(end_block);
 
             return false;
         }
     	
-		bool visit(ir::ast::statement::assignment* node) override
+		bool visit(ir::ast::statement::assignment* node)
 		{
-			node->to->visit(this);
-			const auto to = value;
-			node->from->visit(this);
-			auto from = value;
-
-			if (llvm::isa<llvm::AllocaInst>(from))
-			{
-				from = builder.CreateLoad(from);
-			}
+            if (node->to->kind != ir::ast::node_kind::variable_ref)
+            {
+                throw utils::compiler_exception{ node->range.start, "internal compiler error: expected variable to assign" };
+            }
 
-            builder.CreateStore(from, to);
+			const auto from = walk_value(node->from);
+            write_variable(static_cast<ir::ast::expression::variable_ref*>(node->to)->var, from);
 
 			return false;
 		}
 
-        bool visit(ir::ast::statement::if_stat* node) override
+        bool visit(ir::ast::statement::if_stat* node)
         {
-            node->condition->visit(this);
-            auto condition_value = value;
+            auto condition_value = walk_value(node->condition);
 
             auto start_block = builder.GetInsertBlock();
             
             auto main_body_block = llvm::BasicBlock::Create(builder.getContext(), "mainbody",
                 start_block->getParent());
+            auto else_body_block = node->else_body
+                ? llvm::BasicBlock::Create(builder.getContext(), "elsebody", start_block->getParent())
+                : nullptr;
+            auto end_block = llvm::BasicBlock::Create(builder.getContext(), "end",
+                start_block->getParent());
+
+            // Branched on before the bodies are compiled, so both are sealed from the start.
+            if (!start_block->getTerminator())
+            {
+                builder.CreateCondBr(condition_value, main_body_block, else_body_block ? else_body_block : end_block);
+            }
 
             builder.SetInsertPoint(main_body_block);
-            node->main_body->visit(this);
+            seal_block(main_body_block);
+            walk(node->main_body);
 
-            if (node->else_body)
+            // Blocks nested in the body may follow it.
+            if (!builder.GetInsertBlock()->getTerminator())
             {
-                auto else_body_block = llvm::BasicBlock::Create(builder.getContext(), "elsebody",
-                    start_block->getParent());
+                builder.CreateBr(end_block);
+            }
 
+            if (else_body_block)
+            {
                 builder.SetInsertPoint(else_body_block);
-                node->main_body->visit(this);
-
-                auto end_block = llvm::BasicBlock::Create(builder.getContext(), "end",
-                    start_block->getParent());
+                seal_block(else_body_block);
+                walk(node->else_body);
 
-                builder.SetInsertPoint(start_block);
-                builder.CreateCondBr(condition_value, main_body_block, else_body_block);
-
-                if (!main_body_block->getTerminator())
+                if (!builder.GetInsertBlock()->getTerminator())
                 {
-                    builder.SetInsertPoint(main_body_block);
                     builder.CreateBr(end_block);
                 }
-
-                if (!else_body_block->getTerminator())
-                {
-                    builder.SetInsertPoint(else_body_block);
-                    builder.CreateBr(end_block);
-                }
-
-                builder.SetInsertPoint(end_block);
             }
-            else
-            {
-                auto end_block = llvm::BasicBlock::Create(builder.getContext(), "end",
-                    start_block->getParent());
-
-                if (!start_block->getTerminator())
-                {
-                    builder.SetInsertPoint(start_block);
-                    builder.CreateCondBr(condition_value, main_body_block, end_block);
-                }
 
-                if (!main_body_block->getTerminator())
-                {
-                    builder.SetInsertPoint(main_body_block);
-                    builder.CreateBr(end_block);
-                }
-
-                builder.SetInsertPoint(end_block);
-            }
+            // Placed after the bodies, so blocks are laid out in source order.
+            end_block->moveAfter(builder.GetInsertBlock());
+            builder.SetInsertPoint(end_block);
+            seal_block(end_block);
             return false;
         }
 
-        bool visit(ir::ast::statement::expression_* node) override
+        bool visit(ir::ast::statement::expression_*)
         {
             return true;
         }
     	
-        bool visit(ir::ast::statement::ret* node) override
+        bool visit(ir::ast::statement::ret* node)
         {
             if (node->value)
             {
-                node->value->visit(this); // generate return
-				if (llvm::isa<llvm::AllocaInst>(value))
-				{
-					value = builder.CreateLoad(value);
-				}
-                builder.CreateRet(value);
+                builder.CreateRet(walk_value(node->value)); // generate return
             }
             else
             {
@@ -400,18 +869,15 @@ namespace seam::code_generation
             return false;
         }
 
-        bool visit(ir::ast::statement::normal_block* node) override
+        bool visit(ir::ast::statement::normal_block*)
         {
 			return true;
         }
 
-        bool visit(ir::ast::expression::binary* node) override
+        bool visit(ir::ast::expression::binary* node)
         {
-            node->left->visit(this);
-            const auto lhs_value = value;
-
-            node->right->visit(this);
-            const auto rhs_value = value;
+            const auto lhs_value = walk_value(node->left);
+            const auto rhs_value = walk_value(node->right);
 
             // TODO: correct?
             bool unsigned_operation = false;//resolved_left->is_unsigned && resolved_right->is_unsigned;
@@ -582,84 +1048,501 @@ namespace seam::code_generation
 	
     llvm::Function* code_generation::get_or_declare_function(utils::position position, ir::ast::expression::function_signature* signature)
     {
-        auto name = signature->is_extern ? signature->name : signature->mangled_name;
+        const auto name = function_name(signature);
         auto func = llvm_module->getFunction(name);
     	if (!func)
     	{
             llvm::FunctionType* func_type = get_llvm_function_type(position, signature);
-            func = llvm::Function::Create(func_type, signature->is_extern ? llvm::GlobalValue::ExternalLinkage : llvm::GlobalValue::InternalLinkage, name, *llvm_module);
+            // Functions may be defined in another partition, which can only be linked to externally.
+            const auto linkage = is_external(signature) || partitioned_ ? llvm::GlobalValue::ExternalLinkage : llvm::GlobalValue::InternalLinkage;
+            func = llvm::Function::Create(func_type, linkage, name, *llvm_module);
     	}
         return func;
     }
 
     void code_generation::compile_function(ir::ast::statement::function_definition* func)
 	{
-        llvm::Function* llvm_func = get_or_declare_function(func->range.start, func->signature.get());
-        llvm::BasicBlock* basic_block = llvm::BasicBlock::Create(context_, "entry",
+        llvm::Function* llvm_func = get_or_declare_function(func->range.start, func->signature);
+        llvm::BasicBlock* basic_block = llvm::BasicBlock::Create(*context_, "entry",
             llvm_func);
         llvm::IRBuilder<> builder(basic_block);
 
         code_gen_visitor code_gen { builder, *this };
-        func->body->visit(&code_gen);
+        code_gen.seal_block(basic_block);
 
-        const auto& attribs = func->signature->attributes;
-        if (attribs.find("constructor") != attribs.cend())
+        // Parameters are variables like any other, assigned their arguments on entry.
+        auto argument = llvm_func->arg_begin();
+        for (const auto& param : func->signature->parameters)
         {
-            builder.CreateRetVoid(); //TODO: remove once types are added
-            constructor_functions.push_back(llvm_func);
+            code_gen.write_variable(param->var, &*argument++);
+        }
+
+        code_gen.walk(func->body);
+
+        if (!builder.GetInsertBlock()->getTerminator())
+        {
+            // Functions returning nothing, constructors among them, may end without a return.
+            if (llvm_func->getReturnType()->isVoidTy())
+            {
+                builder.CreateRetVoid();
+            }
+            // Nothing branches to the block following an if whose bodies both return.
+            else if (builder.GetInsertBlock() != basic_block && llvm::pred_empty(builder.GetInsertBlock()))
+            {
+                builder.CreateUnreachable();
+            }
+            else
+            {
+                std::stringstream error_message;
+                error_message << "function '" << mod_->symbols.name(func->signature->name) << "' does not return a value on every path";
+                throw utils::compiler_exception{ func->range.start, error_message.str() };
+            }
         }
 
         std::string error;
         llvm::raw_string_ostream error_stream{ error };
         if (llvm::verifyFunction(*llvm_func, &error_stream))
         {
-            //throw std::runtime_error(error);
+            throw utils::compiler_exception{ func->range.start, "internal compiler error: " + error_stream.str() };
         }
     }
 
     void code_generation::compile_extern_function(ir::ast::statement::extern_function_definition* func)
     {
-        get_or_declare_function(func->range.start, func->signature.get());
+        get_or_declare_function(func->range.start, func->signature);
+    }
+
+    std::string code_generation::entry_name(const std::string_view module)
+    {
+        std::string name{ module };
+        name += "@entry";
+        return name;
+    }
+
+    void code_generation::compile_entry_function(const function_collector& collector)
+    {
+        // Visible outside the module, so the entry of a program made of several modules can call it.
+        auto entry_function = llvm::Function::Create(llvm::FunctionType::get(llvm::Type::getVoidTy(*context_), false),
+            llvm::GlobalValue::ExternalLinkage,
+            entry_name(mod_->name), 
+            *llvm_module);
+		auto entry_basic_block = llvm::BasicBlock::Create(*context_, "entry", entry_function);
+        llvm::IRBuilder<> entry_builder(entry_basic_block);
+
+        for (const auto func : collector.collected_functions)
+        {
+            const auto& attribs = func->signature->attributes;
+            if (attribs.find("constructor") != attribs.cend())
+            {
+                entry_builder.CreateCall(get_or_declare_function(func->range.start, func->signature));
+            }
+        }
+
+        entry_builder.CreateRetVoid();
+
+        if (program_)
+        {
+            compile_program_entry({ mod_->name });
+        }
+    }
+
+    void code_generation::compile_program_entry(const std::vector<std::string>& modules)
+    {
+        // The entry of the program is where it starts, so it is the one function every program defines.
+        const auto void_function = llvm::FunctionType::get(llvm::Type::getVoidTy(*context_), false);
+        auto program_entry = llvm::Function::Create(void_function, llvm::GlobalValue::ExternalLinkage, "entry", *llvm_module);
+        llvm::IRBuilder<> builder(llvm::BasicBlock::Create(*context_, "entry", program_entry));
+
+        for (const auto& module : modules)
+        {
+            builder.CreateCall(llvm_module->getOrInsertFunction(entry_name(module), void_function));
+        }
+
+        builder.CreateRetVoid();
+    }
+
+    template <typename MakeResult>
+    auto code_generation::compile_partitions(const std::vector<ir::ast::statement::function_definition*>& functions,
+        const std::size_t partition_size, MakeResult make_result)
+    {
+        using result_t = std::invoke_result_t<MakeResult&, code_generation&>;
+
+        const auto partition_count = (functions.size() + partition_size - 1) / partition_size;
+
+        std::vector<std::future<result_t>> pending;
+        pending.reserve(partition_count);
+
+        for (std::size_t i = 0; i < partition_count; ++i)
+        {
+            const auto begin = i * partition_size;
+            const auto end = std::min(begin + partition_size, functions.size());
+
+            // Each partition has a context of its own, as contexts are not thread safe.
+            auto task = [this, &functions, &make_result, begin, end]()
+            {
+                code_generation generator{ mod_, nullptr, nullptr, partition_size_, level_, locals_, program_ };
+                generator.partitioned_ = true;
+                for (auto i = begin; i < end; ++i)
+                {
+                    generator.compile_function(functions[i]);
+                }
+                return make_result(generator);
+            };
+
+            if (pool_)
+            {
+                pending.push_back(pool_->submit(std::move(task)));
+            }
+            else
+            {
+                std::packaged_task<result_t()> run{ std::move(task) };
+                pending.push_back(run.get_future());
+                run();
+            }
+        }
+
+        // Tasks refer to the functions, so wait for every one before an exception can leave. Waiting on the pool
+        // runs queued partitions meanwhile, so generating from a worker, as when building modules, cannot deadlock.
+        for (const auto& result : pending)
+        {
+            if (pool_)
+            {
+                pool_->wait(result);
+            }
+            else
+            {
+                result.wait();
+            }
+        }
+
+        // The first partition which failed holds the first error in the source, whatever order they ran in.
+        std::vector<result_t> results;
+        results.reserve(partition_count);
+        for (auto& result : pending)
+        {
+            results.push_back(result.get());
+        }
+        return results;
     }
 
     std::shared_ptr<llvm::Module> code_generation::generate()
     {
 		function_collector collector;
-		mod_->body->visit(&collector);
+        {
+            utils::statistics::scope phase{ statistics_, "collect functions", "codegen" };
+		    collector.walk(mod_->body);
+            phase.set_nodes(collector.collected_functions.size() + collector.collected_extern_functions.size());
+        }
 
         // Iterate over collected extern functions
-        for (const auto func : collector.collected_extern_functions)
         {
-            compile_extern_function(func);
+            utils::statistics::scope phase{ statistics_, "declare extern functions", "codegen" };
+            for (const auto func : collector.collected_extern_functions)
+            {
+                compile_extern_function(func);
+            }
+            phase.set_nodes(collector.collected_extern_functions.size());
         }
 
-        // Iterate over collected functions
-        for (const auto func : collector.collected_functions)
+        // Iterate over collected functions, in partitions when there are threads to share them between
+        const auto& functions = collector.collected_functions;
+        if (pool_ && pool_->size() > 1 && functions.size() > partition_size_)
         {
-			compile_function(func);
+            std::vector<llvm::SmallVector<char, 0>> partitions;
+            {
+                utils::statistics::scope phase{ statistics_, "compile functions", "codegen" };
+
+                // Partitions are written out as bitcode, the only way to move a module between contexts.
+                partitions = compile_partitions(functions, partition_size_, [](const code_generation& generator)
+                {
+                    llvm::SmallVector<char, 0> bitcode;
+                    llvm::raw_svector_ostream stream{ bitcode };
+                    llvm::WriteBitcodeToFile(*generator.llvm_module, stream);
+                    return bitcode;
+                });
+                phase.set_nodes(functions.size());
+            }
+
+            utils::statistics::scope phase{ statistics_, "link partitions", "codegen" };
+
+            // Linked in source order, so the module is the same whatever order the partitions were compiled in.
+            llvm::Linker linker{ *llvm_module };
+            for (const auto& bitcode : partitions)
+            {
+                auto partition_module = llvm::parseBitcodeFile(llvm::MemoryBufferRef{
+                    llvm::StringRef{ bitcode.data(), bitcode.size() }, mod_->name }, *context_);
+                if (!partition_module)
+                {
+                    throw std::runtime_error("internal compiler error: cannot read partition: " + llvm::toString(partition_module.takeError()));
+                }
+
+                if (linker.linkInModule(std::move(*partition_module)))
+                {
+                    throw std::runtime_error("internal compiler error: cannot link partition");
+                }
+            }
+
+            // Every function is defined now, so only exported ones have to be visible outside the module. Linking leaves
+            // them in the order partitions first referred to them, so they are laid out in source order as they are serially.
+            for (const auto func : functions)
+            {
+                const auto llvm_func = llvm_module->getFunction(function_name(func->signature));
+                if (!is_external(func->signature))
+                {
+                    llvm_func->setLinkage(llvm::GlobalValue::InternalLinkage);
+                }
+                llvm_func->removeFromParent();
+                llvm_module->getFunctionList().push_back(llvm_func);
+            }
+            phase.set_nodes(partitions.size());
         }
+        else
+        {
+            utils::statistics::scope phase{ statistics_, "compile functions", "codegen" };
 
-        auto entry_function = llvm::Function::Create(llvm::FunctionType::get(llvm::Type::getVoidTy(context_), false),
-            llvm::GlobalValue::InternalLinkage,
-            "entry", 
-            *llvm_module);
-		auto entry_basic_block = llvm::BasicBlock::Create(context_, "entry", entry_function);
-        llvm::IRBuilder<> entry_builder(entry_basic_block);
+            // Declared up front, so functions are laid out in source order whichever calls which first.
+            for (const auto func : functions)
+            {
+                get_or_declare_function(func->range.start, func->signature);
+            }
+
+            for (const auto func : functions)
+            {
+			    compile_function(func);
+            }
+            phase.set_nodes(functions.size());
+        }
 
-        for (const auto& constructor_func : constructor_functions)
         {
-            entry_builder.CreateCall(constructor_func);
+            utils::statistics::scope phase{ statistics_, "entry function and verification", "codegen" };
+            compile_entry_function(collector);
+
+            std::string error;
+            llvm::raw_string_ostream error_stream{ error };
+            if (llvm::verifyModule(*llvm_module, &error_stream))
+            {
+                throw utils::compiler_exception{ { 0, 0 }, "internal compiler error: " + error_stream.str() };
+            }
         }
 
-        entry_builder.CreateRetVoid();
+        utils::statistics::scope phase{ statistics_, "optimize", "codegen" };
+        optimize(*llvm_module);
+        phase.set_nodes(llvm_module->size());
+
+        // Owned by this generator, so it can still be released.
+        return std::shared_ptr<llvm::Module>{ std::shared_ptr<llvm::Module>{}, llvm_module.get() };
+    }
+
+    std::vector<partition> code_generation::generate_partitions()
+    {
+        function_collector collector;
+        {
+            utils::statistics::scope phase{ statistics_, "collect functions", "codegen" };
+            collector.walk(mod_->body);
+            phase.set_nodes(collector.collected_functions.size() + collector.collected_extern_functions.size());
+        }
+
+        std::vector<partition> partitions;
+        {
+            utils::statistics::scope phase{ statistics_, "compile functions", "codegen" };
+            partitions = compile_partitions(collector.collected_functions, partition_size_, [](code_generation& generator)
+            {
+                // Optimised by the generator which made it, as target machines are not thread safe either.
+                generator.optimize(*generator.llvm_module);
+                return partition{ std::move(generator.context_), std::move(generator.llvm_module) };
+            });
+            phase.set_nodes(collector.collected_functions.size());
+        }
+
+        // The entry function calls constructors from every partition, so it gets a partition of its own.
+        utils::statistics::scope phase{ statistics_, "entry function", "codegen" };
+        code_generation generator{ mod_, nullptr, nullptr, partition_size_, level_, locals_, program_ };
+        generator.partitioned_ = true;
+        generator.compile_entry_function(collector);
+        generator.optimize(*generator.llvm_module);
+        partitions.push_back(partition{ std::move(generator.context_), std::move(generator.llvm_module) });
+
+        return partitions;
+    }
+
+    std::shared_ptr<llvm::Module> code_generation::generate_program_entry(const std::vector<std::string>& modules)
+    {
+        utils::statistics::scope phase{ statistics_, "program entry", "codegen" };
+        compile_program_entry(modules);
 
         std::string error;
         llvm::raw_string_ostream error_stream{ error };
         if (llvm::verifyModule(*llvm_module, &error_stream))
         {
-	       //throw std::runtime_error(error);
+            throw utils::compiler_exception{ { 0, 0 }, "internal compiler error: " + error_stream.str() };
         }
-		
-        return llvm_module;
+
+        optimize(*llvm_module);
+        phase.set_nodes(modules.size());
+
+        // Owned by this generator, so it can still be released.
+        return std::shared_ptr<llvm::Module>{ std::shared_ptr<llvm::Module>{}, llvm_module.get() };
+    }
+
+    void code_generation::add_configuration(cache_key& key) const
+    {
+        key.add(cache_format).add(SEAM_VERSION).add(LLVM_VERSION_STRING);
+        key.add(target_machine_->getTargetTriple().str()).add(target_machine_->getTargetCPU());
+        key.add(static_cast<std::uint64_t>(level_)).add(static_cast<std::uint64_t>(locals_));
+    }
+
+    std::string code_generation::configuration_key() const
+    {
+        cache_key key;
+        add_configuration(key);
+        return key.finish();
+    }
+
+    std::string code_generation::function_cache_key(ir::ast::statement::function_definition* func) const
+    {
+        cache_key key;
+        add_configuration(key);
+
+        ast_hasher hasher{ key, mod_->symbols };
+        hasher.walk(func);
+        return key.finish();
+    }
+
+    std::string code_generation::module_cache_key(const std::string_view source, const llvm::CodeGenFileType file_type) const
+    {
+        cache_key key;
+        add_configuration(key);
+        key.add(static_cast<std::uint64_t>(file_type)).add(mod_->name).add(static_cast<std::uint64_t>(program_)).add(source);
+
+        // Calls into a dependency are compiled from the signatures of its functions, not from its source.
+        key.add(mod_->dependencies.size());
+        for (const auto& dependency : mod_->dependencies)
+        {
+            function_collector collector;
+            collector.walk(dependency->body);
+
+            key.add(dependency->name);
+            key.add(collector.collected_functions.size()).add(collector.collected_extern_functions.size());
+            for (const auto func : collector.collected_functions)
+            {
+                add_signature(key, dependency->symbols, func->signature);
+            }
+            for (const auto func : collector.collected_extern_functions)
+            {
+                add_signature(key, dependency->symbols, func->signature);
+            }
+        }
+        return key.finish();
+    }
+
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> code_generation::generate_objects(compilation_cache* cache, function_keys* keys)
+    {
+        function_collector collector;
+        {
+            utils::statistics::scope phase{ statistics_, "collect functions", "codegen" };
+            collector.walk(mod_->body);
+            phase.set_nodes(collector.collected_functions.size() + collector.collected_extern_functions.size());
+        }
+
+        const auto& functions = collector.collected_functions;
+        std::vector<std::unique_ptr<llvm::MemoryBuffer>> objects(functions.size());
+        std::vector<std::string> cache_keys;
+        std::vector<ir::ast::statement::function_definition*> missing;
+        std::vector<std::size_t> missing_indices;
+        {
+            utils::statistics::scope phase{ statistics_, "look up cached functions", "codegen" };
+            for (std::size_t i = 0; i < functions.size(); ++i)
+            {
+                if (cache)
+                {
+                    const auto known = keys ? keys->find(functions[i]) : function_keys::iterator{};
+                    const auto is_known = keys && known != keys->end();
+                    cache_keys.push_back(is_known ? known->second : function_cache_key(functions[i]));
+                    objects[i] = cache->load(cache_keys.back());
+
+                    // Known functions may not have been analysed, so they cannot be compiled.
+                    if (is_known && !objects[i])
+                    {
+                        throw std::runtime_error("cache entry " + cache_keys.back() + " of function "
+                            + std::string{ mod_->symbols.name(functions[i]->signature->mangled_name) } + " is gone");
+                    }
+
+                    if (keys)
+                    {
+                        keys->insert_or_assign(functions[i], cache_keys.back());
+                    }
+                }
+
+                if (!objects[i])
+                {
+                    missing.push_back(functions[i]);
+                    missing_indices.push_back(i);
+                }
+            }
+            phase.set_nodes(functions.size() - missing.size());
+        }
+
+        // A function at a time, so each object can be reused whatever else changes.
+        std::vector<llvm::SmallVector<char, 0>> compiled;
+        {
+            utils::statistics::scope phase{ statistics_, "compile functions", "codegen" };
+            compiled = compile_partitions(missing, 1, [](code_generation& generator)
+            {
+                generator.optimize(*generator.llvm_module);
+
+                llvm::SmallVector<char, 0> object;
+                llvm::raw_svector_ostream stream{ object };
+                generator.emit(*generator.llvm_module, stream);
+                return object;
+            });
+            phase.set_nodes(missing.size());
+        }
+
+        {
+            utils::statistics::scope phase{ statistics_, "store compiled functions", "codegen" };
+            for (std::size_t i = 0; i < missing.size(); ++i)
+            {
+                const auto index = missing_indices[i];
+                const llvm::StringRef object{ compiled[i].data(), compiled[i].size() };
+                if (cache)
+                {
+                    cache->store(cache_keys[index], object);
+                }
+                objects[index] = llvm::MemoryBuffer::getMemBufferCopy(object, mod_->symbols.name(functions[index]->signature->mangled_name));
+            }
+            phase.set_nodes(missing.size());
+        }
+
+        // Calls every constructor by name, so it is cheap enough to compile every time.
+        utils::statistics::scope phase{ statistics_, "entry function", "codegen" };
+        code_generation generator{ mod_, nullptr, nullptr, partition_size_, level_, locals_, program_ };
+        generator.partitioned_ = true;
+        generator.compile_entry_function(collector);
+
+        llvm::SmallVector<char, 0> object;
+        llvm::raw_svector_ostream stream{ object };
+        generator.emit(*generator.llvm_module, stream);
+        objects.push_back(llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef{ object.data(), object.size() }, "entry"));
+
+        return objects;
+    }
+
+    partition code_generation::release()
+    {
+        return partition{ std::move(context_), std::move(llvm_module) };
+    }
+
+    void code_generation::emit(llvm::Module& module, llvm::raw_pwrite_stream& stream, const llvm::CodeGenFileType file_type)
+    {
+        utils::statistics::scope phase{ statistics_, file_type == llvm::CGFT_AssemblyFile ? "emit assembly" : "emit object", "codegen" };
+
+        llvm::legacy::PassManager passes;
+        if (target_machine_->addPassesToEmitFile(passes, stream, nullptr, file_type))
+        {
+            throw std::runtime_error("internal compiler error: target cannot emit this kind of file");
+        }
+
+        passes.run(module);
+        phase.set_nodes(module.size());
     }
-}
+}
\ No newline at end of file
@@ -2,46 +2,328 @@
 
 #include <llvm/IR/Module.h>
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/Support/CodeGen.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
 
+#include "compilation_cache.hpp"
+#include "dependency_graph.hpp"
 #include "../ir/ast/statement.hpp"
 #include "../types/module.hpp"
+#include "../utils/statistics.hpp"
+#include "../utils/thread_pool.hpp"
 
+#include <cstddef>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace seam::code_generation
 {
+    struct function_collector;
+
+    /**
+     * How much generated code is optimised, matching the -O flags of other compilers.
+     */
+    enum class optimization_level
+    {
+        o0, // none, for the fastest compilation
+        o1,
+        o2,
+        o3,
+        os, // as o2, but favouring smaller code
+    };
+
+    /**
+     * Where local variables and parameters are kept in generated code.
+     */
+    enum class local_storage
+    {
+        stack, // a slot each in the entry block, left for the optimiser to promote to registers
+        ssa, // registers, joined by phi nodes built while generating code, so even o0 output keeps locals out of memory
+    };
+
+    /**
+     * Registers the target of the host, once however many threads call it.
+     */
+    void initialize_native_target();
+
+    /**
+     * Returns how much the backend optimises at an optimisation level.
+     *
+     * @param level optimisation level.
+     * @returns backend optimisation level.
+     */
+    llvm::CodeGenOpt::Level codegen_opt_level(optimization_level level);
+
+    /**
+     * Adds a signature to a cache key, everything a call to the function depends on.
+     *
+     * @param key key to add to.
+     * @param symbols symbols of the module of the function.
+     * @param signature signature to add.
+     */
+    void add_signature(cache_key& key, const utils::interner& symbols, ir::ast::expression::function_signature* signature);
+
+    /**
+     * Part of a module compiled on its own thread, into a context of its own.
+     *
+     * Functions defined in other partitions are declared and linked to
+     * externally, so each partition can be emitted as an object by itself.
+     */
+    struct partition
+    {
+        std::unique_ptr<llvm::LLVMContext> context;
+        std::unique_ptr<llvm::Module> module; // declared after context, so destroyed before it
+    };
+
     class code_generation
     {
-        llvm::LLVMContext context_;
+        std::unique_ptr<llvm::LLVMContext> context_;
+        std::unique_ptr<llvm::TargetMachine> target_machine_;
 
-        std::shared_ptr<llvm::Module> llvm_module;
+        std::unique_ptr<llvm::Module> llvm_module;
         std::unique_ptr<llvm::DataLayout> data_layout;
 
         types::module* mod_;
+        utils::statistics* statistics_;
+        utils::thread_pool* pool_;
+        std::size_t partition_size_;
+        optimization_level level_;
+        local_storage locals_;
+        bool program_; // the module is a whole program, so it also defines the entry the program starts from
+        bool partitioned_ = false; // compiling a partition, so functions are linked externally
 
-        std::vector<llvm::Function*> constructor_functions;
-        std::unordered_map<std::string, llvm::FunctionType*> function_type_map;
+        std::unordered_map<utils::symbol_id, llvm::FunctionType*> function_type_map;
     	
         llvm::Type* size_type;
 
         
         llvm::FunctionType* get_llvm_function_type(utils::position position, ir::ast::expression::function_signature* signature);
 
+        /**
+         * Returns the name of a function in generated code.
+         *
+         * Extern and exported functions keep their name from the source, so
+         * other modules can link to them, the rest are mangled.
+         *
+         * @param signature signature of the function.
+         * @returns name of the function.
+         */
+        std::string_view function_name(ir::ast::expression::function_signature* signature) const;
+
         
     	void compile_function(ir::ast::statement::function_definition* func);
         void compile_extern_function(ir::ast::statement::extern_function_definition* func);
 
+        /**
+         * Creates the entry function of the module, which calls every constructor in source order.
+         *
+         * If the module is a whole program, the entry of the program is
+         * created too, which calls the entry of the module.
+         *
+         * @param collector functions of the module.
+         */
+        void compile_entry_function(const function_collector& collector);
+
+        /**
+         * Creates the entry of a program, which calls the entry function of each of its modules in turn.
+         *
+         * @param modules names of the modules of the program, each after every module it imports.
+         */
+        void compile_program_entry(const std::vector<std::string>& modules);
+
+        /**
+         * Compiles functions in partitions, on the pool if there is one.
+         *
+         * May be called from a task of the pool, which runs partitions itself while it waits for them.
+         *
+         * @param functions functions to compile.
+         * @param partition_size number of functions compiled together in one partition.
+         * @param make_result turns the generator of a compiled partition into the result of its task, on the thread which compiled it.
+         * @returns result of every partition, in source order.
+         */
+        template <typename MakeResult>
+        auto compile_partitions(const std::vector<ir::ast::statement::function_definition*>& functions, std::size_t partition_size,
+            MakeResult make_result);
+
+        /**
+         * Adds everything besides the source which changes the generated code to a cache key.
+         *
+         * @param key key to add to.
+         */
+        void add_configuration(cache_key& key) const;
+
+        /**
+         * Returns the cache key of a function, which changes with its tree and the signatures of the functions it calls.
+         *
+         * @param func function to find the key of.
+         * @returns key of the function.
+         */
+        std::string function_cache_key(ir::ast::statement::function_definition* func) const;
+
+        /**
+         * Creates a target machine for the host, registering the native target the first time.
+         *
+         * @returns target machine.
+         */
+        static std::unique_ptr<llvm::TargetMachine> create_target_machine(optimization_level level);
+
+        /**
+         * Runs the optimisation pipeline of the optimisation level on a module.
+         *
+         * @param module module to optimise, from this generator.
+         */
+        void optimize(llvm::Module& module);
+
     public:
-        code_generation(types::module* mod) :
-			llvm_module(std::make_shared<llvm::Module>(mod->name, context_)),
-    		data_layout(std::make_unique<llvm::DataLayout>(llvm_module.get())),
+        // Functions compiled together in one partition, fixed so the output does not depend on the number of threads.
+        static constexpr std::size_t default_partition_size = 256;
+
+        /**
+         * Prepares to generate a module.
+         *
+         * @param mod module to generate.
+         * @param statistics statistics to record phases in, optional.
+         * @param pool pool to compile partitions of the module on, optional.
+         * @param partition_size number of functions compiled together on one thread.
+         * @param level how much to optimise the generated code.
+         * @param locals where to keep local variables.
+         * @param program whether the module is a whole program, rather than one of several linked together.
+         */
+        code_generation(types::module* mod, utils::statistics* statistics = nullptr, utils::thread_pool* pool = nullptr,
+            std::size_t partition_size = default_partition_size, optimization_level level = optimization_level::o0,
+            local_storage locals = local_storage::stack, bool program = true) :
+            context_(std::make_unique<llvm::LLVMContext>()),
+            target_machine_(create_target_machine(level)),
+			llvm_module(std::make_unique<llvm::Module>(mod->name, *context_)),
+    		data_layout(std::make_unique<llvm::DataLayout>(target_machine_->createDataLayout())),
     		mod_(mod),
-            size_type(llvm::Type::getIntNTy(context_, data_layout->getMaxPointerSizeInBits()))
-        {}
+    		statistics_(statistics),
+    		pool_(pool),
+    		partition_size_(partition_size == 0 ? 1 : partition_size),
+    		level_(level),
+    		locals_(locals),
+    		program_(program),
+            size_type(llvm::Type::getIntNTy(*context_, data_layout->getPointerSizeInBits()))
+        {
+            llvm_module->setTargetTriple(target_machine_->getTargetTriple().str());
+            llvm_module->setDataLayout(*data_layout);
+        }
 
         llvm::Type* get_llvm_type(ir::ast::type* t);
+
+        /**
+         * Returns the name of the entry function of a module, mangled like the other functions of the module.
+         *
+         * @param module name of the module.
+         * @returns name of the entry function.
+         */
+        static std::string entry_name(std::string_view module);
+
+        /**
+         * Returns where local variables are kept.
+         *
+         * @returns storage of locals.
+         */
+        [[nodiscard]] local_storage locals() const
+        {
+            return locals_;
+        }
+
+        /**
+         * Generates the module.
+         *
+         * With a pool of more than one thread, large modules are compiled in
+         * partitions which are then linked together. The result is the same
+         * as compiling the module on one thread. The linked module is then
+         * optimised as a whole.
+         *
+         * @returns generated module, which lives as long as this generator.
+         */
         std::shared_ptr<llvm::Module> generate();
+
+        /**
+         * Generates the module in partitions, without linking them together.
+         *
+         * Partitions hold partition_size functions each, in source order,
+         * followed by one holding the entry function. They are the same
+         * whatever the number of threads. Each is optimised on the thread
+         * which compiled it, so calls between partitions are not inlined.
+         *
+         * @returns every partition.
+         */
+        std::vector<partition> generate_partitions();
+
+        /**
+         * Generates the entry of a program made of several modules, each generated as a part of a program.
+         *
+         * The entry calls the entry function of each module in turn, so
+         * the constructors of a module run after those of every module it
+         * imports. Only the entry of the program is generated, the module
+         * this generator was made for is not.
+         *
+         * @param modules names of the modules of the program, each after every module it imports.
+         * @returns generated module, which lives as long as this generator.
+         */
+        std::shared_ptr<llvm::Module> generate_program_entry(const std::vector<std::string>& modules);
+
+        /**
+         * Generates an object for every function of the module, followed by one for the entry function.
+         *
+         * Functions are compiled on their own, so none is inlined into
+         * another, and objects of functions whose key is in the cache are
+         * reused without compiling them again. Objects refer to each other
+         * by name, so they are linked together, by the JIT for instance.
+         *
+         * Functions whose key is already in keys are not hashed, so they do
+         * not have to be analysed, but their object must be in the cache.
+         *
+         * @param cache cache to reuse and store objects of functions in, optional.
+         * @param keys keys of functions known already, filled in with the key of every other function, used with a cache only.
+         * @returns every object.
+         */
+        std::vector<std::unique_ptr<llvm::MemoryBuffer>> generate_objects(compilation_cache* cache = nullptr, function_keys* keys = nullptr);
+
+        /**
+         * Returns the key of everything besides the source which changes the generated code.
+         *
+         * @returns key of the configuration.
+         */
+        std::string configuration_key() const;
+
+        /**
+         * Returns the cache key of whatever the module compiles to.
+         *
+         * The key changes with the source, the compiler, the options code
+         * is generated with, and the signatures of the functions of every
+         * module the module depends on.
+         *
+         * @param source source the module was parsed from.
+         * @param file_type kind of file the module is compiled to.
+         * @returns key of the module.
+         */
+        std::string module_cache_key(std::string_view source, llvm::CodeGenFileType file_type) const;
+
+        /**
+         * Hands the generated module over along with its context, for it to outlive this generator.
+         *
+         * @returns the module generated by generate, after which this generator cannot be used.
+         */
+        partition release();
+
+        /**
+         * Compiles a generated module for the host and writes it out, without leaving the process.
+         *
+         * @param module module to compile, from this generator or one of its partitions.
+         * @param stream stream to write to, which should be buffered.
+         * @param file_type whether to write an object or assembly.
+         */
+        void emit(llvm::Module& module, llvm::raw_pwrite_stream& stream, llvm::CodeGenFileType file_type = llvm::CGFT_ObjectFile);
+
     	llvm::Function* get_or_declare_function(utils::position position, ir::ast::expression::function_signature* signature);
     };
 }
\ No newline at end of file
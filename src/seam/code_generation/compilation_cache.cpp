@@ -0,0 +1,76 @@
+#include "compilation_cache.hpp"
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <stdexcept>
+#include <utility>
+
+namespace seam::code_generation
+{
+	compilation_cache::compilation_cache(std::string directory) :
+		directory_(std::move(directory))
+	{
+		if (const auto error = llvm::sys::fs::create_directories(directory_))
+		{
+			throw std::runtime_error("cannot create cache directory '" + directory_ + "': " + error.message());
+		}
+	}
+
+	std::unique_ptr<llvm::MemoryBuffer> compilation_cache::load(const std::string& key)
+	{
+		llvm::SmallString<128> path{ directory_ };
+		llvm::sys::path::append(path, key);
+
+		auto entry = llvm::MemoryBuffer::getFile(path, false, false);
+		if (!entry)
+		{
+			misses_.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		hits_.fetch_add(1, std::memory_order_relaxed);
+		return std::move(*entry);
+	}
+
+	bool compilation_cache::contains(const std::string& key) const
+	{
+		llvm::SmallString<128> path{ directory_ };
+		llvm::sys::path::append(path, key);
+		return !key.empty() && llvm::sys::fs::exists(path);
+	}
+
+	void compilation_cache::store(const std::string& key, const llvm::StringRef contents)
+	{
+		llvm::SmallString<128> path{ directory_ };
+		llvm::sys::path::append(path, key);
+
+		llvm::SmallString<128> temporary_path{ directory_ };
+		llvm::sys::path::append(temporary_path, key + ".%%%%%%.tmp");
+
+		int fd;
+		if (const auto error = llvm::sys::fs::createUniqueFile(temporary_path, fd, temporary_path))
+		{
+			throw std::runtime_error("cannot write to cache directory '" + directory_ + "': " + error.message());
+		}
+
+		{
+			llvm::raw_fd_ostream stream{ fd, true };
+			stream << contents;
+			stream.close();
+			if (stream.has_error())
+			{
+				stream.clear_error();
+				llvm::sys::fs::remove(temporary_path);
+				throw std::runtime_error("cannot write cache entry " + key);
+			}
+		}
+
+		if (const auto error = llvm::sys::fs::rename(temporary_path, path))
+		{
+			llvm::sys::fs::remove(temporary_path);
+			throw std::runtime_error("cannot write cache entry " + key + ": " + error.message());
+		}
+	}
+}
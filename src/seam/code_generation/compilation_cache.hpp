@@ -0,0 +1,133 @@
+#pragma once
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA1.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace seam::code_generation
+{
+	/**
+	 * Hash of everything a piece of compiled code was compiled from.
+	 *
+	 * Values are added in a fixed order, and strings with their length, so
+	 * different inputs cannot run together into the same bytes.
+	 */
+	class cache_key
+	{
+		llvm::SHA1 hash_;
+
+	public:
+		/**
+		 * Adds a number to the key.
+		 *
+		 * @param value number to add.
+		 * @returns this key.
+		 */
+		cache_key& add(const std::uint64_t value)
+		{
+			std::uint8_t bytes[sizeof(value)];
+			for (std::size_t i = 0; i < sizeof(value); ++i)
+			{
+				bytes[i] = static_cast<std::uint8_t>(value >> (i * 8));
+			}
+			hash_.update(llvm::ArrayRef<std::uint8_t>{ bytes });
+			return *this;
+		}
+
+		/**
+		 * Adds a string to the key.
+		 *
+		 * @param bytes string to add.
+		 * @returns this key.
+		 */
+		cache_key& add(const llvm::StringRef bytes)
+		{
+			add(bytes.size());
+			hash_.update(bytes);
+			return *this;
+		}
+
+		/**
+		 * Finishes the key, after which nothing more can be added.
+		 *
+		 * @returns key in hexadecimal, usable as a file name.
+		 */
+		std::string finish()
+		{
+			return llvm::toHex(hash_.final(), true);
+		}
+	};
+
+	/**
+	 * Compiled code kept in a directory on disk, under the key of what it was compiled from.
+	 *
+	 * Entries are written to a temporary file which is then renamed into
+	 * place, so compilers sharing a cache, or threads sharing one of these,
+	 * never read an entry that is partly written.
+	 */
+	class compilation_cache
+	{
+		std::string directory_;
+		std::atomic<std::size_t> hits_{ 0 };
+		std::atomic<std::size_t> misses_{ 0 };
+
+	public:
+		/**
+		 * Opens a cache, creating its directory if it does not exist.
+		 *
+		 * @param directory directory holding the entries.
+		 */
+		explicit compilation_cache(std::string directory);
+
+		/**
+		 * Reads an entry.
+		 *
+		 * @param key key of the entry.
+		 * @returns contents of the entry, or null if there is none.
+		 */
+		std::unique_ptr<llvm::MemoryBuffer> load(const std::string& key);
+
+		/**
+		 * Returns whether there is an entry, without reading it or counting it as a hit or a miss.
+		 *
+		 * @param key key of the entry.
+		 * @returns whether the entry exists.
+		 */
+		[[nodiscard]] bool contains(const std::string& key) const;
+
+		/**
+		 * Writes an entry, replacing any entry with the same key.
+		 *
+		 * @param key key of the entry.
+		 * @param contents contents of the entry.
+		 */
+		void store(const std::string& key, llvm::StringRef contents);
+
+		/**
+		 * Returns the number of entries found so far.
+		 *
+		 * @returns number of hits.
+		 */
+		[[nodiscard]] std::size_t hits() const
+		{
+			return hits_.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * Returns the number of entries looked for but not found so far.
+		 *
+		 * @returns number of misses.
+		 */
+		[[nodiscard]] std::size_t misses() const
+		{
+			return misses_.load(std::memory_order_relaxed);
+		}
+	};
+}
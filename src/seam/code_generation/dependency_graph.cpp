@@ -0,0 +1,197 @@
+#include "dependency_graph.hpp"
+#include "code_generation.hpp"
+#include "../ir/ast/walker.hpp"
+
+#include <llvm/ADT/SmallVector.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace
+{
+	using namespace seam;
+
+	// Raised whenever what is written changes, so graphs written by other versions are ignored.
+	constexpr std::uint64_t graph_format = 1;
+
+	/**
+	 * Finds every function of a tree, with a body or not.
+	 */
+	struct signature_finder : ir::ast::walker<signature_finder>
+	{
+		std::vector<ir::ast::statement::function_definition*> functions;
+		std::vector<ir::ast::expression::function_signature*> signatures;
+
+		using walker::visit;
+
+		bool visit(ir::ast::statement::extern_function_definition* node)
+		{
+			signatures.push_back(node->signature);
+			return false;
+		}
+
+		bool visit(ir::ast::statement::function_definition* node)
+		{
+			functions.push_back(node);
+			signatures.push_back(node->signature);
+			return false;
+		}
+	};
+}
+
+namespace seam::code_generation
+{
+	dependency_graph dependency_graph::read(const llvm::StringRef contents)
+	{
+		// Fields are separated by tabs, and records by new lines.
+		llvm::SmallVector<llvm::StringRef, 0> lines;
+		contents.split(lines, '\n', -1, false);
+		if (lines.size() < 2 || lines[0] != "seam-dependency-graph\t" + std::to_string(graph_format))
+		{
+			return {};
+		}
+
+		dependency_graph graph;
+		for (const auto line : lines)
+		{
+			llvm::SmallVector<llvm::StringRef, 8> fields;
+			line.split(fields, '\t');
+
+			if (fields[0] == "configuration" && fields.size() == 2)
+			{
+				graph.configuration_ = fields[1].str();
+			}
+			else if (fields[0] == "signature" && fields.size() == 3)
+			{
+				graph.signatures_.insert_or_assign(fields[1].str(), fields[2].str());
+			}
+			else if (fields[0] == "function" && fields.size() >= 4)
+			{
+				auto& func = graph.functions_[fields[1].str()];
+				func.source_hash = fields[2].str();
+				func.object_key = fields[3].str();
+				for (auto i = fields.begin() + 4; i != fields.end(); ++i)
+				{
+					func.dependencies.push_back(i->str());
+				}
+			}
+			else if (fields[0] != "seam-dependency-graph")
+			{
+				return {};
+			}
+		}
+		return graph;
+	}
+
+	std::string dependency_graph::write() const
+	{
+		std::string contents = "seam-dependency-graph\t" + std::to_string(graph_format) + '\n';
+		contents += "configuration\t" + configuration_ + '\n';
+
+		// Sorted, so the same graph is always written the same way.
+		std::vector<std::pair<std::string, std::string>> signatures{ signatures_.cbegin(), signatures_.cend() };
+		std::sort(signatures.begin(), signatures.end());
+		for (const auto& [name, hash] : signatures)
+		{
+			contents += "signature\t" + name + '\t' + hash + '\n';
+		}
+
+		std::vector<const std::pair<const std::string, function>*> functions;
+		for (const auto& entry : functions_)
+		{
+			functions.push_back(&entry);
+		}
+		std::sort(functions.begin(), functions.end(), [](const auto left, const auto right) { return left->first < right->first; });
+		for (const auto entry : functions)
+		{
+			contents += "function\t" + entry->first + '\t' + entry->second.source_hash + '\t' + entry->second.object_key;
+			for (const auto& dependency : entry->second.dependencies)
+			{
+				contents += '\t' + dependency;
+			}
+			contents += '\n';
+		}
+		return contents;
+	}
+
+	std::string dependency_graph::cache_entry(const std::string_view module_name)
+	{
+		return std::string{ module_name } + ".graph";
+	}
+
+	std::vector<ir::ast::statement::function_definition*> dependency_graph::update(ir::ast::statement::restricted_block* root,
+		const std::string_view source, const utils::interner& symbols, const std::string& configuration, const compilation_cache& cache,
+		function_keys& keys)
+	{
+		signature_finder finder;
+		finder.walk(root);
+
+		std::unordered_map<std::string, std::string> signatures;
+		for (const auto signature : finder.signatures)
+		{
+			cache_key key;
+			add_signature(key, symbols, signature);
+			signatures.insert_or_assign(std::string{ symbols.name(signature->mangled_name) }, key.finish());
+		}
+
+		// Nothing compiled with other options can be reused.
+		if (configuration != configuration_)
+		{
+			functions_.clear();
+		}
+
+		// A callee whose signature changed is called differently, one which is gone is an error to report.
+		const auto signature_changed = [&](const std::string& name)
+		{
+			const auto before = signatures_.find(name);
+			const auto after = signatures.find(name);
+			return before == signatures_.cend() || after == signatures.cend() || before->second != after->second;
+		};
+
+		std::vector<ir::ast::statement::function_definition*> changed;
+		std::unordered_map<std::string, function> functions;
+		for (const auto func : finder.functions)
+		{
+			// Whitespace after a function is left out, so adding lines between functions changes neither.
+			const auto text = llvm::StringRef{ source.data() + func->range.start.offset,
+				func->range.end.offset - func->range.start.offset }.rtrim();
+			auto source_hash = cache_key{}.add(text).finish();
+
+			auto name = std::string{ symbols.name(func->signature->mangled_name) };
+			const auto recorded = functions_.find(name);
+			if (recorded != functions_.cend() && recorded->second.source_hash == source_hash && cache.contains(recorded->second.object_key)
+				&& std::none_of(recorded->second.dependencies.cbegin(), recorded->second.dependencies.cend(), signature_changed))
+			{
+				keys.insert_or_assign(func, recorded->second.object_key);
+				functions.emplace(std::move(name), std::move(recorded->second));
+				continue;
+			}
+
+			changed.push_back(func);
+			functions.insert_or_assign(std::move(name), function{ std::move(source_hash), {}, {} });
+		}
+
+		configuration_ = configuration;
+		signatures_ = std::move(signatures);
+		functions_ = std::move(functions);
+		return changed;
+	}
+
+	void dependency_graph::record(const std::vector<ir::ast::statement::function_definition*>& functions, const utils::interner& symbols,
+		const function_keys& keys)
+	{
+		for (const auto func : functions)
+		{
+			auto& recorded = functions_[std::string{ symbols.name(func->signature->mangled_name) }];
+			recorded.object_key = keys.at(func);
+
+			recorded.dependencies.clear();
+			for (const auto dependency : func->function_dependencies)
+			{
+				recorded.dependencies.emplace_back(symbols.name(dependency->mangled_name));
+			}
+			std::sort(recorded.dependencies.begin(), recorded.dependencies.end());
+		}
+	}
+}
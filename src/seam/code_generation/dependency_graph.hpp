@@ -0,0 +1,105 @@
+#pragma once
+
+#include <llvm/ADT/StringRef.h>
+
+#include "compilation_cache.hpp"
+#include "../ir/ast/statement.hpp"
+#include "../utils/interner.hpp"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace seam::code_generation
+{
+	// Cache key of the object of each function, see code_generation::generate_objects.
+	using function_keys = std::unordered_map<ir::ast::statement::function_definition*, std::string>;
+
+	/**
+	 * Functions of a module as they were when it was last compiled, and the functions each of them calls.
+	 *
+	 * Kept in the compilation cache between runs, so that once a module has
+	 * been parsed, only the functions whose source changed, and those calling
+	 * a function whose signature changed, are analysed and compiled again.
+	 * The objects of the others are reused by the keys recorded for them.
+	 */
+	class dependency_graph
+	{
+		struct function
+		{
+			std::string source_hash; // hash of the source of the function
+			std::string object_key; // cache key of the object of the function
+			std::vector<std::string> dependencies; // mangled names of the functions it calls
+		};
+
+		std::string configuration_; // key of everything but the source which code was generated from
+		std::unordered_map<std::string, std::string> signatures_; // hash of the signature of every function, by mangled name
+		std::unordered_map<std::string, function> functions_; // every function with a body, by mangled name
+
+	public:
+		/**
+		 * Reads a graph written by write.
+		 *
+		 * @param contents contents written by write.
+		 * @returns the graph, or an empty one if the contents are from another version or damaged.
+		 */
+		static dependency_graph read(llvm::StringRef contents);
+
+		/**
+		 * Writes the graph, to be read back by read.
+		 *
+		 * @returns contents of the graph.
+		 */
+		[[nodiscard]] std::string write() const;
+
+		/**
+		 * Returns the name the graph of a module is kept under in a compilation cache.
+		 *
+		 * @param module_name name of the module.
+		 * @returns name of the cache entry.
+		 */
+		static std::string cache_entry(std::string_view module_name);
+
+		/**
+		 * Brings the graph up to date with a module which has just been parsed, before it is analysed.
+		 *
+		 * A function is compiled again when it is new, its source changed,
+		 * a function it called has a different signature or is gone, or its
+		 * object is no longer in the cache. Everything is compiled again when
+		 * the configuration changed. Functions which are not keep what was
+		 * recorded for them, the others have to be recorded again once they
+		 * are compiled.
+		 *
+		 * @param root root of the module, as parsed.
+		 * @param source source the module was parsed from.
+		 * @param symbols symbols of the module.
+		 * @param configuration key of everything but the source which code is generated from, see code_generation::configuration_key.
+		 * @param cache cache holding the objects of the functions.
+		 * @param keys filled in with the object key of every function which is not compiled again.
+		 * @returns functions to analyse and compile again, in source order.
+		 */
+		std::vector<ir::ast::statement::function_definition*> update(ir::ast::statement::restricted_block* root, std::string_view source,
+			const utils::interner& symbols, const std::string& configuration, const compilation_cache& cache, function_keys& keys);
+
+		/**
+		 * Records the functions compiled again after update, once they have been analysed and compiled.
+		 *
+		 * @param functions functions returned by update.
+		 * @param symbols symbols of the module.
+		 * @param keys object key of every function, as filled in by code_generation::generate_objects.
+		 */
+		void record(const std::vector<ir::ast::statement::function_definition*>& functions, const utils::interner& symbols,
+			const function_keys& keys);
+
+		/**
+		 * Returns the number of functions with a body in the graph.
+		 *
+		 * @returns number of functions.
+		 */
+		[[nodiscard]] std::size_t size() const
+		{
+			return functions_.size();
+		}
+	};
+}
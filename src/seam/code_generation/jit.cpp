@@ -0,0 +1,110 @@
+#include "jit.hpp"
+
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/Support/ErrorHandling.h>
+
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+	/**
+	 * Throws an error from the JIT as an exception.
+	 *
+	 * @param error error, if any.
+	 * @param message what was being done.
+	 */
+	void check(llvm::Error error, const std::string& message)
+	{
+		if (error)
+		{
+			throw std::runtime_error(message + ": " + llvm::toString(std::move(error)));
+		}
+	}
+
+	template <typename T>
+	T check(llvm::Expected<T> value, const std::string& message)
+	{
+		check(value.takeError(), message);
+		return std::move(*value);
+	}
+
+	// Called in place of a function which could not be compiled when it was first called. Generated code cannot
+	// be unwound through, so the error, which the JIT has already reported, cannot be thrown.
+	[[noreturn]] void lazy_compile_failed()
+	{
+		llvm::report_fatal_error("cannot compile function called by JIT code");
+	}
+}
+
+namespace seam::code_generation
+{
+	jit::jit(const optimization_level level, const bool lazy, utils::statistics* statistics) :
+		statistics_(statistics),
+		lazy_(lazy)
+	{
+		initialize_native_target();
+
+		auto target = check(llvm::orc::JITTargetMachineBuilder::detectHost(), "cannot run code on this machine");
+		target.setCodeGenOptLevel(codegen_opt_level(level));
+
+		jit_ = check(llvm::orc::LLLazyJITBuilder{}
+			.setJITTargetMachineBuilder(std::move(target))
+			.setLazyCompileFailureAddr(llvm::pointerToJITTargetAddress(&lazy_compile_failed))
+			.create(), "cannot create JIT");
+
+		auto process_symbols = check(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+			jit_->getDataLayout().getGlobalPrefix()), "cannot search the symbols of the process");
+		jit_->getMainJITDylib().addGenerator(std::move(process_symbols));
+	}
+
+	void jit::define(const std::string& name, void* address)
+	{
+		const llvm::JITEvaluatedSymbol symbol{ llvm::pointerToJITTargetAddress(address),
+			llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable };
+		check(jit_->getMainJITDylib().define(llvm::orc::absoluteSymbols({ { jit_->mangleAndIntern(name), symbol } })),
+			"cannot define " + name);
+	}
+
+	void jit::add(partition generated)
+	{
+		utils::statistics::scope phase{ statistics_, "add module", "jit" };
+		phase.set_nodes(generated.module->size());
+
+		llvm::orc::ThreadSafeModule module{ std::move(generated.module), std::move(generated.context) };
+		if (lazy_)
+		{
+			check(jit_->addLazyIRModule(std::move(module)), "cannot add module");
+		}
+		else
+		{
+			check(jit_->addIRModule(std::move(module)), "cannot add module");
+		}
+	}
+
+	void jit::add_object(std::unique_ptr<llvm::MemoryBuffer> object)
+	{
+		utils::statistics::scope phase{ statistics_, "add object", "jit" };
+		check(jit_->addObjectFile(std::move(object)), "cannot add object");
+	}
+
+	void* jit::lookup(const std::string& name)
+	{
+		const auto symbol = check(jit_->lookup(name), "cannot find " + name);
+		return llvm::jitTargetAddressToPointer<void*>(symbol.getAddress());
+	}
+
+	void jit::run()
+	{
+		void* entry;
+		{
+			// Compiles the whole module unless it was added lazily.
+			utils::statistics::scope phase{ statistics_, "look up entry", "jit" };
+			entry = lookup("entry");
+		}
+
+		utils::statistics::scope phase{ statistics_, "run", "jit" };
+		reinterpret_cast<void (*)()>(entry)();
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+
+#include "code_generation.hpp"
+#include "../utils/statistics.hpp"
+
+#include <memory>
+#include <string>
+
+namespace seam::code_generation
+{
+	/**
+	 * Runs generated modules in the compiler's own process.
+	 *
+	 * Extern functions resolve to the symbols given to define first, then to
+	 * those of the process, such as the C library. Modules added lazily are
+	 * compiled a function at a time, the first time each function is called,
+	 * so a program starts running before the rest of it has been compiled.
+	 */
+	class jit
+	{
+		std::unique_ptr<llvm::orc::LLLazyJIT> jit_;
+		utils::statistics* statistics_;
+		bool lazy_;
+
+	public:
+		/**
+		 * Creates a JIT for the host.
+		 *
+		 * @param level how much the backend optimises, modules are optimised before they are added.
+		 * @param lazy whether functions are compiled the first time they are called, rather than with their module.
+		 * @param statistics statistics to record phases in, optional.
+		 */
+		explicit jit(optimization_level level = optimization_level::o0, bool lazy = true, utils::statistics* statistics = nullptr);
+
+		/**
+		 * Defines a symbol for extern functions to resolve to, ahead of the symbols of the process.
+		 *
+		 * @param name name of the symbol, as declared by extern.
+		 * @param address address of the symbol.
+		 */
+		void define(const std::string& name, void* address);
+
+		/**
+		 * Adds a generated module, which the JIT then owns.
+		 *
+		 * @param generated module and its context, as released by a generator or one of its partitions.
+		 */
+		void add(partition generated);
+
+		/**
+		 * Adds a compiled object, which is linked in when a symbol it defines is looked up.
+		 *
+		 * @param object object for the host, such as those made by code_generation::generate_objects.
+		 */
+		void add_object(std::unique_ptr<llvm::MemoryBuffer> object);
+
+		/**
+		 * Looks up a function of an added module, compiling as much as it needs.
+		 *
+		 * @param name name of the function in the generated module.
+		 * @returns address of the function.
+		 */
+		void* lookup(const std::string& name);
+
+		/**
+		 * Runs the entry function, which calls every constructor of the added modules.
+		 */
+		void run();
+	};
+}
@@ -52,30 +52,7 @@ namespace seam::ir::ast::expression
 		vst->visit(this);
     }
 
-	void number_literal::parse_float(const std::string& value)
-	{
-		this->value = std::stod(value);
-	}
-
-	void number_literal::parse_integer(const std::string& value, bool is_unsigned)
-	{
-		this->value = std::stoull(value.c_str());
-		this->is_unsigned = is_unsigned;
-	}
 
-	number_literal::number_literal(utils::position_range range, const std::string& value) :
-		literal(range)
-	{
-		if (value.find('.') != std::string::npos)
-		{
-			parse_float(value);
-		}
-		else
-		{
-			parse_integer(value, value[0] != '-');
-		}
-	}
-	
 	void symbol_wrapper::visit(visitor* vst)
 	{
 		vst->visit(this);
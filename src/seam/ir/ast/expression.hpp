@@ -1,13 +1,15 @@
 #pragma once
 
-#include <vector>
-#include <memory>
-#include <string>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_set>
 #include <variant>
+#include <vector>
 
 #include "node.hpp"
 #include "type.hpp"
 #include "../../lexer/lexeme.hpp"
+#include "../../utils/interner.hpp"
 
 namespace seam::ir::ast
 {
@@ -18,10 +20,10 @@ namespace seam::ir::ast::expression
 {	
 	struct expression : node
 	{
-		std::shared_ptr<type> eval_type{};
+		type* eval_type = nullptr;
 
-		explicit expression(const utils::position_range range)
-			: node(range)
+		explicit expression(const node_kind kind, const utils::position_range range)
+			: node(kind, range)
 		{}
 
 		virtual ~expression() = default;
@@ -29,61 +31,61 @@ namespace seam::ir::ast::expression
 
 	struct unary : expression
 	{
-		std::unique_ptr<expression> right;
+		expression* right;
 		lexer::lexeme_type operation;
 
 		void visit(visitor* vst) override;
 
 		explicit unary(utils::position_range range,
-			std::unique_ptr<expression> rhs,
+			expression* rhs,
 			lexer::lexeme_type operation) :
-			expression(range),
-			right(std::move(rhs)),
+			expression(node_kind::unary, range),
+			right(rhs),
 			operation(operation)
 		{}
 	};
 
 	struct binary : expression
 	{
-		std::unique_ptr<expression> left;
-		std::unique_ptr<expression> right;
+		expression* left;
+		expression* right;
 		lexer::lexeme_type operation;
 
 		void visit(visitor* vst) override;
 		
 		explicit binary(utils::position_range range,
-			std::unique_ptr<expression> lhs,
-			std::unique_ptr<expression> rhs,
+			expression* lhs,
+			expression* rhs,
 			lexer::lexeme_type operation) :
-			expression(range),
-			left(std::move(lhs)),
-			right(std::move(rhs)),
+			expression(node_kind::binary, range),
+			left(lhs),
+			right(rhs),
 			operation(operation)
 		{}
 	};
 	
-	using expression_list = std::vector<std::unique_ptr<expression>>;
+	using expression_list = std::pmr::vector<expression*>;
 
 	struct variable
 	{
-		std::string name;
-		std::shared_ptr<type> type_;
+		utils::symbol_id name;
+		type* type_;
 
-		variable(std::string name, std::shared_ptr<type> type_) :
-			name(std::move(name)),
-			type_(std::move(type_))
+		variable(utils::symbol_id name, type* type_) :
+			name(name),
+			type_(type_)
 		{}
 	};
 
 	struct variable_ref final : expression
 	{
-		std::shared_ptr<variable> var;
+		variable* var;
 
 		void visit(visitor* vst) override;
 
-		variable_ref(utils::position_range range, std::shared_ptr<variable> var) :
-			expression(range),
-			var(std::move(var))
+		variable_ref(utils::position_range range, variable* var) :
+			expression(node_kind::variable_ref, range),
+			var(var)
 		{}
 	};
 
@@ -91,8 +93,8 @@ namespace seam::ir::ast::expression
 	{
 		void visit(visitor* vst) override = 0;
 
-		explicit literal(utils::position_range range) :
-			expression(range)
+		explicit literal(node_kind kind, utils::position_range range) :
+			expression(kind, range)
 		{}
 	};
 
@@ -103,18 +105,18 @@ namespace seam::ir::ast::expression
 		void visit(visitor* vst) override;
 
 		explicit bool_literal(utils::position_range range, bool value) :
-			literal(range), value(value)
+			literal(node_kind::bool_literal, range), value(value)
 		{}
 	};
 
 	struct string_literal : literal
 	{
-		std::string value;
+		std::string_view value; // view into the module source
 
 		void visit(visitor* vst) override;
 
-		explicit string_literal(utils::position_range range, std::string value) :
-			literal(range), value(std::move(value))
+		explicit string_literal(utils::position_range range, std::string_view value) :
+			literal(node_kind::string_literal, range), value(value)
 		{}
 	};
 
@@ -125,19 +127,20 @@ namespace seam::ir::ast::expression
 
 		void visit(visitor* vst) override;
 
-		void parse_float(const std::string& value);
-		void parse_integer(const std::string& value, bool is_unsigned);
-
-		explicit number_literal(utils::position_range range, const std::string& value);
+		explicit number_literal(utils::position_range range, const lexer::number_value& number) :
+			literal(node_kind::number_literal, range),
+			value(number.value),
+			is_unsigned(number.suffix < lexer::number_suffix::i8 || number.suffix > lexer::number_suffix::i64)
+		{}
 	};
 
 	struct call final : expression
 	{
-		std::unique_ptr<expression> function;
+		expression* function;
 		expression_list arguments;
 
-		explicit call(const utils::position_range range, std::unique_ptr<expression> function, expression_list arguments) :
-			expression(range), function(std::move(function)), arguments(std::move(arguments))
+		explicit call(const utils::position_range range, expression* function, expression_list arguments) :
+			expression(node_kind::call, range), function(function), arguments(std::move(arguments))
 		{}
 
 		void visit(visitor* vst) override;
@@ -145,63 +148,62 @@ namespace seam::ir::ast::expression
 
 	struct symbol
 	{
-		
+		virtual ~symbol() = default;
 	};
 	
 	struct symbol_wrapper final : expression
 	{
-		std::unique_ptr<symbol> value;
+		symbol* value;
 
 		void visit(visitor* vst) override;
 
-		symbol_wrapper(utils::position_range range, std::unique_ptr <symbol> value) :
-			expression(range), value(std::move(value))
+		symbol_wrapper(utils::position_range range, symbol* value) :
+			expression(node_kind::symbol_wrapper, range), value(value)
 		{}
 	};
 
 	struct unresolved_symbol final : symbol
 	{
-		std::string value;
+		utils::symbol_id value;
 
-		explicit unresolved_symbol(std::string value) :
-			value(std::move(value))
+		explicit unresolved_symbol(utils::symbol_id value) :
+			value(value)
 		{}
 	};
 
 	using parameter = variable_ref;
-	using parameter_list = std::vector<std::unique_ptr<parameter>>;
-	using attribute_list = std::unordered_set<std::string>;
+	using parameter_list = std::pmr::vector<parameter*>;
+	using attribute_list = std::pmr::unordered_set<std::string_view>;
 
 	struct function_signature : node
 	{
-		std::string name;
-		std::shared_ptr<type> return_type;
-		std::vector<std::unique_ptr<variable_ref>> parameters;
-		std::unordered_set<std::string> attributes;
+		utils::symbol_id name;
+		type* return_type;
+		parameter_list parameters;
+		attribute_list attributes;
 		bool is_extern = false;
 
-		std::string mangled_name;
+		utils::symbol_id mangled_name; // <module>@<name>
 
-		explicit function_signature(std::string module_name, std::string name, std::shared_ptr<type> return_type, parameter_list parameters,
-			attribute_list attributes) :
-			node({ 0,0 }),
-			name(std::move(name)),
-			return_type(std::move(return_type)),
+		explicit function_signature(utils::symbol_id name, utils::symbol_id mangled_name, type* return_type,
+			parameter_list parameters, attribute_list attributes) :
+			node(node_kind::function_signature, { 0,0 }),
+			name(name),
+			return_type(return_type),
 			parameters(std::move(parameters)),
-			attributes(std::move(attributes))
-		{
-			mangled_name = module_name + "@" + this->name;
-		}
+			attributes(std::move(attributes)),
+			mangled_name(mangled_name)
+		{}
 
 		void visit(visitor* vst) override;
 	};
 
 	struct resolved_symbol final : symbol
 	{
-		std::shared_ptr<function_signature> signature;
+		function_signature* signature;
 
-		explicit resolved_symbol(std::shared_ptr<function_signature> sig) :
-			signature(std::move(sig))
+		explicit resolved_symbol(function_signature* sig) :
+			signature(sig)
 		{}
 	};
 }
\ No newline at end of file
@@ -1,13 +1,44 @@
 #pragma once
 
+#include <cstdint>
+
 #include "../../utils/position.hpp"
 
 namespace seam::ir::ast
 {
+	/**
+	 * Concrete type of a node, lets a walker dispatch with a switch instead of virtual calls.
+	 */
+	enum class node_kind : std::uint8_t
+	{
+		unary,
+		binary,
+		variable_ref,
+		bool_literal,
+		string_literal,
+		number_literal,
+		call,
+		symbol_wrapper,
+		function_signature,
+		expression_,
+		ret,
+		assignment,
+		if_stat,
+		while_loop,
+		numerical_for_loop,
+		normal_block,
+		restricted_block,
+		function_definition,
+		extern_function_definition,
+		alias_type_definition,
+		class_type_definition,
+	};
+
 	struct visitor;
 	struct node
 	{
 		utils::position_range range; // the range of text the node ranges over. 
+		node_kind kind; // concrete type of the node.
 
 		/**
 		 * Virtual visit method for visitor pattern.
@@ -19,7 +50,7 @@ namespace seam::ir::ast
 
 		virtual ~node() = default;
 	protected:
-		explicit node(const utils::position_range range)
-			: range(range) {}
+		explicit node(const node_kind kind, const utils::position_range range)
+			: range(range), kind(kind) {}
 	};
 }
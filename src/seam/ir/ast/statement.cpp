@@ -89,6 +89,7 @@ namespace seam::ir::ast::statement
 			initial->visit(vst);
 			final->visit(vst);
 			step->visit(vst);
+			body->visit(vst);
 		}
 	}
 
@@ -97,6 +98,7 @@ namespace seam::ir::ast::statement
 		if (vst->visit(this))
 		{
 			condition->visit(vst);
+			body->visit(vst);
 		}
 	}
 
@@ -1,8 +1,6 @@
 #pragma once
 
-#include <memory>
-#include <string>
-#include <unordered_map>
+#include <memory_resource>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -10,37 +8,36 @@
 #include "node.hpp"
 #include "expression.hpp"
 #include "type.hpp"
+#include "../../utils/interner.hpp"
 
 namespace seam::ir::ast::statement
 {	
 	struct statement : node
 	{
-		explicit statement(utils::position_range range)
-			: node(range) {}
+		explicit statement(node_kind kind, utils::position_range range)
+			: node(kind, range) {}
 
 		virtual ~statement() = default;
 	};
 
-	using statement_list = std::vector<std::unique_ptr<statement>>;
+	using statement_list = std::pmr::vector<statement*>;
 
 	struct restricted : statement
 	{
-		explicit restricted(utils::position_range range)
-			: statement(range) {}
+		explicit restricted(node_kind kind, utils::position_range range)
+			: statement(kind, range) {}
 
 		virtual ~restricted() = default;
 	};
 
-	using restricted_list = std::vector<std::unique_ptr<restricted>>;
+	using restricted_list = std::pmr::vector<restricted*>;
 
 	struct base_block : statement
 	{
-		base_block* parent;
-		std::unordered_map<std::string, std::shared_ptr<expression::variable>> variables;
-		std::unordered_map<std::string, std::shared_ptr<type>> types;
+		base_block* parent = nullptr;
 
-		explicit base_block(utils::position_range range) :
-			statement(range)
+		explicit base_block(node_kind kind, utils::position_range range) :
+			statement(kind, range)
 		{}
 	};
 
@@ -50,12 +47,12 @@ namespace seam::ir::ast::statement
 
 		void visit(visitor* vst) override;
 
-		explicit restricted_block(utils::position_range range)
-			: base_block(range)
+		explicit restricted_block(utils::position_range range, std::pmr::memory_resource* resource)
+			: base_block(node_kind::restricted_block, range), body(resource)
 		{}
 
 		explicit restricted_block(utils::position_range range, restricted_list body)
-			: base_block(range), body(std::move(body))
+			: base_block(node_kind::restricted_block, range), body(std::move(body))
 		{}
 	};
 
@@ -65,122 +62,123 @@ namespace seam::ir::ast::statement
 		
 		void visit(visitor* vst) override;
 
-		explicit normal_block(utils::position_range range)
-			: base_block(range) {}
+		explicit normal_block(utils::position_range range, std::pmr::memory_resource* resource)
+			: base_block(node_kind::normal_block, range), body(resource) {}
 
 		explicit normal_block(utils::position_range range, statement_list body)
-			: base_block(range), body(std::move(body)) {}
+			: base_block(node_kind::normal_block, range), body(std::move(body)) {}
 	};
 
 	struct expression_ final : statement
 	{
-		std::unique_ptr<expression::expression> value;
+		expression::expression* value;
 
 		void visit(visitor* vst) override;
 
-		explicit expression_(utils::position_range range, std::unique_ptr<expression::expression> value) :
-			statement(range), value(std::move(value)) {}
+		explicit expression_(utils::position_range range, expression::expression* value) :
+			statement(node_kind::expression_, range), value(value) {}
 	};
 
 	struct ret final : statement
 	{
-		std::unique_ptr<expression::expression> value;
+		expression::expression* value;
 
 		void visit(visitor* vst) override;
 
-		explicit ret(utils::position_range range, std::unique_ptr<expression::expression> return_value) :
-			statement(range), value(std::move(return_value)) {}
+		explicit ret(utils::position_range range, expression::expression* return_value) :
+			statement(node_kind::ret, range), value(return_value) {}
 	};
 
 	struct assignment final : statement
 	{
-		std::unique_ptr<expression::expression> to;
-		std::unique_ptr<expression::expression> from;
+		expression::expression* to;
+		expression::expression* from;
 
 		void visit(visitor* vst) override;
 
-		explicit assignment(utils::position_range range, std::unique_ptr<expression::expression> to, std::unique_ptr<expression::expression> from) :
-			statement(range),
-			to(std::move(to)),
-			from(std::move(from))
+		explicit assignment(utils::position_range range, expression::expression* to, expression::expression* from) :
+			statement(node_kind::assignment, range),
+			to(to),
+			from(from)
 		{}
 	};
 
 	struct if_stat final : statement
 	{
-		std::unique_ptr<expression::expression> condition;
-		std::unique_ptr<normal_block> main_body;
-		std::unique_ptr<normal_block> else_body;
+		expression::expression* condition;
+		normal_block* main_body;
+		normal_block* else_body;
 		// elseif
 
 		void visit(visitor* vst) override;
 		
 		explicit if_stat(utils::position_range range,
-			std::unique_ptr<expression::expression> condition,
-			std::unique_ptr<normal_block> main_body,
-			std::unique_ptr<normal_block> else_body) :
-			statement(range),
-			condition(std::move(condition)),
-			main_body(std::move(main_body)),
-			else_body(std::move(else_body)) {}
+			expression::expression* condition,
+			normal_block* main_body,
+			normal_block* else_body) :
+			statement(node_kind::if_stat, range),
+			condition(condition),
+			main_body(main_body),
+			else_body(else_body) {}
 	};
 	
 	struct loop : statement
 	{
 		// numberial for loop, range for loop
 		// initial, final, <optional step>
-		std::unique_ptr<normal_block> body;
+		normal_block* body;
 
 		void visit(visitor* vst) override;
 
-		explicit loop(utils::position_range range, std::unique_ptr<normal_block> body) :
-			statement(range), body(std::move(body)) {}
+		explicit loop(node_kind kind, utils::position_range range, normal_block* body) :
+			statement(kind, range), body(body) {}
 	};
 
 	struct numerical_for_loop final : loop 
 	{
-		std::unique_ptr<expression::number_literal> initial; // used as variable
-		std::unique_ptr<expression::number_literal> final;
-		std::unique_ptr<expression::number_literal> step;
+		expression::number_literal* initial; // used as variable
+		expression::number_literal* final;
+		expression::number_literal* step;
 
 		void visit(visitor* vst) override;
 
-		explicit numerical_for_loop(utils::position_range range, std::unique_ptr<expression::number_literal> initial,
-			std::unique_ptr<expression::number_literal> final, std::unique_ptr<expression::number_literal> step, std::unique_ptr<normal_block> body)
-				: loop(range, std::move(body)), 
-					initial(std::move(initial)), final(std::move(final)), step(std::move(step)) {}
+		explicit numerical_for_loop(utils::position_range range, expression::number_literal* initial,
+			expression::number_literal* final, expression::number_literal* step, normal_block* body)
+				: loop(node_kind::numerical_for_loop, range, body), 
+					initial(initial), final(final), step(step) {}
 	};
 	
 	struct while_loop final : loop
 	{
-		std::unique_ptr<expression::expression> condition;
+		expression::expression* condition;
 
 		void visit(visitor* vst) override;
 
-		explicit while_loop(utils::position_range range, std::unique_ptr<expression::expression> condition, std::unique_ptr<normal_block> body) :
-			loop(range, std::move(body)), condition(std::move(condition)) {}
+		explicit while_loop(utils::position_range range, expression::expression* condition, normal_block* body) :
+			loop(node_kind::while_loop, range, body), condition(condition) {}
 	};
 
 	struct function_definition final : restricted
 	{
-		std::shared_ptr<expression::function_signature> signature;
-		std::unique_ptr<normal_block> body;
-		std::unordered_set<std::shared_ptr<expression::function_signature>> function_dependencies;
+		expression::function_signature* signature;
+		normal_block* body;
+		std::pmr::unordered_set<expression::function_signature*> function_dependencies;
 
 		void visit(visitor* vst) override;
 
-		explicit function_definition(utils::position_range range, std::shared_ptr<expression::function_signature> signature, std::unique_ptr<normal_block> body) :
-			restricted(range), signature(signature), body(std::move(body)) {}
+		explicit function_definition(utils::position_range range, expression::function_signature* signature, normal_block* body,
+			std::pmr::memory_resource* resource) :
+			restricted(node_kind::function_definition, range), signature(signature), body(body), function_dependencies(resource) {}
 	};
 
 	struct extern_function_definition final : restricted
 	{
-		std::shared_ptr<expression::function_signature> signature;
+		expression::function_signature* signature;
 
 		void visit(visitor* vst);
 
-		explicit extern_function_definition(utils::position_range range, std::shared_ptr<expression::function_signature> signature) :
-			restricted(range),
+		explicit extern_function_definition(utils::position_range range, expression::function_signature* signature) :
+			restricted(node_kind::extern_function_definition, range),
 			signature(signature)
 		{}
 	};
@@ -192,28 +190,28 @@ namespace seam::ir::ast::statement
 
 	struct alias_type_definition final : type_definition
 	{
-		std::string name;
-		std::shared_ptr<type> target_type;
+		utils::symbol_id name;
+		type* target_type;
 
 		void visit(visitor* vst) override;
 
-		explicit alias_type_definition(utils::position_range range, std::string name, std::shared_ptr<type> target_type) :
-			type_definition(range), name(std::move(name)), target_type(std::move(target_type)) {}
+		explicit alias_type_definition(utils::position_range range, utils::symbol_id name, type* target_type) :
+			type_definition(node_kind::alias_type_definition, range), name(name), target_type(target_type) {}
 	};
 
 	struct class_type_definition final : type_definition
 	{
-		std::string name;
+		utils::symbol_id name;
 		expression::parameter_list fields;
-		std::unique_ptr<restricted_block> body;
+		restricted_block* body;
 
 		void visit(visitor* vst) override;
 
-		explicit class_type_definition(utils::position_range range, std::string name, expression::parameter_list fields,
-			std::unique_ptr<restricted_block> body) :
-			type_definition(range),
-			name(std::move(name)),
+		explicit class_type_definition(utils::position_range range, utils::symbol_id name, expression::parameter_list fields,
+			restricted_block* body) :
+			type_definition(node_kind::class_type_definition, range),
+			name(name),
 			fields(std::move(fields)),
-			body(std::move(body)) {}
+			body(body) {}
 	};
 }
@@ -53,5 +53,9 @@ namespace seam::ir::ast
 		explicit type(built_in_type t) :
 			value(t)
 		{}
+
+		// Types are interned by types::type_context and compared by address.
+		type(const type&) = delete;
+		type& operator=(const type&) = delete;
 	};
 }
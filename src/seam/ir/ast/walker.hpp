@@ -0,0 +1,261 @@
+#pragma once
+
+#include "node.hpp"
+#include "expression.hpp"
+#include "statement.hpp"
+
+#define BASE_WALKER(c) bool visit(c*) { return true; }
+#define WALKER(b, c) bool visit(c* a) { return self().visit(static_cast<b*>(a)); }
+
+namespace seam::ir::ast
+{
+	/**
+	 * Visitor which dispatches on the kind of a node instead of through virtual calls.
+	 *
+	 * Overloads are written the same way as for visitor: a derived walker
+	 * hides the visit overloads it cares about, and the rest fall back to the
+	 * overload of the base type, down to node. Returning true from an overload
+	 * walks the children of the node, in the same order as visitor does. The
+	 * derived walker is known at compile time, so overloads can be inlined
+	 * into walk.
+	 *
+	 * Derived walkers should bring the defaults into scope with `using walker::visit;`.
+	 */
+	template <typename Derived>
+	struct walker
+	{
+		BASE_WALKER(node);
+
+		WALKER(node, expression::function_signature);
+		WALKER(node, statement::statement);
+		WALKER(node, expression::expression);
+
+		WALKER(statement::statement, statement::function_definition);
+		WALKER(statement::statement, statement::class_type_definition);
+		WALKER(statement::statement, statement::alias_type_definition);
+		WALKER(statement::statement, statement::restricted);
+		WALKER(statement::statement, statement::restricted_block);
+		WALKER(statement::statement, statement::normal_block);
+		WALKER(statement::statement, statement::expression_);
+		WALKER(statement::statement, statement::ret);
+		WALKER(statement::statement, statement::while_loop);
+		WALKER(statement::statement, statement::numerical_for_loop);
+		WALKER(statement::statement, statement::if_stat);
+		WALKER(statement::statement, statement::assignment);
+
+		WALKER(statement::restricted, statement::extern_function_definition);
+
+		WALKER(expression::expression, expression::unary);
+		WALKER(expression::expression, expression::variable_ref);
+		WALKER(expression::expression, expression::symbol_wrapper);
+		WALKER(expression::expression, expression::call);
+		WALKER(expression::expression, expression::bool_literal);
+		WALKER(expression::expression, expression::string_literal);
+		WALKER(expression::expression, expression::number_literal);
+		WALKER(expression::expression, expression::binary);
+
+		/**
+		 * Visits a node and, unless its overload returns false, its children.
+		 *
+		 * @param node node to walk, must not be null.
+		 */
+		void walk(node* node)
+		{
+			switch (node->kind)
+			{
+				case node_kind::unary:
+				{
+					const auto n = static_cast<expression::unary*>(node);
+					if (self().visit(n))
+					{
+						walk(n->right);
+					}
+					break;
+				}
+				case node_kind::binary:
+				{
+					const auto n = static_cast<expression::binary*>(node);
+					if (self().visit(n))
+					{
+						walk(n->left);
+						walk(n->right);
+					}
+					break;
+				}
+				case node_kind::variable_ref:
+				{
+					self().visit(static_cast<expression::variable_ref*>(node));
+					break;
+				}
+				case node_kind::bool_literal:
+				{
+					self().visit(static_cast<expression::bool_literal*>(node));
+					break;
+				}
+				case node_kind::string_literal:
+				{
+					self().visit(static_cast<expression::string_literal*>(node));
+					break;
+				}
+				case node_kind::number_literal:
+				{
+					self().visit(static_cast<expression::number_literal*>(node));
+					break;
+				}
+				case node_kind::call:
+				{
+					const auto n = static_cast<expression::call*>(node);
+					if (self().visit(n))
+					{
+						walk(n->function);
+						for (const auto argument : n->arguments)
+						{
+							walk(argument);
+						}
+					}
+					break;
+				}
+				case node_kind::symbol_wrapper:
+				{
+					self().visit(static_cast<expression::symbol_wrapper*>(node));
+					break;
+				}
+				case node_kind::function_signature:
+				{
+					const auto n = static_cast<expression::function_signature*>(node);
+					if (self().visit(n))
+					{
+						for (const auto param : n->parameters)
+						{
+							walk(param);
+						}
+					}
+					break;
+				}
+				case node_kind::expression_:
+				{
+					const auto n = static_cast<statement::expression_*>(node);
+					if (self().visit(n))
+					{
+						walk(n->value);
+					}
+					break;
+				}
+				case node_kind::ret:
+				{
+					const auto n = static_cast<statement::ret*>(node);
+					if (self().visit(n) && n->value)
+					{
+						walk(n->value);
+					}
+					break;
+				}
+				case node_kind::assignment:
+				{
+					const auto n = static_cast<statement::assignment*>(node);
+					if (self().visit(n))
+					{
+						walk(n->from);
+						walk(n->to);
+					}
+					break;
+				}
+				case node_kind::if_stat:
+				{
+					const auto n = static_cast<statement::if_stat*>(node);
+					if (self().visit(n))
+					{
+						walk(n->condition);
+						walk(n->main_body);
+						if (n->else_body)
+						{
+							walk(n->else_body);
+						}
+					}
+					break;
+				}
+				case node_kind::while_loop:
+				{
+					const auto n = static_cast<statement::while_loop*>(node);
+					if (self().visit(n))
+					{
+						walk(n->condition);
+						walk(n->body);
+					}
+					break;
+				}
+				case node_kind::numerical_for_loop:
+				{
+					const auto n = static_cast<statement::numerical_for_loop*>(node);
+					if (self().visit(n))
+					{
+						walk(n->initial);
+						walk(n->final);
+						walk(n->step);
+						walk(n->body);
+					}
+					break;
+				}
+				case node_kind::normal_block:
+				{
+					const auto n = static_cast<statement::normal_block*>(node);
+					if (self().visit(n))
+					{
+						for (const auto statement : n->body)
+						{
+							walk(statement);
+						}
+					}
+					break;
+				}
+				case node_kind::restricted_block:
+				{
+					const auto n = static_cast<statement::restricted_block*>(node);
+					if (self().visit(n))
+					{
+						for (const auto statement : n->body)
+						{
+							walk(statement);
+						}
+					}
+					break;
+				}
+				case node_kind::function_definition:
+				{
+					const auto n = static_cast<statement::function_definition*>(node);
+					if (self().visit(n))
+					{
+						walk(n->signature);
+						walk(n->body);
+					}
+					break;
+				}
+				case node_kind::extern_function_definition:
+				{
+					self().visit(static_cast<statement::extern_function_definition*>(node));
+					break;
+				}
+				case node_kind::alias_type_definition:
+				{
+					self().visit(static_cast<statement::alias_type_definition*>(node));
+					break;
+				}
+				case node_kind::class_type_definition:
+				{
+					const auto n = static_cast<statement::class_type_definition*>(node);
+					if (self().visit(n))
+					{
+						walk(n->body);
+					}
+					break;
+				}
+			}
+		}
+
+	private:
+		Derived& self() { return static_cast<Derived&>(*this); }
+	};
+}
+
+#undef BASE_WALKER
+#undef WALKER
@@ -0,0 +1,489 @@
+#include "tree.hpp"
+
+#include "../ast/walker.hpp"
+
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace seam::ir::flat
+{
+	using namespace ast;
+
+	struct flattener : walker<flattener>
+	{
+		using walker::visit;
+
+		tree& result;
+
+		std::unordered_map<expression::variable*, std::uint32_t> variables;
+		std::unordered_map<expression::function_signature*, node_index> signatures;
+		std::vector<std::pair<node_index, expression::function_signature*>> resolved_symbols; // patched once every signature is known
+
+		explicit flattener(tree& result) :
+			result(result)
+		{}
+
+		bool visit(expression::binary* node)
+		{
+			const auto first = result.size();
+			walk(node->left);
+			walk(node->right);
+			result.add(node_kind::binary, first, static_cast<std::uint32_t>(node->operation), node->range, node->eval_type);
+			return false;
+		}
+
+		bool visit(expression::variable_ref* node)
+		{
+			const auto [it, is_new] = variables.emplace(node->var, static_cast<std::uint32_t>(result.variables.size()));
+			if (is_new)
+			{
+				result.variables.push_back({ node->var->name, node->var->type_ });
+			}
+
+			result.add(node_kind::variable_ref, result.size(), it->second, node->range, node->eval_type);
+			return false;
+		}
+
+		bool visit(expression::bool_literal* node)
+		{
+			result.add(node_kind::bool_literal, result.size(), node->value, node->range, node->eval_type);
+			return false;
+		}
+
+		bool visit(expression::string_literal* node)
+		{
+			result.strings.push_back(node->value);
+			result.add(node_kind::string_literal, result.size(), static_cast<std::uint32_t>(result.strings.size() - 1),
+				node->range, node->eval_type);
+			return false;
+		}
+
+		bool visit(expression::number_literal* node)
+		{
+			result.numbers.push_back({ node->value, node->is_unsigned });
+			result.add(node_kind::number_literal, result.size(), static_cast<std::uint32_t>(result.numbers.size() - 1),
+				node->range, node->eval_type);
+			return false;
+		}
+
+		bool visit(expression::call* node)
+		{
+			const auto first = result.size();
+			walk(node->function);
+			for (const auto& argument : node->arguments)
+			{
+				walk(argument);
+			}
+			result.add(node_kind::call, first, 0, node->range, node->eval_type);
+			return false;
+		}
+
+		bool visit(expression::symbol_wrapper* node)
+		{
+			if (const auto resolved = dynamic_cast<expression::resolved_symbol*>(node->value))
+			{
+				const auto index = result.add(node_kind::resolved_symbol, result.size(), no_node, node->range, node->eval_type);
+				resolved_symbols.emplace_back(index, resolved->signature);
+			}
+			else
+			{
+				const auto symbol = static_cast<expression::unresolved_symbol*>(node->value)->value;
+				result.add(node_kind::unresolved_symbol, result.size(), symbol, node->range, node->eval_type);
+			}
+			return false;
+		}
+
+		bool visit(expression::function_signature* node)
+		{
+			const auto first = result.size();
+			for (const auto& parameter : node->parameters)
+			{
+				walk(parameter);
+			}
+
+			result.signatures.push_back({
+				node->name,
+				node->mangled_name,
+				node->return_type,
+				{ node->attributes.cbegin(), node->attributes.cend() },
+				node->is_extern,
+			});
+			const auto index = result.add(node_kind::function_signature, first, static_cast<std::uint32_t>(result.signatures.size() - 1),
+				node->range);
+			signatures.emplace(node, index);
+			return false;
+		}
+
+		bool visit(statement::expression_* node)
+		{
+			const auto first = result.size();
+			walk(node->value);
+			result.add(node_kind::expression_statement, first, 0, node->range);
+			return false;
+		}
+
+		bool visit(statement::ret* node)
+		{
+			const auto first = result.size();
+			if (node->value)
+			{
+				walk(node->value);
+			}
+			result.add(node_kind::ret, first, 0, node->range);
+			return false;
+		}
+
+		bool visit(statement::assignment* node)
+		{
+			const auto first = result.size();
+			walk(node->from);
+			walk(node->to);
+			result.add(node_kind::assignment, first, 0, node->range);
+			return false;
+		}
+
+		bool visit(statement::if_stat* node)
+		{
+			const auto first = result.size();
+			walk(node->condition);
+			walk(node->main_body);
+			if (node->else_body)
+			{
+				walk(node->else_body);
+			}
+			result.add(node_kind::if_stat, first, 0, node->range);
+			return false;
+		}
+
+		bool visit(statement::while_loop* node)
+		{
+			const auto first = result.size();
+			walk(node->condition);
+			walk(node->body);
+			result.add(node_kind::while_loop, first, 0, node->range);
+			return false;
+		}
+
+		bool visit(statement::normal_block* node)
+		{
+			const auto first = result.size();
+			for (const auto& statement : node->body)
+			{
+				walk(statement);
+			}
+			result.add(node_kind::normal_block, first, 0, node->range);
+			return false;
+		}
+
+		bool visit(statement::restricted_block* node)
+		{
+			const auto first = result.size();
+			for (const auto& statement : node->body)
+			{
+				walk(statement);
+			}
+			result.add(node_kind::restricted_block, first, 0, node->range);
+			return false;
+		}
+
+		bool visit(statement::function_definition* node)
+		{
+			const auto first = result.size();
+			walk(node->signature);
+			walk(node->body);
+			result.add(node_kind::function_definition, first, 0, node->range);
+			return false;
+		}
+
+		bool visit(statement::extern_function_definition* node)
+		{
+			const auto first = result.size();
+			walk(node->signature);
+			result.add(node_kind::extern_function_definition, first, 0, node->range);
+			return false;
+		}
+
+		bool visit(statement::alias_type_definition* node)
+		{
+			result.add(node_kind::alias_type_definition, result.size(), node->name, node->range, node->target_type);
+			return false;
+		}
+
+		bool visit(statement::class_type_definition* node)
+		{
+			const auto first = result.size();
+			for (const auto& field : node->fields)
+			{
+				walk(field);
+			}
+			walk(node->body);
+			result.add(node_kind::class_type_definition, first, node->name, node->range);
+			return false;
+		}
+
+		bool visit(expression::unary* node)
+		{
+			const auto first = result.size();
+			walk(node->right);
+			result.add(node_kind::unary, first, static_cast<std::uint32_t>(node->operation), node->range, node->eval_type);
+			return false;
+		}
+
+		bool visit(statement::numerical_for_loop* node)
+		{
+			const auto first = result.size();
+			walk(node->initial);
+			walk(node->final);
+			walk(node->step);
+			walk(node->body);
+			result.add(node_kind::numerical_for_loop, first, 0, node->range);
+			return false;
+		}
+
+		bool visit(node*)
+		{
+			throw std::runtime_error("cannot flatten unknown node");
+		}
+	};
+
+	tree flatten(node* root)
+	{
+		tree result;
+
+		flattener vst{ result };
+		vst.walk(root);
+
+		for (const auto& [index, signature] : vst.resolved_symbols)
+		{
+			const auto it = vst.signatures.find(signature);
+			result.data[index] = it != vst.signatures.cend() ? it->second : no_node;
+		}
+
+		return result;
+	}
+
+	node* unflatten(const tree& source, utils::arena& arena)
+	{
+		std::vector<node*> stack; // finished subtrees, the children of a node are on top when it is reached
+		std::vector<expression::variable*> variables(source.variables.size());
+		std::unordered_map<node_index, expression::function_signature*> signatures;
+		std::vector<std::pair<expression::resolved_symbol*, node_index>> resolved_symbols;
+		std::vector<std::pair<node_index, statement::normal_block*>> orphan_blocks; // blocks waiting for their parent
+
+		const auto resource = arena.resource();
+
+		for (node_index index = 0; index < source.size(); ++index)
+		{
+			const auto child_count = source.child_count(index);
+			const auto children = stack.end() - static_cast<std::ptrdiff_t>(child_count);
+			const auto child = [&](const std::size_t position) { return children[static_cast<std::ptrdiff_t>(position)]; };
+			const auto child_expression = [&](const std::size_t position) { return static_cast<expression::expression*>(child(position)); };
+			const auto child_block = [&](const std::size_t position) { return static_cast<statement::normal_block*>(child(position)); };
+
+			const auto data = source.data[index];
+			const auto range = source.ranges[index];
+
+			// Blocks adopt every block in their subtree which has no parent yet.
+			const auto adopt_blocks = [&](statement::base_block* block)
+			{
+				const auto first = index + 1 - source.sizes[index];
+				while (!orphan_blocks.empty() && orphan_blocks.back().first >= first)
+				{
+					orphan_blocks.back().second->parent = block;
+					orphan_blocks.pop_back();
+				}
+			};
+
+			node* current = nullptr;
+			switch (source.kinds[index])
+			{
+				case node_kind::unary:
+				{
+					current = arena.make<expression::unary>(range, child_expression(0), static_cast<lexer::lexeme_type>(data));
+					break;
+				}
+				case node_kind::binary:
+				{
+					current = arena.make<expression::binary>(range, child_expression(0), child_expression(1), static_cast<lexer::lexeme_type>(data));
+					break;
+				}
+				case node_kind::variable_ref:
+				{
+					auto& variable = variables[data];
+					if (!variable)
+					{
+						variable = arena.make<expression::variable>(source.variables[data].name, source.variables[data].type);
+					}
+					current = arena.make<expression::variable_ref>(range, variable);
+					break;
+				}
+				case node_kind::bool_literal:
+				{
+					current = arena.make<expression::bool_literal>(range, data != 0);
+					break;
+				}
+				case node_kind::string_literal:
+				{
+					current = arena.make<expression::string_literal>(range, source.strings[data]);
+					break;
+				}
+				case node_kind::number_literal:
+				{
+					const auto literal = arena.make<expression::number_literal>(range, lexer::number_value{ source.numbers[data].value });
+					literal->is_unsigned = source.numbers[data].is_unsigned;
+					current = literal;
+					break;
+				}
+				case node_kind::call:
+				{
+					expression::expression_list arguments(resource);
+					for (std::size_t i = 1; i < child_count; ++i)
+					{
+						arguments.push_back(child_expression(i));
+					}
+					current = arena.make<expression::call>(range, child_expression(0), std::move(arguments));
+					break;
+				}
+				case node_kind::unresolved_symbol:
+				{
+					current = arena.make<expression::symbol_wrapper>(range, arena.make<expression::unresolved_symbol>(data));
+					break;
+				}
+				case node_kind::resolved_symbol:
+				{
+					const auto symbol = arena.make<expression::resolved_symbol>(nullptr);
+					resolved_symbols.emplace_back(symbol, data);
+					current = arena.make<expression::symbol_wrapper>(range, symbol);
+					break;
+				}
+				case node_kind::function_signature:
+				{
+					const auto& info = source.signatures[data];
+
+					expression::parameter_list parameters(resource);
+					for (std::size_t i = 0; i < child_count; ++i)
+					{
+						parameters.push_back(static_cast<expression::parameter*>(child(i)));
+					}
+
+					expression::attribute_list attributes(info.attributes.cbegin(), info.attributes.cend(), 0, resource);
+
+					const auto signature = arena.make<expression::function_signature>(info.name, info.mangled_name, info.return_type,
+						std::move(parameters), std::move(attributes));
+					signature->is_extern = info.is_extern;
+					signature->range = range;
+					signatures.emplace(index, signature);
+					current = signature;
+					break;
+				}
+				case node_kind::expression_statement:
+				{
+					current = arena.make<statement::expression_>(range, child_expression(0));
+					break;
+				}
+				case node_kind::ret:
+				{
+					current = arena.make<statement::ret>(range, child_count ? child_expression(0) : nullptr);
+					break;
+				}
+				case node_kind::assignment:
+				{
+					current = arena.make<statement::assignment>(range, child_expression(1), child_expression(0));
+					break;
+				}
+				case node_kind::if_stat:
+				{
+					current = arena.make<statement::if_stat>(range, child_expression(0), child_block(1),
+						child_count > 2 ? child_block(2) : nullptr);
+					break;
+				}
+				case node_kind::while_loop:
+				{
+					current = arena.make<statement::while_loop>(range, child_expression(0), child_block(1));
+					break;
+				}
+				case node_kind::numerical_for_loop:
+				{
+					current = arena.make<statement::numerical_for_loop>(range,
+						static_cast<expression::number_literal*>(child(0)),
+						static_cast<expression::number_literal*>(child(1)),
+						static_cast<expression::number_literal*>(child(2)),
+						child_block(3));
+					break;
+				}
+				case node_kind::normal_block:
+				{
+					statement::statement_list body(resource);
+					for (std::size_t i = 0; i < child_count; ++i)
+					{
+						body.push_back(static_cast<statement::statement*>(child(i)));
+					}
+
+					const auto block = arena.make<statement::normal_block>(range, std::move(body));
+					adopt_blocks(block);
+					orphan_blocks.emplace_back(index, block);
+					current = block;
+					break;
+				}
+				case node_kind::restricted_block:
+				{
+					statement::restricted_list body(resource);
+					for (std::size_t i = 0; i < child_count; ++i)
+					{
+						body.push_back(static_cast<statement::restricted*>(child(i)));
+					}
+
+					const auto block = arena.make<statement::restricted_block>(range, std::move(body));
+					adopt_blocks(block);
+					current = block;
+					break;
+				}
+				case node_kind::function_definition:
+				{
+					current = arena.make<statement::function_definition>(range,
+						static_cast<expression::function_signature*>(child(0)), child_block(1), resource);
+					break;
+				}
+				case node_kind::extern_function_definition:
+				{
+					current = arena.make<statement::extern_function_definition>(range, static_cast<expression::function_signature*>(child(0)));
+					break;
+				}
+				case node_kind::alias_type_definition:
+				{
+					current = arena.make<statement::alias_type_definition>(range, data, source.types[index]);
+					break;
+				}
+				case node_kind::class_type_definition:
+				{
+					expression::parameter_list fields(resource);
+					for (std::size_t i = 0; i + 1 < child_count; ++i)
+					{
+						fields.push_back(static_cast<expression::parameter*>(child(i)));
+					}
+
+					current = arena.make<statement::class_type_definition>(range, data, std::move(fields),
+						static_cast<statement::restricted_block*>(child(child_count - 1)));
+					break;
+				}
+			}
+
+			if (source.kinds[index] < node_kind::function_signature)
+			{
+				static_cast<expression::expression*>(current)->eval_type = source.types[index];
+			}
+
+			stack.erase(children, stack.end());
+			stack.push_back(current);
+		}
+
+		for (const auto& [symbol, index] : resolved_symbols)
+		{
+			const auto it = signatures.find(index);
+			symbol->signature = it != signatures.cend() ? it->second : nullptr;
+		}
+
+		return stack.empty() ? nullptr : stack.back();
+	}
+}
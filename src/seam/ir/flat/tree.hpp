@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "../ast/node.hpp"
+#include "../ast/type.hpp"
+#include "../../utils/arena.hpp"
+#include "../../utils/interner.hpp"
+#include "../../utils/position.hpp"
+
+namespace seam::ir::flat
+{
+	/**
+	 * Index of a node within a tree.
+	 */
+	using node_index = std::uint32_t;
+
+	constexpr node_index no_node = std::numeric_limits<node_index>::max();
+
+	/**
+	 * Kind of a node, along with what its data field holds and which children it has, in order.
+	 */
+	enum class node_kind : std::uint8_t
+	{
+		// expressions
+		unary, // data: operation; children: operand
+		binary, // data: operation; children: left, right
+		variable_ref, // data: index into variables
+		bool_literal, // data: value
+		string_literal, // data: index into strings
+		number_literal, // data: index into numbers
+		call, // children: function, arguments...
+		unresolved_symbol, // data: symbol id
+		resolved_symbol, // data: node index of function_signature
+		function_signature, // data: index into signatures; children: parameters...
+
+		// statements
+		expression_statement, // children: expression
+		ret, // children: optional value
+		assignment, // children: from, to
+		if_stat, // children: condition, main body, optional else body
+		while_loop, // children: condition, body
+		numerical_for_loop, // children: initial, final, step, body
+		normal_block, // children: statements...
+		restricted_block, // children: statements...
+		function_definition, // children: signature, body
+		extern_function_definition, // children: signature
+		alias_type_definition, // data: name; type: target type
+		class_type_definition, // data: name; children: fields..., body
+	};
+
+	struct variable_info
+	{
+		utils::symbol_id name;
+		ast::type* type;
+	};
+
+	struct number_info
+	{
+		std::variant<std::uint64_t, double> value;
+		bool is_unsigned;
+	};
+
+	struct signature_info
+	{
+		utils::symbol_id name;
+		utils::symbol_id mangled_name;
+		ast::type* return_type;
+		std::vector<std::string_view> attributes;
+		bool is_extern;
+	};
+
+	/**
+	 * Syntax tree stored as flat arrays of nodes, in post-order.
+	 *
+	 * Every node comes right after its last child and its subtree is the
+	 * contiguous range ending at the node, so a pass which only needs the
+	 * results of the children walks the arrays front to back without any
+	 * recursion. Node fields are kept in separate arrays indexed by node,
+	 * and payloads which do not fit in the data field live in side tables.
+	 * Types are not owned, they belong to the module's type context.
+	 */
+	struct tree
+	{
+		std::vector<node_kind> kinds;
+		std::vector<std::uint32_t> sizes; // number of nodes in the subtree, including the node itself
+		std::vector<std::uint32_t> data; // meaning depends on the kind, see node_kind
+		std::vector<ast::type*> types; // evaluated type of expressions, target type of aliases
+		std::vector<utils::position_range> ranges;
+
+		std::vector<node_index> children; // children of every node in turn, each node's in order
+		std::vector<std::uint32_t> child_offsets = { 0 }; // where the children of each node start in children, then the end
+
+		std::vector<variable_info> variables; // shared by every reference to the same variable
+		std::vector<std::string_view> strings;
+		std::vector<number_info> numbers;
+		std::vector<signature_info> signatures;
+
+		/**
+		 * Returns the number of nodes.
+		 *
+		 * @returns number of nodes.
+		 */
+		[[nodiscard]] std::size_t size() const { return kinds.size(); }
+
+		/**
+		 * Returns the root, which is the last node.
+		 *
+		 * @returns index of root, no_node if empty.
+		 */
+		[[nodiscard]] node_index root() const
+		{
+			return kinds.empty() ? no_node : static_cast<node_index>(kinds.size() - 1);
+		}
+
+		/**
+		 * Appends a node, its children must be the nodes appended since its subtree began.
+		 *
+		 * @param kind kind of node.
+		 * @param first index of the first node in its subtree, equal to size() for a leaf.
+		 * @param value data of node.
+		 * @param range range of source text the node spans.
+		 * @param type evaluated type, or null.
+		 * @returns index of node.
+		 */
+		node_index add(const node_kind kind, const std::size_t first, const std::uint32_t value, const utils::position_range range,
+			ast::type* type = nullptr)
+		{
+			const auto index = static_cast<node_index>(kinds.size());
+
+			// Each child's subtree ends right before the next child, so the children are found back to front by size.
+			const auto children_begin = children.size();
+			for (auto end = index; end > first; end -= sizes[end - 1])
+			{
+				children.push_back(end - 1);
+			}
+			std::reverse(children.begin() + static_cast<std::ptrdiff_t>(children_begin), children.end());
+			child_offsets.push_back(static_cast<std::uint32_t>(children.size()));
+
+			kinds.push_back(kind);
+			sizes.push_back(static_cast<std::uint32_t>(index - first + 1));
+			data.push_back(value);
+			types.push_back(type);
+			ranges.push_back(range);
+			return index;
+		}
+
+		/**
+		 * Returns the number of children of a node.
+		 *
+		 * @param index index of node.
+		 * @returns number of children.
+		 */
+		[[nodiscard]] std::size_t child_count(const node_index index) const
+		{
+			return child_offsets[index + 1] - child_offsets[index];
+		}
+
+		/**
+		 * Returns a child of a node.
+		 *
+		 * @param index index of node.
+		 * @param position position of child, counted from the first.
+		 * @returns index of child, no_node if there are not that many children.
+		 */
+		[[nodiscard]] node_index child(const node_index index, const std::size_t position) const
+		{
+			return position < child_count(index) ? children[child_offsets[index] + position] : no_node;
+		}
+	};
+
+	/**
+	 * Builds the flat form of a tree.
+	 *
+	 * @param root root of tree.
+	 * @returns flat tree.
+	 */
+	tree flatten(ast::node* root);
+
+	/**
+	 * Builds the pointer form of a flat tree.
+	 *
+	 * @param source flat tree.
+	 * @param arena arena to allocate the nodes in, usually the module's.
+	 * @returns root of the new tree, null if source is empty.
+	 */
+	ast::node* unflatten(const tree& source, utils::arena& arena);
+}
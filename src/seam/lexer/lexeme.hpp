@@ -1,9 +1,14 @@
 #pragma once
 
+#include "../utils/interner.hpp"
 #include "../utils/position.hpp"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
+#include <variant>
 
 namespace seam::lexer
 {
@@ -68,64 +73,166 @@ namespace seam::lexer
 		kw_elseif,
 		kw_else,
 		kw_extern,
+		kw_import,
 	};
 
-	static bool is_operator(lexeme_type type)
+	/**
+	 * Number of lexeme types, keep in sync with the last enumerator.
+	 */
+	constexpr std::size_t lexeme_type_count = static_cast<std::size_t>(lexeme_type::kw_import) + 1;
+
+	/**
+	 * How a lexeme type behaves inside an expression.
+	 *
+	 * Binding powers drive the precedence climbing loop of the parser, an
+	 * operator binds its left operand with left and its right operand with
+	 * right, so right > left makes it right associative.
+	 */
+	struct operator_info
+	{
+		std::uint8_t left = 0; // 0 when not a binary operator
+		std::uint8_t right = 0;
+		bool is_operator = false;
+		bool is_unary = false;
+	};
+
+	/**
+	 * Binding power of unary operators, higher than that of any binary operator.
+	 */
+	constexpr std::uint8_t unary_priority = 8;
+
+	/**
+	 * Operator properties of every lexeme type, indexed by type.
+	 */
+	constexpr auto operator_table = []
 	{
-		switch(type)
+		std::array<operator_info, lexeme_type_count> table{};
+
+		const auto set = [&table](const lexeme_type type, const operator_info info)
 		{
-			case lexeme_type::symbol_divide:
-			case lexeme_type::symbol_divide_assign:
-			case lexeme_type::symbol_add:
-			case lexeme_type::symbol_add_assign:
-			case lexeme_type::symbol_minus:
-			case lexeme_type::symbol_minus_assign:
-			case lexeme_type::symbol_multiply:
-			case lexeme_type::symbol_multiply_assign:
-			case lexeme_type::symbol_eq:
-			case lexeme_type::symbol_neq:
-			case lexeme_type::symbol_lt:
-			case lexeme_type::symbol_lteq:
-			case lexeme_type::symbol_gt:
-			case lexeme_type::symbol_gteq:
-			case lexeme_type::symbol_not:
-			case lexeme_type::symbol_mod:
-			{
-				return true;
-			}
-			default:
-			{
-				return false;
-			}
-		}
+			table[static_cast<std::size_t>(type)] = info;
+		};
+
+		set(lexeme_type::symbol_add, { 6, 6, true, false });
+		set(lexeme_type::symbol_minus, { 6, 6, true, true });
+		set(lexeme_type::symbol_multiply, { 7, 7, true, false });
+		set(lexeme_type::symbol_divide, { 7, 7, true, false });
+		set(lexeme_type::symbol_mod, { 7, 7, true, false });
+
+		// comparison operators
+		set(lexeme_type::symbol_eq, { 3, 3, true, false });
+		set(lexeme_type::symbol_neq, { 3, 3, true, false });
+		set(lexeme_type::symbol_lt, { 3, 3, true, false });
+		set(lexeme_type::symbol_lteq, { 3, 3, true, false });
+		set(lexeme_type::symbol_gt, { 3, 3, true, false });
+		set(lexeme_type::symbol_gteq, { 3, 3, true, false });
+
+		// logical operators
+		set(lexeme_type::symbol_and, { 2, 2, false, false });
+		set(lexeme_type::symbol_or, { 1, 1, false, false });
+		set(lexeme_type::symbol_not, { 0, 0, true, true });
+
+		// compound assignments are operators, but never appear inside an expression
+		set(lexeme_type::symbol_divide_assign, { 0, 0, true, false });
+		set(lexeme_type::symbol_add_assign, { 0, 0, true, false });
+		set(lexeme_type::symbol_minus_assign, { 0, 0, true, false });
+		set(lexeme_type::symbol_multiply_assign, { 0, 0, true, false });
+
+		return table;
+	}();
+
+	/**
+	 * Returns the operator properties of a lexeme type.
+	 *
+	 * @param type lexeme type.
+	 * @returns operator properties, all zero for types which are not operators.
+	 */
+	constexpr const operator_info& operator_of(const lexeme_type type)
+	{
+		return operator_table[static_cast<std::size_t>(type)];
 	}
 
-	static bool is_unary_operator(lexeme_type type)
+	constexpr bool is_operator(const lexeme_type type)
 	{
-		switch (type)
-		{
-			case lexeme_type::symbol_minus:
-			case lexeme_type::symbol_not:
-			{
-				return true;
-			}
-			default:
-			{
-				return false;
-			}
-		}
+		return operator_of(type).is_operator;
+	}
+
+	constexpr bool is_unary_operator(const lexeme_type type)
+	{
+		return operator_of(type).is_unary;
 	}
 
-	static bool is_binary_operator(lexeme_type type)
+	constexpr bool is_binary_operator(const lexeme_type type)
 	{
 		return is_operator(type) && !is_unary_operator(type);
 	}
+
+	static_assert(operator_of(lexeme_type::symbol_multiply).left > operator_of(lexeme_type::symbol_add).left);
+	static_assert(!is_binary_operator(lexeme_type::symbol_minus) && is_unary_operator(lexeme_type::symbol_not));
+
+	/**
+	 * Type suffix of a number literal, e.g. the u8 of 255u8.
+	 */
+	enum class number_suffix : std::uint8_t
+	{
+		none,
+		i8,
+		i16,
+		i32,
+		i64,
+		u8,
+		u16,
+		u32,
+		u64,
+		f32,
+		f64,
+	};
+
+	/**
+	 * Returns the name of the type a suffix stands for.
+	 *
+	 * @param suffix number suffix.
+	 * @returns type name, empty for no suffix.
+	 */
+	constexpr std::string_view to_string(const number_suffix suffix)
+	{
+		switch (suffix)
+		{
+			case number_suffix::i8: return "i8";
+			case number_suffix::i16: return "i16";
+			case number_suffix::i32: return "i32";
+			case number_suffix::i64: return "i64";
+			case number_suffix::u8: return "u8";
+			case number_suffix::u16: return "u16";
+			case number_suffix::u32: return "u32";
+			case number_suffix::u64: return "u64";
+			case number_suffix::f32: return "f32";
+			case number_suffix::f64: return "f64";
+			default: return {};
+		}
+	}
+
+	/**
+	 * Value of a number literal, parsed once while lexing.
+	 */
+	struct number_value
+	{
+		std::variant<std::uint64_t, double> value {};
+		number_suffix suffix = number_suffix::none;
+
+		bool operator==(const number_value& other) const
+		{
+			return value == other.value && suffix == other.suffix;
+		}
+	};
 	
 	struct lexeme
 	{
 		lexeme_type type = lexeme_type::eof;
 		std::string_view value {};
 		utils::position position { 0, 0 };
+		utils::symbol_id symbol = utils::no_symbol; // interned value of identifiers, if the lexer interns them
+		number_value number {}; // parsed value of number literals
 
 		/**
 		 * Returns string which corresponds with type.
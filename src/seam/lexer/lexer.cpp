@@ -1,17 +1,24 @@
 #include "lexer.hpp"
 #include "../utils/exception.hpp"
-
+#include "../utils/perfect_hash.hpp"
+#include "../utils/simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <future>
+#include <optional>
 #include <sstream>
-#include <cctype>
+#include <string>
+#include <system_error>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
+#include <cctype>
 #include <iostream>
 
 namespace seam::lexer
 {
-	using lexeme_map_t = std::unordered_map<std::string_view, lexeme_type>;
-	const lexeme_map_t keyword_map
-	{
+	constexpr auto keyword_map = utils::make_perfect_hash_map<lexeme_type, 64>({
 		{ "fn", lexeme_type::kw_fn },
 		{ "as", lexeme_type::kw_as },
 		{ "return", lexeme_type::kw_return },
@@ -28,115 +35,188 @@ namespace seam::lexer
 		{ "elseif", lexeme_type::kw_elseif },
 		{ "else", lexeme_type::kw_else },
 		{ "extern", lexeme_type::kw_extern },
-	};
+		{ "import", lexeme_type::kw_import },
+	});
 
-	const lexeme_map_t symbol_map
-	{
-		{ "+", lexeme_type::symbol_add },
+	// Symbols which are two characters long, single character symbols live in single_symbol_table.
+	constexpr auto symbol_map = utils::make_perfect_hash_map<lexeme_type, 32>({
 		{ "+=", lexeme_type::symbol_add_assign },
-		{ "-", lexeme_type::symbol_minus },
 		{ "-=", lexeme_type::symbol_minus_assign },
-		{ "*", lexeme_type::symbol_multiply },
 		{ "*=", lexeme_type::symbol_multiply_assign },
-		{ "%", lexeme_type::symbol_mod },
-		{ "(", lexeme_type::symbol_open_parenthesis },
-		{ ")", lexeme_type::symbol_close_parenthesis },
-		{ "[", lexeme_type::symbol_open_bracket },
-		{ "]", lexeme_type::symbol_close_bracket },
-		{ "{", lexeme_type::symbol_open_brace },
-		{ "}", lexeme_type::symbol_close_brace },
 		{ "->", lexeme_type::symbol_arrow },
-		{ "=", lexeme_type::symbol_equals },
-		{ "!", lexeme_type::symbol_not },
-		{ "?", lexeme_type::symbol_question_mark },
-		{ ":", lexeme_type::symbol_colon },
 		{ ":=", lexeme_type::symbol_colon_equals },
-		{ ",", lexeme_type::symbol_comma },
 		{ "==", lexeme_type::symbol_eq },
 		{ "!=", lexeme_type::symbol_neq },
-		{ "<", lexeme_type::symbol_lt },
 		{ "<=", lexeme_type::symbol_lteq },
-		{ ">", lexeme_type::symbol_gt },
 		{ ">=", lexeme_type::symbol_gteq },
 		{ "&&", lexeme_type::symbol_and },
 		{ "||", lexeme_type::symbol_or },
-	};
+	});
 
-	const std::unordered_set<std::string> attributes = { "constructor", "export" };
+	// Symbol type for every single character symbol, indexed by character, eof if the character is not a symbol.
+	constexpr auto single_symbol_table = []()
+	{
+		std::array<lexeme_type, 256> table{};
+		table['+'] = lexeme_type::symbol_add;
+		table['-'] = lexeme_type::symbol_minus;
+		table['*'] = lexeme_type::symbol_multiply;
+		table['%'] = lexeme_type::symbol_mod;
+		table['('] = lexeme_type::symbol_open_parenthesis;
+		table[')'] = lexeme_type::symbol_close_parenthesis;
+		table['['] = lexeme_type::symbol_open_bracket;
+		table[']'] = lexeme_type::symbol_close_bracket;
+		table['{'] = lexeme_type::symbol_open_brace;
+		table['}'] = lexeme_type::symbol_close_brace;
+		table['='] = lexeme_type::symbol_equals;
+		table['!'] = lexeme_type::symbol_not;
+		table['?'] = lexeme_type::symbol_question_mark;
+		table[':'] = lexeme_type::symbol_colon;
+		table[','] = lexeme_type::symbol_comma;
+		table['<'] = lexeme_type::symbol_lt;
+		table['>'] = lexeme_type::symbol_gt;
+		return table;
+	}();
+
+	constexpr auto attributes = utils::make_perfect_hash_map<bool, 4>({
+		{ "constructor", true },
+		{ "export", true },
+	});
 	
-	bool is_start_identifier_char(const char value)
+	constexpr auto number_suffixes = utils::make_perfect_hash_map<number_suffix, 32>({
+		{ "i8", number_suffix::i8 },
+		{ "i16", number_suffix::i16 },
+		{ "i32", number_suffix::i32 },
+		{ "i64", number_suffix::i64 },
+		{ "u8", number_suffix::u8 },
+		{ "u16", number_suffix::u16 },
+		{ "u32", number_suffix::u32 },
+		{ "u64", number_suffix::u64 },
+		{ "f32", number_suffix::f32 },
+		{ "f64", number_suffix::f64 },
+	});
+
+	/**
+	 * Returns the largest value an integer suffix allows.
+	 *
+	 * Literals are never negative, a leading minus is lexed as a separate operator.
+	 *
+	 * @param suffix integer suffix, or none.
+	 * @returns largest allowed value.
+	 */
+	constexpr std::uint64_t max_integer_value(const number_suffix suffix)
 	{
-		return std::isalpha(value) || value == '_';
+		switch (suffix)
+		{
+			case number_suffix::i8: return INT8_MAX;
+			case number_suffix::i16: return INT16_MAX;
+			case number_suffix::i32: return INT32_MAX;
+			case number_suffix::i64: return INT64_MAX;
+			case number_suffix::u8: return UINT8_MAX;
+			case number_suffix::u16: return UINT16_MAX;
+			case number_suffix::u32: return UINT32_MAX;
+			default: return UINT64_MAX;
+		}
 	}
 
-	bool is_identifier_char(const char value)
+	/**
+	 * Parses the digits of a number literal with std::from_chars, skipping digit separators.
+	 *
+	 * @param digits digits to parse, may contain '_' separators.
+	 * @param value parsed value.
+	 * @param args base for integers, format for floats.
+	 * @returns std::errc{} on success, result_out_of_range if the value does
+	 *          not fit, invalid_argument if the digits are malformed.
+	 */
+	template <typename T, typename... Args>
+	std::errc parse_digits(const std::string_view digits, T& value, const Args... args)
 	{
-		return std::isalnum(value) || value == '_';
+		const auto parse = [&](const char* first, const char* last)
+		{
+			const auto [end, error] = std::from_chars(first, last, value, args...);
+			return error == std::errc{} && end != last ? std::errc::invalid_argument : error;
+		};
+
+		if (digits.find('_') == std::string_view::npos) // Common case, parse straight from the source.
+		{
+			return parse(digits.data(), digits.data() + digits.length());
+		}
+
+		// Strip separators into a buffer on the stack, unless the literal is unusually long.
+		std::array<char, 64> stack_buffer;
+		std::string heap_buffer;
+		auto buffer = stack_buffer.data();
+		if (digits.length() > stack_buffer.size())
+		{
+			heap_buffer.resize(digits.length());
+			buffer = heap_buffer.data();
+		}
+
+		const auto last = std::remove_copy(digits.cbegin(), digits.cend(), buffer, '_');
+		return parse(buffer, last);
 	}
 
-	bool is_keyword_char(const char value)
+	bool is_start_identifier_char(const char value)
 	{
-		return value != '_' && !std::isupper(value);
+		return std::isalpha(value) || value == '_';
 	}
+
+	constexpr std::size_t max_keyword_length = 6;
 	
 	utils::position lexer::current_position() const
 	{
-		return { line_, read_offset_ - line_start_offset_ };
+		return { static_cast<std::uint32_t>(read_offset_), file_id_ };
 	}
 	
+	char lexer::character_at(const std::size_t offset) const
+	{
+		return offset >= source_.length() ? eof_character : source_[offset];
+	}
+
 	char lexer::peek_character(const std::size_t offset) const
 	{
-		return read_offset_ + offset >= source_.length() ? eof_character: source_[read_offset_ + offset];
+		return character_at(read_offset_ + offset);
 	}
 	
 	void lexer::consume_character()
 	{
-		if (peek_character() == '\n')
-		{
-			++line_;
-			line_start_offset_ = read_offset_;
-		}
 		++read_offset_;
 	}
 
 	void lexer::skip_whitespace()
 	{
-		char next_character;
-		while ((next_character = peek_character()) != eof_character && std::isspace(next_character))
-		{
-			consume_character();
-		}
+		read_offset_ = utils::simd::skip_whitespace(source_, read_offset_);
 	}
 
-	void lexer::skip_comment(lexeme& ref)
+	void lexer::skip_comment()
 	{
-		consume_character();
-		const auto is_long_comment = peek_character() == '/';
+		// Consume //.
+		read_offset_ += 2;
+
+		if (peek_character() != '/') // Line comment, runs until (and including) the next newline.
+		{
+			const auto end_offset = utils::simd::find(source_, read_offset_, '\n');
+			read_offset_ = end_offset == source_.length() ? end_offset : end_offset + 1;
+			return;
+		}
 
+		// Long comment, runs until the next ///.
+		auto search_offset = read_offset_;
 		while (true)
 		{
-			const auto next_character = peek_character();
-			if (!is_long_comment && next_character == '\n')
+			const auto slash_offset = utils::simd::find(source_, search_offset, '/');
+			if (slash_offset == source_.length())
 			{
-				consume_character();
-				return;
+				read_offset_ = slash_offset;
+				throw utils::lexical_exception { current_position(), "unterminated long comment" };
 			}
 
-			// There has got to be a better way to do this...
-			if (is_long_comment && next_character == '/' && peek_character(1) == '/' && peek_character(2) == '/')
+			if (character_at(slash_offset + 1) == '/' && character_at(slash_offset + 2) == '/')
 			{
-				consume_character();
-				consume_character();
-				consume_character();
+				read_offset_ = slash_offset + 3;
 				return;
 			}
 
-			if (is_long_comment && next_character == eof_character)
-			{
-				throw utils::lexical_exception { current_position(), "unterminated long comment" };
-			}
-
-			consume_character();
+			search_offset = slash_offset + 1;
 		}
 	}
 
@@ -144,24 +224,26 @@ namespace seam::lexer
 	{
 		consume_character();
 		const auto start_offset = read_offset_;
-		
+
+		auto search_offset = read_offset_;
 		while (true)
 		{
-			if (peek_character() == '\\' && peek_character(1) == '"') // String escape
+			const auto match_offset = utils::simd::find_either(source_, search_offset, '"', '\\');
+			if (match_offset == source_.length())
 			{
-				consume_character();
-				consume_character();
-				continue;
+				read_offset_ = match_offset;
+				throw utils::lexical_exception{ current_position(), "unterminated string literal" };
 			}
 
-			if (peek_character() == '"')
+			if (source_[match_offset] == '\\') // String escape
 			{
-				ref.value = source_.substr(start_offset, read_offset_ - start_offset);
-				consume_character();
-				return;
+				search_offset = match_offset + (character_at(match_offset + 1) == '"' ? 2 : 1);
+				continue;
 			}
 
-			consume_character();
+			ref.value = source_.substr(start_offset, match_offset - start_offset);
+			read_offset_ = match_offset + 1;
+			return;
 		}
 	}
 
@@ -206,43 +288,91 @@ namespace seam::lexer
 			}
 		}
 
-		ref.value = source_.substr(start_offset, read_offset_ - start_offset);
-		ref.type = lexeme_type::literal_number;
-	}
+		const auto digits_start = start_offset + (is_hex ? 2 : 0);
+		const auto digits = source_.substr(digits_start, read_offset_ - digits_start);
 
-	void lexer::lex_keyword_or_identifier(lexeme& ref)
-	{
-		auto can_be_keyword = is_keyword_char(peek_character());
-
-		const auto start_offset = read_offset_;
-		consume_character();
-
-		while (true)
+		// Suffix, which must directly follow the digits.
+		auto suffix = number_suffix::none;
+		if (is_start_identifier_char(peek_character()))
 		{
-			const auto next_char = peek_character();
+			const auto suffix_offset = read_offset_;
+			read_offset_ = utils::simd::skip_identifier(source_, suffix_offset + 1);
 
-			if (!is_keyword_char(next_char))
+			const auto suffix_name = source_.substr(suffix_offset, read_offset_ - suffix_offset);
+			const auto found_suffix = number_suffixes.find(suffix_name);
+			if (!found_suffix)
 			{
-				can_be_keyword = false;
+				std::stringstream error_message;
+				error_message << "unknown number suffix: '" << suffix_name << "'";
+				throw utils::lexical_exception{ utils::position{ static_cast<std::uint32_t>(suffix_offset), file_id_ }, error_message.str() };
 			}
+			suffix = *found_suffix;
+		}
+
+		const auto start_position = utils::position{ static_cast<std::uint32_t>(start_offset), file_id_ };
+		const auto is_float_suffix = suffix == number_suffix::f32 || suffix == number_suffix::f64;
+		if (is_float && suffix != number_suffix::none && !is_float_suffix)
+		{
+			throw utils::lexical_exception{ start_position, "floating point literal cannot have an integer suffix" };
+		}
+		if (is_hex && is_float_suffix)
+		{
+			throw utils::lexical_exception{ start_position, "hexadecimal literal cannot have a floating point suffix" };
+		}
 
-			if (!is_identifier_char(next_char))
+		std::errc error;
+		if (is_float || is_float_suffix)
+		{
+			double value;
+			error = parse_digits(digits, value, std::chars_format::fixed);
+			ref.number.value = value;
+		}
+		else
+		{
+			std::uint64_t value;
+			error = parse_digits(digits, value, is_hex ? 16 : 10);
+			if (error == std::errc{} && value > max_integer_value(suffix))
 			{
-				ref.type = lexeme_type::identifier;
-				ref.value = source_.substr(start_offset, read_offset_ - start_offset);
-				break;
+				error = std::errc::result_out_of_range;
 			}
+			ref.number.value = value;
+		}
 
-			consume_character();
+		if (error == std::errc::result_out_of_range)
+		{
+			throw utils::lexical_exception{ start_position, "number literal out of range" };
+		}
+		if (error != std::errc{})
+		{
+			throw utils::lexical_exception{ start_position, "malformed number" };
 		}
 
-		if (can_be_keyword)
+		ref.number.suffix = suffix;
+		ref.value = source_.substr(start_offset, read_offset_ - start_offset);
+		ref.type = lexeme_type::literal_number;
+	}
+
+	void lexer::lex_keyword_or_identifier(lexeme& ref)
+	{
+		const auto start_offset = read_offset_;
+		read_offset_ = utils::simd::skip_identifier(source_, start_offset + 1);
+
+		ref.type = lexeme_type::identifier;
+		ref.value = source_.substr(start_offset, read_offset_ - start_offset);
+
+		if (ref.value.length() <= max_keyword_length)
 		{
-			if (const auto keyword_type = keyword_map.find(source_.substr(start_offset, read_offset_ - start_offset)); keyword_type != keyword_map.cend())
+			if (const auto keyword_type = keyword_map.find(ref.value))
 			{
-				ref.type = keyword_type->second;
+				ref.type = *keyword_type;
+				return;
 			}
 		}
+
+		if (intern_identifiers_)
+		{
+			ref.symbol = symbols_.intern(ref.value);
+		}
 	}
 
 	void lexer::lex_attribute(lexeme& ref)
@@ -259,65 +389,77 @@ namespace seam::lexer
 			};
 		}
 
-		consume_character();
+		read_offset_ = utils::simd::skip_identifier(source_, start_offset + 1);
+		ref.type = lexeme_type::attribute;
 
-		while (true)
+		const auto proposed_attribute = source_.substr(start_offset, read_offset_ - start_offset);
+		if (!attributes.find(proposed_attribute))
 		{
-			const auto next_char = peek_character();
-
-			if (!is_identifier_char(next_char))
-			{
-				ref.type = lexeme_type::attribute;
-
-				const auto proposed_attribute = source_.substr(start_offset, read_offset_ - start_offset);
-				if (attributes.find(std::string{ proposed_attribute }) == attributes.cend())
-				{
-					std::stringstream error_message;
-					error_message << "unknown attribute: '" << proposed_attribute << "'";
-					throw utils::lexical_exception{ current_position(), error_message.str() };
-				}
-
-				ref.value = proposed_attribute;
-				break;
-			}
-
-			consume_character();
+			std::stringstream error_message;
+			error_message << "unknown attribute: '" << proposed_attribute << "'";
+			throw utils::lexical_exception{ current_position(), error_message.str() };
 		}
+
+		ref.value = proposed_attribute;
 	}
 
 	void lexer::lex_symbol(lexeme& ref)
 	{
-		// TODO: REFACTOR THIS
 		const auto start_offset = read_offset_;
 
-		consume_character();
-		lexeme_map_t::const_iterator symbol;
-		if (peek_character(1) != eof_character && (symbol = symbol_map.find(source_.substr(start_offset, 2))) != symbol_map.cend())
+		if (peek_character(1) != eof_character)
 		{
-			consume_character();
-			ref.type = symbol->second;
-		}
-		else if (symbol = symbol_map.find(source_.substr(start_offset, 1)); symbol != symbol_map.cend())
-		{
-			ref.type = symbol->second;
+			if (const auto symbol = symbol_map.find(source_.substr(start_offset, 2)))
+			{
+				consume_character();
+				consume_character();
+				ref.type = *symbol;
+				return;
+			}
 		}
-		else
+
+		const auto symbol = single_symbol_table[static_cast<std::uint8_t>(peek_character())];
+		if (symbol == lexeme_type::eof)
 		{
+			consume_character();
 			throw utils::lexical_exception{
 				current_position(),
 				"unexpected symbol"
 			};
 		}
+
+		consume_character();
+		ref.type = symbol;
 	}
 	
-	lexer::lexer(std::shared_ptr<types::module> current_module, const std::string_view& source)
-		: current_module(current_module), source_(source) {}
+	lexer::lexer(std::shared_ptr<types::module> current_module, const std::string_view& source, const std::uint32_t file_id,
+		const bool intern_identifiers)
+		: current_module(current_module), source_(source), file_id_(file_id), intern_identifiers_(intern_identifiers),
+		symbols_(current_module->symbols)
+	{
+		if (source_.length() > UINT32_MAX)
+		{
+			throw utils::lexical_exception{ current_position(), "source is too large, files must be under 4 GiB" };
+		}
+	}
 
 
 
 	void lexer::lex(lexeme& ref)
 	{
-		skip_whitespace();
+		ref.symbol = utils::no_symbol; // The streaming interface reuses lexemes.
+
+		while (true)
+		{
+			skip_whitespace();
+
+			if (peek_character() != '/' || peek_character(1) != '/')
+			{
+				break;
+			}
+
+			skip_comment();
+		}
 
 		ref.position = current_position();
 
@@ -328,19 +470,10 @@ namespace seam::lexer
 				ref.type = lexeme_type::eof;
 				break;
 			}
-			case '/': // Comment or division operations.
+			case '/': // Division operations, comments have already been skipped.
 			{
 				consume_character();
-				const auto next_character = peek_character();
-
-				if (next_character == '/') // Is a comment.
-				{
-					skip_comment(ref);
-					next_lexeme();
-					break;
-				}
-
-				if (next_character == '=') // Divide-Assign operator.
+				if (peek_character() == '=') // Divide-Assign operator.
 				{
 					consume_character();
 					ref.type = lexeme_type::symbol_divide_assign;
@@ -402,4 +535,234 @@ namespace seam::lexer
 			lex(*current_);
 		}
 	}
-}
+
+	token_buffer lexer::tokenize()
+	{
+		token_buffer buffer{ source_, file_id_ };
+		buffer.reserve((source_.length() - read_offset_) / 8); // Rough guess at lexeme density, avoids most regrowth.
+
+		lexeme ref;
+		do
+		{
+			ref = lexeme{};
+			lex(ref);
+			buffer.push_back(ref);
+		} while (ref.type != lexeme_type::eof);
+
+		return buffer;
+	}
+
+	/**
+	 * Checks whether a chunk of source can start at an offset, i.e. whether a top-level
+	 * definition starts there.
+	 *
+	 * @param source source being split.
+	 * @param offset offset just after a newline.
+	 * @returns whether offset starts with fn, type or extern.
+	 */
+	bool is_chunk_start(const std::string_view source, const std::size_t offset)
+	{
+		for (const auto keyword : { std::string_view{ "fn" }, std::string_view{ "type" }, std::string_view{ "extern" } })
+		{
+			const auto keyword_end = offset + keyword.length();
+			if (source.compare(offset, keyword.length(), keyword) == 0
+				&& (keyword_end == source.length() || !utils::simd::is_identifier(source[keyword_end])))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Splits a source into chunks of roughly equal size.
+	 *
+	 * @param source source to split.
+	 * @param chunk_size approximate size of each chunk.
+	 * @returns offsets every chunk starts at, followed by the length of source.
+	 */
+	std::vector<std::size_t> find_chunk_boundaries(const std::string_view source, const std::size_t chunk_size)
+	{
+		std::vector<std::size_t> boundaries{ 0 };
+
+		auto offset = chunk_size;
+		while (offset < source.length())
+		{
+			const auto newline_offset = utils::simd::find(source, offset, '\n');
+			if (newline_offset == source.length())
+			{
+				break;
+			}
+
+			offset = newline_offset + 1;
+			if (is_chunk_start(source, offset))
+			{
+				boundaries.push_back(offset);
+				offset += chunk_size;
+			}
+		}
+
+		boundaries.push_back(source.length());
+		return boundaries;
+	}
+
+	token_buffer lexer::tokenize_chunk(const std::size_t begin, const std::size_t end, utils::interner* symbols) const
+	{
+		// A prefix of the source shares its data pointer, so offsets stay absolute.
+		lexer chunk_lexer{ current_module, source_.substr(0, end), file_id_, symbols != nullptr };
+		chunk_lexer.read_offset_ = begin;
+		if (symbols)
+		{
+			chunk_lexer.symbols_ = utils::symbol_cache{ *symbols };
+		}
+		return chunk_lexer.tokenize();
+	}
+
+	token_buffer lexer::tokenize(utils::thread_pool& pool, const std::size_t chunk_size)
+	{
+		const auto boundaries = find_chunk_boundaries(source_, chunk_size);
+		const auto chunk_count = boundaries.size() - 1;
+		if (chunk_count == 1 || pool.size() == 1)
+		{
+			return tokenize();
+		}
+
+		// Interning straight into the module would number symbols in whichever order chunks get to them.
+		std::vector<std::unique_ptr<utils::interner>> chunk_symbols(chunk_count);
+		if (intern_identifiers_)
+		{
+			for (auto& symbols : chunk_symbols)
+			{
+				symbols = std::make_unique<utils::interner>();
+			}
+		}
+
+		std::vector<std::future<token_buffer>> pending_chunks;
+		pending_chunks.reserve(chunk_count);
+		for (std::size_t i = 0; i < chunk_count; ++i)
+		{
+			pending_chunks.push_back(pool.submit([this, begin = boundaries[i], end = boundaries[i + 1], symbols = chunk_symbols[i].get()]()
+			{
+				return tokenize_chunk(begin, end, symbols);
+			}));
+		}
+
+		// Tasks reference this lexer, so every one must finish before returning or throwing.
+		struct wait_for_chunks
+		{
+			utils::thread_pool& pool;
+			std::vector<std::future<token_buffer>>& chunks;
+
+			~wait_for_chunks()
+			{
+				for (const auto& chunk : chunks)
+				{
+					if (chunk.valid())
+					{
+						pool.wait(chunk);
+					}
+				}
+			}
+		} wait_guard{ pool, pending_chunks };
+
+		// Rethrows unless the chunk ending at end stopped at end inside a string or comment.
+		const auto check_chunk_error = [&](const utils::lexical_exception& ex, const std::size_t end_index)
+		{
+			if (end_index == chunk_count || ex.position.offset != boundaries[end_index])
+			{
+				throw ex;
+			}
+		};
+
+		std::vector<token_buffer> chunks;
+		std::vector<const utils::interner*> chunk_tables; // table each chunk interned into
+		chunks.reserve(chunk_count);
+		chunk_tables.reserve(chunk_count);
+
+		// Only a chunk starting where the previous valid chunk ended is known to start between lexemes.
+		for (std::size_t chunk_index = 0; chunk_index < chunk_count;)
+		{
+			auto end_index = chunk_index + 1;
+
+			std::optional<token_buffer> chunk;
+			try
+			{
+				// Lexing from a worker, as when building several modules, would otherwise hold it up.
+				pool.wait(pending_chunks[chunk_index]);
+				chunk = pending_chunks[chunk_index].get();
+			}
+			catch (const utils::lexical_exception& ex)
+			{
+				check_chunk_error(ex, end_index);
+			}
+
+			while (!chunk)
+			{
+				++end_index;
+				try
+				{
+					chunk = tokenize_chunk(boundaries[chunk_index], boundaries[end_index], chunk_symbols[chunk_index].get());
+				}
+				catch (const utils::lexical_exception& ex)
+				{
+					check_chunk_error(ex, end_index);
+				}
+			}
+
+			chunks.push_back(std::move(*chunk));
+			chunk_tables.push_back(chunk_symbols[chunk_index].get());
+			chunk_index = end_index;
+		}
+
+		// Stitch chunks together, dropping the eof lexeme ending every chunk but the last.
+		token_buffer buffer{ source_, file_id_ };
+
+		std::size_t lexeme_count = 1;
+		std::size_t number_count = 0;
+		for (const auto& chunk : chunks)
+		{
+			lexeme_count += chunk.size() - 1;
+			number_count += chunk.numbers.size();
+		}
+		buffer.reserve(lexeme_count);
+		buffer.numbers.reserve(number_count);
+
+		for (std::size_t i = 0; i < chunks.size(); ++i)
+		{
+			const auto& chunk = chunks[i];
+			const auto count = static_cast<std::ptrdiff_t>(i + 1 == chunks.size() ? chunk.size() : chunk.size() - 1);
+
+			buffer.types.insert(buffer.types.end(), chunk.types.cbegin(), chunk.types.cbegin() + count);
+			buffer.offsets.insert(buffer.offsets.end(), chunk.offsets.cbegin(), chunk.offsets.cbegin() + count);
+			buffer.lengths.insert(buffer.lengths.end(), chunk.lengths.cbegin(), chunk.lengths.cbegin() + count);
+			// Number literals index into the numbers of their chunk, rebase them onto the stitched buffer.
+			// Identifiers are renumbered into the module in source order, as the serial tokenize numbers them.
+			const auto number_base = static_cast<std::uint32_t>(buffer.numbers.size());
+			std::unordered_map<utils::symbol_id, utils::symbol_id> renumbered;
+			for (std::ptrdiff_t j = 0; j < count; ++j)
+			{
+				const auto symbol = chunk.symbols[j];
+				if (chunk.type(j) == lexeme_type::literal_number)
+				{
+					buffer.symbols.push_back(symbol + number_base);
+				}
+				else if (symbol != utils::no_symbol)
+				{
+					const auto [it, inserted] = renumbered.try_emplace(symbol);
+					if (inserted)
+					{
+						it->second = current_module->symbols.intern(chunk_tables[i]->name(symbol));
+					}
+					buffer.symbols.push_back(it->second);
+				}
+				else
+				{
+					buffer.symbols.push_back(symbol);
+				}
+			}
+			buffer.numbers.insert(buffer.numbers.end(), chunk.numbers.cbegin(), chunk.numbers.cend());
+		}
+
+		return buffer;
+	}
+}
\ No newline at end of file
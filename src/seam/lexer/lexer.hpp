@@ -1,8 +1,10 @@
 #pragma once
 
 #include "lexeme.hpp"
+#include "token_buffer.hpp"
 #include "../utils/position.hpp"
 #include "../types/module.hpp"
+#include "../utils/thread_pool.hpp"
 
 #include <memory>
 #include <optional>
@@ -15,24 +17,29 @@ namespace seam::lexer
 	class lexer
 	{
 		constexpr static char eof_character = -1;
+		constexpr static std::size_t default_chunk_size = 256 * 1024;
 
 		std::shared_ptr<types::module> current_module;
 
 		std::string_view source_;
 
+		std::uint32_t file_id_;
+
+		bool intern_identifiers_; // whether identifiers are interned as they are lexed.
+		utils::symbol_cache symbols_;
+
 		std::size_t read_offset_ = 0;
-		std::size_t line_ = 1;
-		std::size_t line_start_offset_ = 0;
 		
 		std::optional<lexeme> current_;
 		std::optional<lexeme> peeked_lexeme_;
 
 		[[nodiscard]] utils::position current_position() const;
+		[[nodiscard]] char character_at(std::size_t offset) const;
 		[[nodiscard]] char peek_character(std::size_t offset = 0) const;
 		void consume_character();
 		
 		void skip_whitespace();
-		void skip_comment(lexeme& ref);
+		void skip_comment();
 		void lex_string_literal(lexeme& ref);
 		void lex_number_literal(lexeme& ref);
 		void lex_keyword_or_identifier(lexeme& ref);
@@ -40,13 +47,30 @@ namespace seam::lexer
 		void lex_symbol(lexeme& ref);
 
 		void lex(lexeme& ref);
+
+		/**
+		 * Lexes the part of the source between two offsets into a token buffer.
+		 *
+		 * @param begin offset to start lexing at.
+		 * @param end offset to stop lexing at, lexed as the end of the source.
+		 * @param symbols table of the chunk to intern identifiers into, or null not to intern them.
+		 * @return buffer of lexemes, ending with eof at end.
+		 */
+		[[nodiscard]] token_buffer tokenize_chunk(std::size_t begin, std::size_t end, utils::interner* symbols) const;
 	public:
 		/**
 		 * Initialise lexer with source to lex.
 		 *
+		 * Identifiers are only given symbol ids when intern_identifiers is set, as
+		 * hashing every identifier costs close to half of the lexing throughput.
+		 *
 		 * @param source source to lex.
+		 * @param file_id id of the source file, stamped on every position.
+		 * @param intern_identifiers whether to intern identifiers into the symbols of the module.
+		 * @throws lexical_exception if the source is too large for 32-bit offsets.
 		 */
-		explicit lexer(std::shared_ptr<types::module> current_module, const std::string_view& source);
+		explicit lexer(std::shared_ptr<types::module> current_module, const std::string_view& source, std::uint32_t file_id = 0,
+			bool intern_identifiers = false);
 
 		/**
 		 * Peeks a future lexeme.
@@ -70,5 +94,32 @@ namespace seam::lexer
 		 * @throws lexical_exception if lexing fails.
 		 */
 		void next_lexeme();
+
+		/**
+		 * Lexes the remaining source into a token buffer.
+		 *
+		 * @note independent of the streaming interface, should be called on a fresh lexer.
+		 * @return buffer of all remaining lexemes, ending with eof.
+		 * @throws lexical_exception if lexing fails.
+		 */
+		token_buffer tokenize();
+
+		/**
+		 * Lexes the whole source into a token buffer, lexing chunks of it in parallel.
+		 *
+		 * Chunks start at a newline followed by a top-level fn, type or extern. When a
+		 * chunk turns out to end inside a string or long comment, the chunk after it is
+		 * merged in and lexed again, so the result, including which lexical error is
+		 * thrown, is always identical to the serial tokenize. Chunks intern into
+		 * tables of their own, renumbered into the module in chunk order, so symbol
+		 * ids do not depend on which chunk finished first either.
+		 *
+		 * @note independent of the streaming interface, should be called on a fresh lexer.
+		 * @param pool pool to lex chunks on.
+		 * @param chunk_size approximate size of each chunk in bytes.
+		 * @return buffer of all lexemes, ending with eof.
+		 * @throws lexical_exception if lexing fails.
+		 */
+		token_buffer tokenize(utils::thread_pool& pool, std::size_t chunk_size = default_chunk_size);
 	};
 }
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "lexeme.hpp"
+#include "../utils/position.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace seam::lexer
+{
+	static_assert(static_cast<std::size_t>(lexeme_type::kw_import) <= UINT8_MAX, "lexeme types must fit in a byte");
+
+	/**
+	 * Every lexeme of a source, stored as a struct of arrays.
+	 *
+	 * Each lexeme is a type, the 32-bit offset it starts at, the 32-bit
+	 * length of its value and its 32-bit symbol id, so a single lexeme costs
+	 * 13 bytes spread over densely packed arrays. Number literals have no
+	 * symbol, their slot instead indexes their parsed value in numbers. The
+	 * last lexeme is always eof.
+	 */
+	struct token_buffer
+	{
+		std::string_view source; // source the offsets refer to
+		std::uint32_t file_id = 0; // id of the source file
+
+		std::vector<std::uint8_t> types; // lexeme types
+		std::vector<std::uint32_t> offsets; // offsets lexemes start at in source
+		std::vector<std::uint32_t> lengths; // lengths of lexeme values
+		std::vector<utils::symbol_id> symbols; // interned identifiers, number indices, no_symbol for other lexemes or when not interning
+		std::vector<number_value> numbers; // values of number literals
+
+		token_buffer() = default;
+
+		/**
+		 * Initialise an empty buffer for the lexemes of a source.
+		 *
+		 * @param source source the offsets will refer to.
+		 * @param file_id id of the source file.
+		 */
+		token_buffer(const std::string_view source, const std::uint32_t file_id) :
+			source(source), file_id(file_id)
+		{}
+
+		/**
+		 * Reserves space for a number of lexemes.
+		 *
+		 * @param count number of lexemes to reserve space for.
+		 */
+		void reserve(const std::size_t count)
+		{
+			types.reserve(count);
+			offsets.reserve(count);
+			lengths.reserve(count);
+			symbols.reserve(count);
+		}
+
+		/**
+		 * Appends a lexeme to the buffer.
+		 *
+		 * @param value lexeme to append, its value must be a view into source.
+		 */
+		void push_back(const lexeme& value)
+		{
+			types.push_back(static_cast<std::uint8_t>(value.type));
+			offsets.push_back(value.position.offset);
+			lengths.push_back(static_cast<std::uint32_t>(value.value.length()));
+			if (value.type == lexeme_type::literal_number)
+			{
+				symbols.push_back(static_cast<std::uint32_t>(numbers.size()));
+				numbers.push_back(value.number);
+			}
+			else
+			{
+				symbols.push_back(value.symbol);
+			}
+		}
+
+		/**
+		 * Returns the number of lexemes in the buffer.
+		 *
+		 * @returns number of lexemes.
+		 */
+		[[nodiscard]] std::size_t size() const
+		{
+			return types.size();
+		}
+
+		/**
+		 * Returns the type of a lexeme.
+		 *
+		 * @param index index of lexeme.
+		 * @returns lexeme type.
+		 */
+		[[nodiscard]] lexeme_type type(const std::size_t index) const
+		{
+			return static_cast<lexeme_type>(types[index]);
+		}
+
+		/**
+		 * Rebuilds a lexeme from the buffer.
+		 *
+		 * @param index index of lexeme.
+		 * @returns lexeme at index.
+		 */
+		[[nodiscard]] lexeme at(const std::size_t index) const
+		{
+			const auto current_type = type(index);
+
+			// String and attribute values skip their leading quote or @.
+			const auto value_offset = offsets[index] +
+				(current_type == lexeme_type::literal_string || current_type == lexeme_type::attribute ? 1 : 0);
+
+			if (current_type == lexeme_type::literal_number)
+			{
+				return {
+					current_type,
+					source.substr(value_offset, lengths[index]),
+					utils::position{ offsets[index], file_id },
+					utils::no_symbol,
+					numbers[symbols[index]]
+				};
+			}
+
+			return {
+				current_type,
+				source.substr(value_offset, lengths[index]),
+				utils::position{ offsets[index], file_id },
+				symbols[index]
+			};
+		}
+	};
+
+	/**
+	 * Walks a token buffer by index.
+	 *
+	 * Mirrors the lexeme interface of the streaming lexer, but lookahead is
+	 * unlimited and free as every lexeme has already been lexed.
+	 */
+	class token_cursor
+	{
+		const token_buffer* buffer_ = nullptr;
+		std::size_t index_ = 0;
+		lexeme current_;
+
+	public:
+		token_cursor() = default;
+
+		/**
+		 * Initialise cursor at the first lexeme of a buffer.
+		 *
+		 * @param buffer buffer to walk, must outlive the cursor and hold at least the eof lexeme.
+		 */
+		explicit token_cursor(const token_buffer& buffer) :
+			buffer_(&buffer), current_(buffer.at(0))
+		{}
+
+		/**
+		 * Retrieves the current lexeme.
+		 *
+		 * @return current lexeme.
+		 */
+		[[nodiscard]] const lexeme& current_lexeme() const { return current_; }
+
+		/**
+		 * Retrieves the type of a future lexeme.
+		 *
+		 * @param offset how many lexemes to look ahead.
+		 * @return type of lexeme, or eof when looking past the end.
+		 */
+		[[nodiscard]] lexeme_type peek_type(const std::size_t offset = 1) const
+		{
+			const auto index = index_ + offset;
+			return index < buffer_->size() ? buffer_->type(index) : lexeme_type::eof;
+		}
+
+		/**
+		 * Retrieves a future lexeme.
+		 *
+		 * @param offset how many lexemes to look ahead.
+		 * @return lexeme, or the eof lexeme when looking past the end.
+		 */
+		[[nodiscard]] lexeme peek_lexeme(const std::size_t offset = 1) const
+		{
+			const auto index = index_ + offset;
+			return buffer_->at(index < buffer_->size() ? index : buffer_->size() - 1);
+		}
+
+		/**
+		 * Moves the cursor to the next lexeme, stays on eof once reached.
+		 */
+		void next_lexeme()
+		{
+			if (index_ + 1 < buffer_->size())
+			{
+				current_ = buffer_->at(++index_);
+			}
+		}
+	};
+}
@@ -5,117 +5,98 @@
 #include <iostream>
 
 #include "../utils/exception.hpp"
+#include "../utils/simd.hpp"
 #include "passes/pass.hpp"
+#include "passes/semantic.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+#include <variant>
 
 namespace seam::parser
 {
 	void parser::expect(const lexer::lexeme_type type, const bool consume)
 	{
-		const auto& current_lexeme = lexer_.current_lexeme();
+		const auto& current_lexeme = tokens_.current_lexeme();
 
 		if (current_lexeme.type != type)
 		{
 			std::stringstream error_message;
-			error_message << "expected " << lexer::lexeme::to_string(type) << ", got " << lexer_.current_lexeme().to_string();
+			error_message << "expected " << lexer::lexeme::to_string(type) << ", got " << tokens_.current_lexeme().to_string();
 			throw utils::parser_exception{ current_lexeme.position, error_message.str() };
 		}
 
 		if (consume)
 		{
-			lexer_.next_lexeme();
+			tokens_.next_lexeme();
 		}
 	}
 
-	std::shared_ptr<ir::ast::expression::variable> get_variable_from_block(ir::ast::statement::base_block* block, const std::string& variable_name)
+	bool parser::is_same_line(const utils::position start, const utils::position end) const
 	{
-		const auto& it = block->variables.find(variable_name);
-		if (it != block->variables.cend())
-		{
-			return it->second;
-		}
-
-		if (!block->parent)
-		{
-			return nullptr;
-		}
-
-		return get_variable_from_block(block->parent, variable_name);
-	}
-
-	std::shared_ptr<ir::ast::type> get_type_from_block(ir::ast::statement::base_block* block, const std::string& type_name)
-	{
-		const auto& it = block->types.find(type_name);
-		if (it != block->types.cend())
-		{
-			return it->second;
-		}
-
-		if (!block->parent)
-		{
-			return nullptr;
-		}
-
-		return get_type_from_block(block->parent, type_name);
+		// Only scans the gap between the two positions, which is short when they share a line.
+		const auto source = token_buffer_.source.substr(0, end.offset);
+		return utils::simd::find(source, start.offset, '\n') == source.length();
 	}
 
-	std::shared_ptr<ir::ast::type> parser::parse_type()
+	ir::ast::type* parser::parse_type()
 	{
-		const auto start_position = lexer_.current_lexeme().position;
+		const auto start_position = tokens_.current_lexeme().position;
 		expect(lexer::lexeme_type::identifier);
 
-		auto target_type_name = std::string{ lexer_.current_lexeme().value };
-		lexer_.next_lexeme();
+		const auto target_type_name = tokens_.current_lexeme();
+		tokens_.next_lexeme();
 
 		bool is_optional = false;
-		if (lexer_.current_lexeme().type == lexer::lexeme_type::symbol_question_mark)
+		if (tokens_.current_lexeme().type == lexer::lexeme_type::symbol_question_mark)
 		{
-			lexer_.next_lexeme();
+			tokens_.next_lexeme();
 			is_optional = true;
 		}
 
-		const auto type = get_type_from_block(current_block, target_type_name);
+		const auto type = types_.find(target_type_name.symbol);
 
 		if (!type)
 		{
 			std::stringstream error_message;
-			error_message << "cannot use undefined type '" << target_type_name << '\'';
+			error_message << "cannot use undefined type '" << target_type_name.value << '\'';
 			throw utils::parser_exception{ start_position, error_message.str() };
 		}
 
 		return type;
 	}
 
-	std::unique_ptr<ir::ast::expression::parameter> parser::parse_parameter()
+	ir::ast::expression::parameter* parser::parse_parameter()
 	{
-		const auto start_position = lexer_.current_lexeme().position;
+		const auto start_position = tokens_.current_lexeme().position;
 		// Verify next token is parameter name (identifier)
 		expect(lexer::lexeme_type::identifier);
 
-		const auto parameter_name = std::string{ lexer_.current_lexeme().value };
-		lexer_.next_lexeme();
+		const auto parameter_name = tokens_.current_lexeme().symbol;
+		tokens_.next_lexeme();
 
 		// Check for colon preceding parameter type
 		expect(lexer::lexeme_type::symbol_colon, true);
 
-		return std::make_unique<ir::ast::expression::variable_ref>(
-			utils::position_range { start_position, lexer_.current_lexeme().position },
-			std::make_shared<ir::ast::expression::variable>(parameter_name, parse_type()));
+		return make_node<ir::ast::expression::variable_ref>(
+			utils::position_range { start_position, tokens_.current_lexeme().position },
+			make_node<ir::ast::expression::variable>(parameter_name, parse_type()));
 	}
 
 	ir::ast::expression::parameter_list parser::parse_parameter_list()
 	{
-		ir::ast::expression::parameter_list param_list;
+		ir::ast::expression::parameter_list param_list(node_resource());
 
 		// Consume open parenthesis - (
-		lexer_.next_lexeme();
+		tokens_.next_lexeme();
 
-		if (lexer_.current_lexeme().type != lexer::lexeme_type::symbol_close_parenthesis)
+		if (tokens_.current_lexeme().type != lexer::lexeme_type::symbol_close_parenthesis)
 		{
 			param_list.emplace_back(parse_parameter());
 
-			while (lexer_.current_lexeme().type == lexer::lexeme_type::symbol_comma)
+			while (tokens_.current_lexeme().type == lexer::lexeme_type::symbol_comma)
 			{
-				lexer_.next_lexeme();
+				tokens_.next_lexeme();
 				param_list.emplace_back(parse_parameter());
 			}
 		}
@@ -125,15 +106,15 @@ namespace seam::parser
 
 	ir::ast::expression::expression_list parser::parse_expression_list()
 	{
-		ir::ast::expression::expression_list expression_list;
+		ir::ast::expression::expression_list expression_list(node_resource());
 
-		if (lexer_.current_lexeme().type != lexer::lexeme_type::symbol_close_parenthesis)
+		if (tokens_.current_lexeme().type != lexer::lexeme_type::symbol_close_parenthesis)
 		{
 			expression_list.emplace_back(parse_expression());
 
-			while (lexer_.current_lexeme().type == lexer::lexeme_type::symbol_comma)
+			while (tokens_.current_lexeme().type == lexer::lexeme_type::symbol_comma)
 			{
-				lexer_.next_lexeme();
+				tokens_.next_lexeme();
 				expression_list.emplace_back(parse_expression());
 			}
 		}
@@ -141,30 +122,30 @@ namespace seam::parser
 		return expression_list;
 	}
 
-	std::unique_ptr<ir::ast::expression::call> parser::parse_call_expression(std::unique_ptr<ir::ast::expression::expression> function)
+	ir::ast::expression::call* parser::parse_call_expression(ir::ast::expression::expression* function)
 	{
-		const auto start_position = lexer_.current_lexeme().position;
+		const auto start_position = tokens_.current_lexeme().position;
 
-		lexer_.next_lexeme(); // Skip (
+		tokens_.next_lexeme(); // Skip (
 
 		// TODO: error recovery
 		auto arguments = parse_expression_list();
 
 		expect(lexer::lexeme_type::symbol_close_parenthesis, true);
 
-		return std::make_unique<ir::ast::expression::call>(utils::position_range{ start_position, lexer_.current_lexeme().position }, std::move(function), std::move(arguments));
+		return make_node<ir::ast::expression::call>(utils::position_range{ start_position, tokens_.current_lexeme().position }, function, std::move(arguments));
 	}
 
-	std::unique_ptr<ir::ast::expression::expression> parser::parse_prefix_expression()
+	ir::ast::expression::expression* parser::parse_prefix_expression()
 	{
-		const auto current_lexeme = lexer_.current_lexeme();
+		const auto current_lexeme = tokens_.current_lexeme();
 		const auto start_position = current_lexeme.position;
 
 		switch (current_lexeme.type)
 		{
 		case lexer::lexeme_type::symbol_open_parenthesis: // (expr)
 		{
-			lexer_.next_lexeme();
+			tokens_.next_lexeme();
 
 			auto inner_expression = parse_expression();
 
@@ -174,73 +155,45 @@ namespace seam::parser
 		case lexer::lexeme_type::identifier:
 		{
 			const auto identifier_pos = current_lexeme.position;
-			const auto identifier_name = std::string{ current_lexeme.value };
+			const auto identifier_name = current_lexeme.symbol;
 
-			lexer_.next_lexeme();
+			tokens_.next_lexeme();
 
-			if (const auto var = get_variable_from_block(current_block, identifier_name))
+			if (const auto var = variables_.find(identifier_name))
 			{
-				return std::make_unique<ir::ast::expression::variable_ref>(utils::position_range{ start_position, lexer_.current_lexeme().position }, var);
+				return make_node<ir::ast::expression::variable_ref>(utils::position_range{ start_position, tokens_.current_lexeme().position }, var);
 			}
 
-			return std::make_unique<ir::ast::expression::symbol_wrapper>(utils::position_range{ start_position, lexer_.current_lexeme().position },
-				std::make_unique<ir::ast::expression::unresolved_symbol>(identifier_name));
+			return make_node<ir::ast::expression::symbol_wrapper>(utils::position_range{ start_position, tokens_.current_lexeme().position },
+				make_node<ir::ast::expression::unresolved_symbol>(identifier_name));
 		}
 		default:
 		{
 			std::stringstream error_message;
-			error_message << "expected '(' or identifier, got " << lexer_.current_lexeme().to_string();
+			error_message << "expected '(' or identifier, got " << tokens_.current_lexeme().to_string();
 			throw utils::parser_exception{ start_position, error_message.str() };
 		}
 		}
 	}
 
-	std::unique_ptr<ir::ast::expression::expression> parser::parse_expression()
+	ir::ast::expression::expression* parser::parse_expression()
 	{
 		return parse_sub_expression().first;
 	}
 
-	struct priority
-	{
-		std::size_t left;
-		std::size_t right;
-
-		// if right > left then right associative
-		priority(std::size_t left, std::size_t right) :
-			left(left), right(right) {}
-
-		priority(std::size_t priority) :
-			left(priority), right(priority) {}
-	};
-
-	std::unordered_map<lexer::lexeme_type, priority> binary_priority
-	{
-		{ lexer::lexeme_type::symbol_add, 6 }, { lexer::lexeme_type::symbol_minus, 6 },
-		{ lexer::lexeme_type::symbol_multiply, 7 }, { lexer::lexeme_type::symbol_divide, 7 }, { lexer::lexeme_type::symbol_mod, 7 },
-		// comparison operators
-		{ lexer::lexeme_type::symbol_eq, 3 }, { lexer::lexeme_type::symbol_neq, 3 },
-		{ lexer::lexeme_type::symbol_lt, 3 }, { lexer::lexeme_type::symbol_lteq, 3 },
-		{ lexer::lexeme_type::symbol_gt, 3 }, { lexer::lexeme_type::symbol_gteq, 3 },
-		// logical operators
-		{ lexer::lexeme_type::symbol_and, 2 }, { lexer::lexeme_type::symbol_or, 1 },
-	};
-
-	// higher than any binary priority
-	std::size_t unary_priority = 8;
-
-	std::pair<std::unique_ptr<ir::ast::expression::expression>, std::optional<lexer::lexeme_type>> parser::parse_sub_expression(std::size_t limit)
+	std::pair<ir::ast::expression::expression*, std::optional<lexer::lexeme_type>> parser::parse_sub_expression(std::size_t limit)
 	{
-		const auto start_position = lexer_.current_lexeme().position;
+		const auto start_position = tokens_.current_lexeme().position;
 
-		std::unique_ptr<ir::ast::expression::expression> expression;
+		ir::ast::expression::expression* expression = nullptr;
 		// TODO: use while loop instead of recursion
-		if (is_unary_operator(lexer_.current_lexeme().type))
+		if (is_unary_operator(tokens_.current_lexeme().type))
 		{
-			auto operator_type = lexer_.current_lexeme().type;
-			lexer_.next_lexeme();
+			auto operator_type = tokens_.current_lexeme().type;
+			tokens_.next_lexeme();
 
-			expression = std::make_unique<ir::ast::expression::unary>(utils::position_range{ start_position, lexer_.current_lexeme().position },
-				parse_sub_expression(unary_priority).first,
+			expression = make_node<ir::ast::expression::unary>(utils::position_range{ start_position, tokens_.current_lexeme().position },
+				parse_sub_expression(lexer::unary_priority).first,
 				operator_type);
 			
 		}
@@ -249,21 +202,21 @@ namespace seam::parser
 			expression = parse_simple_expression();
 		}
 
-		lexer::lexeme_type operator_type = lexer_.current_lexeme().type;
+		lexer::lexeme_type operator_type = tokens_.current_lexeme().type;
 		while (true)
 		{
-			auto it = binary_priority.find(operator_type);
-			if (it == binary_priority.cend() || limit >= it->second.left)
+			const auto& info = lexer::operator_of(operator_type);
+			if (limit >= info.left) // also stops at anything that is not a binary operator, its left is 0
 			{
 				break;
 			}
 
-			lexer_.next_lexeme();
+			tokens_.next_lexeme();
 
-			auto [next_expression, next_operator_type] = parse_sub_expression(it->second.right);
+			auto [next_expression, next_operator_type] = parse_sub_expression(info.right);
 
-			expression = std::make_unique<ir::ast::expression::binary>(utils::position_range{ start_position, lexer_.current_lexeme().position },
-				std::move(expression), std::move(next_expression), operator_type);
+			expression = make_node<ir::ast::expression::binary>(utils::position_range{ start_position, tokens_.current_lexeme().position },
+				expression, next_expression, operator_type);
 
 			if (!next_operator_type)
 			{
@@ -273,36 +226,42 @@ namespace seam::parser
 			operator_type = next_operator_type.value();
 		}
 
-		return { std::move(expression), operator_type };
+		return { expression, operator_type };
 	}
 
-	std::unique_ptr<ir::ast::expression::expression> parser::parse_simple_expression()
+	ir::ast::expression::expression* parser::parse_simple_expression()
 	{
-		const auto& start_position = lexer_.current_lexeme().position;
+		const auto& start_position = tokens_.current_lexeme().position;
 
-		const auto current_lexeme = lexer_.current_lexeme(); //*dont* use a reference, we call next_lexeme
+		const auto current_lexeme = tokens_.current_lexeme(); //*dont* use a reference, we call next_lexeme
 
-		std::unique_ptr<ir::ast::expression::expression> expr;
+		ir::ast::expression::expression* expr = nullptr;
 		switch (const auto lexeme_type = current_lexeme.type)
 		{
 		case lexer::lexeme_type::kw_true:
 		case lexer::lexeme_type::kw_false:
 		{
-			lexer_.next_lexeme();
-			expr = std::make_unique<ir::ast::expression::bool_literal>(utils::position_range{ start_position, current_lexeme.position }, lexeme_type != lexer::lexeme_type::kw_false);
+			tokens_.next_lexeme();
+			expr = make_node<ir::ast::expression::bool_literal>(utils::position_range{ start_position, current_lexeme.position }, lexeme_type != lexer::lexeme_type::kw_false);
 			break;
 		}
 		case lexer::lexeme_type::literal_number:
 		{
-			lexer_.next_lexeme();
-			expr = std::make_unique<ir::ast::expression::number_literal>(utils::position_range{ start_position, current_lexeme.position },
-				std::string{ current_lexeme.value });
+			tokens_.next_lexeme();
+			expr = make_node<ir::ast::expression::number_literal>(utils::position_range{ start_position, current_lexeme.position },
+				current_lexeme.number);
+
+			// Suffixed literals have their type fixed up front.
+			if (const auto suffix_type = lexer::to_string(current_lexeme.number.suffix); !suffix_type.empty())
+			{
+				expr->eval_type = types_.find(current_module->symbols.intern(suffix_type));
+			}
 			break;
 		}
 		case lexer::lexeme_type::literal_string:
 		{
-			lexer_.next_lexeme();
-			expr = std::make_unique<ir::ast::expression::string_literal>(utils::position_range{ start_position, current_lexeme.position }, std::string{ current_lexeme.value });
+			tokens_.next_lexeme();
+			expr = make_node<ir::ast::expression::string_literal>(utils::position_range{ start_position, current_lexeme.position }, current_lexeme.value);
 			break;
 		}
 		case lexer::lexeme_type::symbol_open_parenthesis:
@@ -321,20 +280,20 @@ namespace seam::parser
 		return expr;
 	}
 
-	std::unique_ptr<ir::ast::expression::expression> parser::parse_primary_expression()
+	ir::ast::expression::expression* parser::parse_primary_expression()
 	{
-		const auto start_position = lexer_.current_lexeme().position;
+		const auto start_position = tokens_.current_lexeme().position;
 
 		auto prefix_expression = parse_prefix_expression();
 
-		auto expression = std::move(prefix_expression);
-		while (lexer_.current_lexeme().position.line == start_position.line)
+		auto expression = prefix_expression;
+		while (is_same_line(start_position, tokens_.current_lexeme().position))
 		{
-			switch (lexer_.current_lexeme().type)
+			switch (tokens_.current_lexeme().type)
 			{
 				case lexer::lexeme_type::symbol_open_parenthesis:
 				{
-					expression = parse_call_expression(std::move(expression));
+					expression = parse_call_expression(expression);
 					continue;
 				}
 			}
@@ -344,10 +303,10 @@ namespace seam::parser
 		return expression;
 	}
 
-	std::unique_ptr<ir::ast::statement::loop> parser::parse_for_statement()
+	ir::ast::statement::loop* parser::parse_for_statement()
 	{
-		const auto start = lexer_.current_lexeme().position;
-		lexer_.next_lexeme(); // collect kw_for
+		const auto start = tokens_.current_lexeme().position;
+		tokens_.next_lexeme(); // collect kw_for
 
 		expect(lexer::lexeme_type::symbol_open_parenthesis, true);
 
@@ -355,8 +314,8 @@ namespace seam::parser
 		expect(lexer::lexeme_type::identifier);
 
 		// Store identifier
-		auto function_name = std::string{ lexer_.current_lexeme().value };
-		lexer_.next_lexeme();
+		const auto function_name = tokens_.current_lexeme().symbol;
+		tokens_.next_lexeme();
 
 		expect(lexer::lexeme_type::symbol_arrow, true);
 
@@ -364,40 +323,40 @@ namespace seam::parser
 		expect(lexer::lexeme_type::symbol_comma, true);
 		auto final = parse_expression();
 
-		std::unique_ptr<ir::ast::expression::number_literal> step;
-		if (lexer_.current_lexeme().type == lexer::lexeme_type::symbol_comma)
+		ir::ast::expression::number_literal* step = nullptr;
+		if (tokens_.current_lexeme().type == lexer::lexeme_type::symbol_comma)
 		{
 			//step = parse_expression();
 		}
 		else
 		{
-			//step = std::make_unique<ir::ast::expression::number_literal>();
+			//step = make_node<ir::ast::expression::number_literal>();
 		} //or just work locally on this
 
 		expect(lexer::lexeme_type::symbol_close_parenthesis, true); //can u wait 2 sec, we need to compile
 return {};
-		//return std::make_unique<ir::ast::statement::numerical_for_loop>(utils::position_range{ start_position, lexer_.current_lexeme().position }, std::move(initial), std::move(final));
+		//return make_node<ir::ast::statement::numerical_for_loop>(utils::position_range{ start_position, tokens_.current_lexeme().position }, initial, final);
 	}
 
-	std::unique_ptr<ir::ast::statement::ret> parser::parse_return_statement()
+	ir::ast::statement::ret* parser::parse_return_statement()
 	{
-		const auto start_position = lexer_.current_lexeme().position;
-		lexer_.next_lexeme();
+		const auto start_position = tokens_.current_lexeme().position;
+		tokens_.next_lexeme();
 
-		std::unique_ptr<ir::ast::expression::expression> expression = nullptr;
-		if (lexer_.current_lexeme().type != lexer::lexeme_type::symbol_close_brace
-			&& lexer_.current_lexeme().position.line == start_position.line)
+		ir::ast::expression::expression* expression = nullptr;
+		if (tokens_.current_lexeme().type != lexer::lexeme_type::symbol_close_brace
+			&& is_same_line(start_position, tokens_.current_lexeme().position))
 		{
 			expression = parse_expression();
 		}
 
-		return std::make_unique<ir::ast::statement::ret>(utils::position_range{ start_position, lexer_.current_lexeme().position }, std::move(expression));
+		return make_node<ir::ast::statement::ret>(utils::position_range{ start_position, tokens_.current_lexeme().position }, expression);
 	}
 
-	std::unique_ptr<ir::ast::statement::while_loop> parser::parse_while_statement()
+	ir::ast::statement::while_loop* parser::parse_while_statement()
 	{
-		const auto start = lexer_.current_lexeme().position;
-		lexer_.next_lexeme(); // collect kw_while
+		const auto start = tokens_.current_lexeme().position;
+		tokens_.next_lexeme(); // collect kw_while
 
 		expect(lexer::lexeme_type::symbol_open_parenthesis, true);
 		auto condition = parse_expression();
@@ -405,16 +364,16 @@ return {};
 
 		auto body = parse_block_statement();
 
-		return std::make_unique<ir::ast::statement::while_loop>(
-			utils::position_range{ start, lexer_.current_lexeme().position },
-			std::move(condition),
-			std::move(body));
+		return make_node<ir::ast::statement::while_loop>(
+			utils::position_range{ start, tokens_.current_lexeme().position },
+			condition,
+			body);
 	}
 
-	std::unique_ptr<ir::ast::statement::if_stat> parser::parse_if_statement()
+	ir::ast::statement::if_stat* parser::parse_if_statement()
 	{
-		const auto start = lexer_.current_lexeme().position;
-		lexer_.next_lexeme(); // collect kw_if
+		const auto start = tokens_.current_lexeme().position;
+		tokens_.next_lexeme(); // collect kw_if
 
 		expect(lexer::lexeme_type::symbol_open_parenthesis, true);
 		auto condition = parse_expression();
@@ -422,29 +381,29 @@ return {};
 
 		auto main_body = parse_block_statement();
 		
-		std::unique_ptr<ir::ast::statement::normal_block> else_block;
-		while (lexer_.current_lexeme().type == lexer::lexeme_type::kw_else
-			|| lexer_.current_lexeme().type == lexer::lexeme_type::kw_elseif)
+		ir::ast::statement::normal_block* else_block = nullptr;
+		while (tokens_.current_lexeme().type == lexer::lexeme_type::kw_else
+			|| tokens_.current_lexeme().type == lexer::lexeme_type::kw_elseif)
 		{
-			switch (lexer_.current_lexeme().type)
+			switch (tokens_.current_lexeme().type)
 			{
 				case lexer::lexeme_type::kw_else:
 				{
-					lexer_.next_lexeme();
+					tokens_.next_lexeme();
 					if (!else_block)
 					{
 						else_block = parse_block_statement();
 						break;
 					}
 					throw utils::parser_exception{
-						lexer_.current_lexeme().position,
+						tokens_.current_lexeme().position,
 						"cannot have more than one else",
 					};
 				}
 				case lexer::lexeme_type::kw_elseif:
 				{
 					throw utils::parser_exception{
-						lexer_.current_lexeme().position,
+						tokens_.current_lexeme().position,
 						"TODO: Check whether an else block exists, and create an if inside of it.",
 					};
 					break;
@@ -457,24 +416,25 @@ return {};
 			
 		}
 
-		return std::make_unique<ir::ast::statement::if_stat>(
-			utils::position_range { start, lexer_.current_lexeme().position },
-			std::move(condition),
-			std::move(main_body),
-			std::move(else_block)
+		return make_node<ir::ast::statement::if_stat>(
+			utils::position_range { start, tokens_.current_lexeme().position },
+			condition,
+			main_body,
+			else_block
 			);
 	}
 	
-	std::unique_ptr<ir::ast::statement::statement> parser::parse_assignment_statement()
+	ir::ast::statement::statement* parser::parse_assignment_statement()
 	{
-		const auto variable_position = lexer_.current_lexeme().position;
-		const auto variable_name = std::string{ lexer_.current_lexeme().value };
-		lexer_.next_lexeme(); // skips identifier
+		const auto variable_position = tokens_.current_lexeme().position;
+		const auto variable_lexeme = tokens_.current_lexeme();
+		const auto variable_name = variable_lexeme.symbol;
+		tokens_.next_lexeme(); // skips identifier
 		
-		const auto assignment_symbol = lexer_.current_lexeme();
-		lexer_.next_lexeme(); // get colon, or colon equals, or equals
+		const auto assignment_symbol = tokens_.current_lexeme();
+		tokens_.next_lexeme(); // get colon, or colon equals, or equals
 
-		const auto existing_var = get_variable_from_block(current_block, variable_name);
+		const auto existing_var = variables_.find(variable_name);
 		switch (assignment_symbol.type)
 		{
 			case lexer::lexeme_type::symbol_colon:
@@ -483,16 +443,16 @@ return {};
 				if (existing_var)
 				{
 					std::stringstream error_message;
-					error_message << "cannot redefine variable " << variable_name;
+					error_message << "cannot redefine variable " << variable_lexeme.value;
 					
 					throw utils::compiler_exception{
-						lexer_.current_lexeme().position,
+						tokens_.current_lexeme().position,
 						error_message.str()
 					};
 				}
 
-				std::unique_ptr<ir::ast::expression::expression> rhs;
-				std::shared_ptr<ir::ast::type> var_type;
+				ir::ast::expression::expression* rhs = nullptr;
+				ir::ast::type* var_type = nullptr;
 				if (assignment_symbol.type == lexer::lexeme_type::symbol_colon)
 				{
 					var_type = parse_type();
@@ -505,46 +465,56 @@ return {};
 					var_type = auto_type;
 				}
 
-				const auto new_variable = std::make_shared<ir::ast::expression::variable>(variable_name, var_type);
-				current_block->variables.emplace(variable_name, new_variable);
-				return std::make_unique<ir::ast::statement::assignment>(utils::position_range{ assignment_symbol.position, lexer_.current_lexeme().position }, 
-					std::make_unique<ir::ast::expression::variable_ref>(utils::position_range{ variable_position, assignment_symbol.position }, new_variable), std::move(rhs));
+				const auto new_variable = make_node<ir::ast::expression::variable>(variable_name, var_type);
+				variables_.add(variable_name, new_variable);
+				return make_node<ir::ast::statement::assignment>(utils::position_range{ assignment_symbol.position, tokens_.current_lexeme().position }, 
+					make_node<ir::ast::expression::variable_ref>(utils::position_range{ variable_position, assignment_symbol.position }, new_variable), rhs);
 			}
-			/*case lexer::lexeme_type::symbol_equals:
+			case lexer::lexeme_type::symbol_equals:
 			{
 				if (!existing_var)
 				{
 					std::stringstream error_message;
-					error_message << "cannot assign non-existent variable " << variable_name;
+					error_message << "cannot assign non-existent variable " << variable_lexeme.value;
 
 					throw utils::compiler_exception{
-						lexer_.current_lexeme().position,
+						variable_position,
 						error_message.str()
 					};
 				}
 
-				return std::make_unique<ir::ast::statement::variable_assignment>(
-					utils::position_range{ assignment_symbol.position, lexer_.current_lexeme().position },
-					variable_name,
-					parse_expression());
-			}*/
+				const auto rhs = parse_expression();
+				return make_node<ir::ast::statement::assignment>(utils::position_range{ assignment_symbol.position, tokens_.current_lexeme().position },
+					make_node<ir::ast::expression::variable_ref>(utils::position_range{ variable_position, assignment_symbol.position }, existing_var), rhs);
+			}
+			default:
+			{
+				throw utils::compiler_exception{ assignment_symbol.position, "internal compiler error: expected assignment" };
+			}
 		}
 	}
 	
-	std::unique_ptr<ir::ast::statement::normal_block> parser::parse_block_statement()
+	ir::ast::statement::normal_block* parser::parse_block_statement(const ir::ast::expression::parameter_list& parameters)
 	{
 		expect(lexer::lexeme_type::symbol_open_brace, true);
-		const auto start_position = lexer_.current_lexeme().position;
+		const auto start_position = tokens_.current_lexeme().position;
 
 		const auto old_block = current_block;
-		auto new_block = std::make_unique<ir::ast::statement::normal_block>(utils::position_range{ start_position, lexer_.current_lexeme().position });
+		auto new_block = make_node<ir::ast::statement::normal_block>(utils::position_range{ start_position, tokens_.current_lexeme().position }, node_resource());
 		new_block->parent = old_block;
-		current_block = new_block.get();
+		current_block = new_block;
+		variables_.push_scope();
+		types_.push_scope();
 
-		ir::ast::statement::statement_list body;
+		for (const auto& parameter : parameters)
+		{
+			variables_.add(parameter->var->name, parameter->var);
+		}
+
+		ir::ast::statement::statement_list body(node_resource());
 		while (true)
 		{
-			const auto current_lexeme = lexer_.current_lexeme();
+			const auto current_lexeme = tokens_.current_lexeme();
 			const auto statement_start_position = current_lexeme.position;
 
 			if (current_lexeme.type == lexer::lexeme_type::symbol_close_brace)
@@ -582,9 +552,9 @@ return {};
 			}
 			case lexer::lexeme_type::identifier:
 			{
-				if (lexer_.peek_lexeme().type == lexer::lexeme_type::symbol_colon_equals
-					|| lexer_.peek_lexeme().type == lexer::lexeme_type::symbol_colon
-					|| lexer_.peek_lexeme().type == lexer::lexeme_type::symbol_equals) // a (:=)= 2
+				if (tokens_.peek_type() == lexer::lexeme_type::symbol_colon_equals
+					|| tokens_.peek_type() == lexer::lexeme_type::symbol_colon
+					|| tokens_.peek_type() == lexer::lexeme_type::symbol_equals) // a (:=)= 2
 				{
 					body.emplace_back(parse_assignment_statement());
 					break;
@@ -595,9 +565,17 @@ return {};
 			default:
 			{
 				// TODO: use parse_primary_expression if we only want to allow call + index
+				const auto expression_position = tokens_.current_lexeme().position;
 				auto expression = parse_expression();
 
-				body.push_back(std::make_unique<ir::ast::statement::expression_>(expression->range, std::move(expression)));
+				// Only variables can be assigned, identifiers followed by an assignment are handled above.
+				const auto next_type = tokens_.current_lexeme().type;
+				if (next_type == lexer::lexeme_type::symbol_equals || next_type == lexer::lexeme_type::symbol_colon_equals)
+				{
+					throw utils::parser_exception{ expression_position, "cannot assign to an expression which is not a variable" };
+				}
+
+				body.push_back(make_node<ir::ast::statement::expression_>(expression->range, expression));
 				break;
 			}
 			}
@@ -605,40 +583,42 @@ return {};
 
 		expect(lexer::lexeme_type::symbol_close_brace, true);
 
+		types_.pop_scope();
+		variables_.pop_scope();
 		current_block = old_block;
 
 		new_block->body = std::move(body);
 		return new_block;
 	}
 
-	std::shared_ptr<ir::ast::expression::function_signature> parser::parse_function_signature()
+	ir::ast::expression::function_signature* parser::parse_function_signature()
 	{
-		const auto start_position = lexer_.current_lexeme().position;
+		const auto start_position = tokens_.current_lexeme().position;
 
 		// Consume kw_fn
-		lexer_.next_lexeme();
+		tokens_.next_lexeme();
 
 		// Verify next token is function name (identifier)
 		expect(lexer::lexeme_type::identifier);
 
 		// Store function name
-		auto function_name = std::string{ lexer_.current_lexeme().value };
-		lexer_.next_lexeme();
+		const auto function_lexeme = tokens_.current_lexeme();
+		tokens_.next_lexeme();
 
 		// Verify next token is open parenthesis (start of parameter_list)
 		expect(lexer::lexeme_type::symbol_open_parenthesis);
 
 		// Generate parameter list
-		const auto param_list_pos = lexer_.current_lexeme().position;
+		const auto param_list_pos = tokens_.current_lexeme().position;
 		auto param_list = parse_parameter_list();
 
 		expect(lexer::lexeme_type::symbol_close_parenthesis, true);
 
 		// Check for explicit return type
-		std::shared_ptr<ir::ast::type> return_type;
-		if (lexer_.current_lexeme().type == lexer::lexeme_type::symbol_arrow)
+		ir::ast::type* return_type = nullptr;
+		if (tokens_.current_lexeme().type == lexer::lexeme_type::symbol_arrow)
 		{
-			lexer_.next_lexeme();
+			tokens_.next_lexeme();
 			return_type = parse_type();
 		}
 		else
@@ -646,101 +626,116 @@ return {};
 			// We do not allow for any implicit returns which
 			// are not void, so we can simply set the return
 			// type to void.
-			return_type = get_type_from_block(current_block, "void");
+			return_type = types_.find(current_module->symbols.intern("void"));
 		}
 
 		// Check for attributes
-		ir::ast::expression::attribute_list attribute_list;
-		while (lexer_.current_lexeme().type == lexer::lexeme_type::attribute)
+		ir::ast::expression::attribute_list attribute_list(node_resource());
+		while (tokens_.current_lexeme().type == lexer::lexeme_type::attribute)
 		{
-			const auto attribute = std::string{ lexer_.current_lexeme().value };
+			const auto attribute = tokens_.current_lexeme().value;
 			if (attribute == "constructor" && !param_list.empty()) //TODO: make sure return type is void for constructors
 			{
 				std::stringstream error_message;
-				error_message << "constructor function '" << function_name << "' cannot have parameters";
+				error_message << "constructor function '" << function_lexeme.value << "' cannot have parameters";
 				throw utils::parser_exception{ param_list_pos, error_message.str() };
 			}
 			attribute_list.insert(attribute);
-			lexer_.next_lexeme();
+			tokens_.next_lexeme();
 		}
 
-		return std::make_shared<ir::ast::expression::function_signature>(current_module->name, std::move(function_name), std::move(return_type),
-			std::move(param_list), std::move(attribute_list));
+		auto mangled_name = current_module->name;
+		mangled_name += '@';
+		mangled_name += function_lexeme.value;
+
+		const auto signature = make_node<ir::ast::expression::function_signature>(function_lexeme.symbol,
+			current_module->symbols.intern(mangled_name), return_type, std::move(param_list), std::move(attribute_list));
+
+		// Functions can be called before they are declared, so they are only resolved once the whole tree is parsed.
+		functions_.emplace(signature->name, signature);
+		return signature;
 	}
 
-	std::unique_ptr<ir::ast::statement::function_definition> parser::parse_function_definition_statement()
+	ir::ast::statement::function_definition* parser::parse_function_definition_statement()
 	{
-		const auto start_position = lexer_.current_lexeme().position;
+		const auto start_position = tokens_.current_lexeme().position;
 		auto signature = parse_function_signature();
 
+		// Mangled or exported, a function named entry would clash with the entry function of the module or of the program.
+		if (current_module->symbols.name(signature->name) == "entry")
+		{
+			throw utils::parser_exception{ start_position, "function name 'entry' is reserved for entry functions" };
+		}
+
 		// Parse function body
-		auto block = parse_block_statement();
+		auto block = parse_block_statement(signature->parameters);
 
-		return std::make_unique<ir::ast::statement::function_definition>(utils::position_range{ start_position, lexer_.current_lexeme().position },
-			signature, std::move(block));
+		return make_node<ir::ast::statement::function_definition>(utils::position_range{ start_position, tokens_.current_lexeme().position },
+			signature, block, node_resource());
 	}
 
-	std::unique_ptr<ir::ast::statement::extern_function_definition> parser::parse_extern_function_definition_statement()
+	ir::ast::statement::extern_function_definition* parser::parse_extern_function_definition_statement()
 	{
-		const auto start_position = lexer_.current_lexeme().position;
+		const auto start_position = tokens_.current_lexeme().position;
 		auto signature = parse_function_signature();
 		signature->is_extern = true;
 
-		return std::make_unique<ir::ast::statement::extern_function_definition>(utils::position_range{ start_position, lexer_.current_lexeme().position },
+		return make_node<ir::ast::statement::extern_function_definition>(utils::position_range{ start_position, tokens_.current_lexeme().position },
 			signature);
 	}
 
-	std::unique_ptr<ir::ast::statement::type_definition> parser::parse_type_definition_statement()
+	ir::ast::statement::type_definition* parser::parse_type_definition_statement()
 	{
-		const auto start_position = lexer_.current_lexeme().position;
+		const auto start_position = tokens_.current_lexeme().position;
 
 		// Consume kw_type
-		lexer_.next_lexeme();
+		tokens_.next_lexeme();
 
 		expect(lexer::lexeme_type::identifier);
 
-		const auto type_name = std::string{ lexer_.current_lexeme().value };
-		lexer_.next_lexeme();
+		const auto type_lexeme = tokens_.current_lexeme();
+		const auto type_name = type_lexeme.symbol;
+		tokens_.next_lexeme();
 
-		const auto current_token = lexer_.current_lexeme();
+		const auto current_token = tokens_.current_lexeme();
 		switch (current_token.type)
 		{
 		case lexer::lexeme_type::symbol_equals:
 		{
-			if (const auto existing_type = get_type_from_block(current_block, type_name))
+			if (const auto existing_type = types_.find(type_name))
 			{
 				std::stringstream error_message;
-				error_message << "cannot redefine existing type '" << type_name << '\'';
-				throw utils::parser_exception{ lexer_.current_lexeme().position, error_message.str() };
+				error_message << "cannot redefine existing type '" << type_lexeme.value << '\'';
+				throw utils::parser_exception{ tokens_.current_lexeme().position, error_message.str() };
 			}
 
 			// Consume equals symbol
-			lexer_.next_lexeme();
+			tokens_.next_lexeme();
 
 			const auto target_type = parse_type();
 
 			// register type
-			current_block->types.emplace(type_name, target_type);
+			types_.add(type_name, target_type);
 			
 			// add type alias node, not required for code gen
-			return std::make_unique<ir::ast::statement::alias_type_definition>(utils::position_range{ start_position, lexer_.current_lexeme().position },
+			return make_node<ir::ast::statement::alias_type_definition>(utils::position_range{ start_position, tokens_.current_lexeme().position },
 				type_name, target_type);
 		}
 		case lexer::lexeme_type::symbol_open_brace:
 		{
 			// Consume open brace symbol
-			lexer_.next_lexeme();
+			tokens_.next_lexeme();
 
-			ir::ast::expression::parameter_list fields;
-			ir::ast::statement::restricted_list body;
-			while (lexer_.current_lexeme().type != lexer::lexeme_type::symbol_close_brace) // }
+			ir::ast::expression::parameter_list fields(node_resource());
+			ir::ast::statement::restricted_list body(node_resource());
+			while (tokens_.current_lexeme().type != lexer::lexeme_type::symbol_close_brace) // }
 			{
-				const auto current_lexeme = lexer_.current_lexeme();
+				const auto current_lexeme = tokens_.current_lexeme();
 				if (current_lexeme.type == lexer::lexeme_type::identifier) // <identifier> : <type>
 				{
 					// <identifier>
-					const auto field_name = std::string{ current_lexeme.value };
-					lexer_.next_lexeme();
+					const auto field_name = current_lexeme.symbol;
+					tokens_.next_lexeme();
 
 					// :
 					expect(lexer::lexeme_type::symbol_colon, true);
@@ -748,9 +743,9 @@ return {};
 					// <type>
 					auto type = parse_type();
 
-					fields.push_back(std::make_unique<ir::ast::expression::variable_ref>(
-						utils::position_range{ start_position, lexer_.current_lexeme().position },
-						std::make_shared<ir::ast::expression::variable>(field_name, type)));
+					fields.push_back(make_node<ir::ast::expression::variable_ref>(
+						utils::position_range{ start_position, tokens_.current_lexeme().position },
+						make_node<ir::ast::expression::variable>(field_name, type)));
 				}
 				else // methods, types, ...
 				{
@@ -761,23 +756,23 @@ return {};
 			// }
 			expect(lexer::lexeme_type::symbol_close_brace, true);
 
-			auto body_stat = std::make_unique<ir::ast::statement::restricted_block>(utils::position_range{ start_position, lexer_.current_lexeme().position }, std::move(body));
+			auto body_stat = make_node<ir::ast::statement::restricted_block>(utils::position_range{ start_position, tokens_.current_lexeme().position }, std::move(body));
 
-			return std::make_unique<ir::ast::statement::class_type_definition>(utils::position_range{ start_position, lexer_.current_lexeme().position },
-				type_name, std::move(fields), std::move(body_stat));
+			return make_node<ir::ast::statement::class_type_definition>(utils::position_range{ start_position, tokens_.current_lexeme().position },
+				type_name, std::move(fields), body_stat);
 		}
 		default:
 		{
 			std::stringstream error_message;
-			error_message << "expected '=' or '{', got " << lexer_.current_lexeme().to_string();
-			throw utils::parser_exception{ lexer_.current_lexeme().position, error_message.str() };
+			error_message << "expected '=' or '{', got " << tokens_.current_lexeme().to_string();
+			throw utils::parser_exception{ tokens_.current_lexeme().position, error_message.str() };
 		}
 		}
 	}
 
-	std::unique_ptr<ir::ast::statement::restricted> parser::parse_restricted_statement()
+	ir::ast::statement::restricted* parser::parse_restricted_statement()
 	{
-		const auto current_lexeme = lexer_.current_lexeme();
+		const auto current_lexeme = tokens_.current_lexeme();
 
 		switch (current_lexeme.type)
 		{
@@ -797,43 +792,47 @@ return {};
 		{
 			std::stringstream error_message;
 			error_message << "unexpected identifier " << current_lexeme.to_string() << " in restricted namespace, expected a type or function definition";
-			throw utils::parser_exception{ lexer_.current_lexeme().position, error_message.str() };
+			throw utils::parser_exception{ tokens_.current_lexeme().position, error_message.str() };
 		}
 		}
 	}
 
-	void register_built_in_types(ir::ast::statement::restricted_block* block)
+	void register_built_in_types(utils::symbol_table<ir::ast::type>& types, utils::interner& symbols, types::type_context& context)
 	{
-		auto& types = block->types;
-		types.emplace("void", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::void_));
-		types.emplace("bool", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::bool_));
-		types.emplace("string", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::string));
-		types.emplace("i8", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::i8));
-		types.emplace("i16", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::i16));
-		types.emplace("i32", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::i32));
-		types.emplace("i64", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::i64));
-		types.emplace("u8", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::u8));
-		types.emplace("u16", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::u16));
-		types.emplace("u32", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::u32));
-		types.emplace("u64", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::u64));
-		types.emplace("f32", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::f32));
-		types.emplace("f64", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::f64));
+		const auto add = [&](const std::string_view name, const ir::ast::type::built_in_type type)
+		{
+			types.add(symbols.intern(name), context.built_in(type));
+		};
+
+		add("void", ir::ast::type::built_in_type::void_);
+		add("bool", ir::ast::type::built_in_type::bool_);
+		add("string", ir::ast::type::built_in_type::string);
+		add("i8", ir::ast::type::built_in_type::i8);
+		add("i16", ir::ast::type::built_in_type::i16);
+		add("i32", ir::ast::type::built_in_type::i32);
+		add("i64", ir::ast::type::built_in_type::i64);
+		add("u8", ir::ast::type::built_in_type::u8);
+		add("u16", ir::ast::type::built_in_type::u16);
+		add("u32", ir::ast::type::built_in_type::u32);
+		add("u64", ir::ast::type::built_in_type::u64);
+		add("f32", ir::ast::type::built_in_type::f32);
+		add("f64", ir::ast::type::built_in_type::f64);
 	}
 
-	std::unique_ptr<ir::ast::statement::restricted_block> parser::parse_restricted_block_statement(bool is_type_scope)
+	ir::ast::statement::restricted_block* parser::parse_restricted_block_statement(bool is_type_scope)
 	{
-		const auto start_position = lexer_.current_lexeme().position;
+		const auto start_position = tokens_.current_lexeme().position;
 
 		const auto old_block = current_block;
-		auto new_block = std::make_unique<ir::ast::statement::restricted_block>(utils::position_range{ start_position, lexer_.current_lexeme().position });
-		current_block = new_block.get();
+		auto new_block = make_node<ir::ast::statement::restricted_block>(utils::position_range{ start_position, tokens_.current_lexeme().position }, node_resource());
+		current_block = new_block;
+		variables_.push_scope();
+		types_.push_scope();
 
-		register_built_in_types(new_block.get());
-
-		ir::ast::statement::restricted_list body;
+		ir::ast::statement::restricted_list body(node_resource());
 		while (true)
 		{
-			const auto current_lexeme = lexer_.current_lexeme();
+			const auto current_lexeme = tokens_.current_lexeme();
 
 			// Check whether we have any more lexemes to parse...
 			//
@@ -850,33 +849,191 @@ return {};
 				break;
 			}
 
+			// Imports only name modules, so they leave nothing in the tree
+			if (!is_type_scope && current_lexeme.type == lexer::lexeme_type::kw_import)
+			{
+				parse_import_statement();
+				continue;
+			}
+
 			// Parse a restricted statement
 			body.emplace_back(parse_restricted_statement());
 		}
 
+		types_.pop_scope();
+		variables_.pop_scope();
 		current_block = old_block;
 		new_block->body = std::move(body);
 		return new_block;
 	}
 
-	parser::parser(std::shared_ptr<types::module> current_module, const std::string_view filename, const std::string_view source) :
-		current_module(current_module), filename_(filename), lexer_(current_module, source) {}
+	void parser::parse_import_statement()
+	{
+		const auto start_position = tokens_.current_lexeme().position;
+
+		// Consume kw_import
+		tokens_.next_lexeme();
 
-	std::unique_ptr<ir::ast::statement::restricted_block> parser::parse()
+		expect(lexer::lexeme_type::identifier);
+		current_module->imports.push_back({ std::string{ tokens_.current_lexeme().value }, start_position });
+		tokens_.next_lexeme();
+	}
+
+	ir::ast::type* parser::import_type(const utils::position position, ir::ast::type* imported)
 	{
-		// get first lexeme
-		lexer_.next_lexeme();
+		const auto built_in = std::get_if<ir::ast::type::built_in_type>(&imported->value);
+		if (!built_in)
+		{
+			throw utils::parser_exception{ position, "cannot import a function whose signature uses a class type" };
+		}
+		return current_module->types.built_in(*built_in);
+	}
 
-		// create auto type
-		auto_type = std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::auto_);
+	std::vector<ir::ast::statement::restricted*> parser::declare_imports()
+	{
+		std::vector<ir::ast::statement::restricted*> declarations;
+		for (const auto& imported : current_module->imports)
+		{
+			const auto& dependencies = current_module->dependencies;
+			const auto dependency = std::find_if(dependencies.cbegin(), dependencies.cend(), [&](const auto& dependency)
+			{
+				return dependency->name == imported.name;
+			});
+			if (dependency == dependencies.cend() || !(*dependency)->body)
+			{
+				std::stringstream error_message;
+				error_message << "cannot find module '" << imported.name << '\'';
+				throw utils::parser_exception{ imported.position, error_message.str() };
+			}
 
-		// parse root
-		auto root = parse_restricted_block_statement();
+			const auto& symbols = (*dependency)->symbols;
+			for (const auto statement : (*dependency)->body->body)
+			{
+				const auto func = dynamic_cast<ir::ast::statement::function_definition*>(statement);
+				if (!func || func->signature->attributes.count("export") == 0)
+				{
+					continue;
+				}
+
+				// Symbols and types belong to the module they were made in, so they are made again in this one.
+				const auto exported = func->signature;
+				ir::ast::expression::parameter_list parameters{ node_resource() };
+				for (const auto param : exported->parameters)
+				{
+					parameters.push_back(make_node<ir::ast::expression::variable_ref>(utils::position_range{ imported.position, imported.position },
+						make_node<ir::ast::expression::variable>(current_module->symbols.intern(symbols.name(param->var->name)),
+							import_type(imported.position, param->var->type_))));
+				}
+
+				const auto signature = make_node<ir::ast::expression::function_signature>(
+					current_module->symbols.intern(symbols.name(exported->name)), current_module->symbols.intern(symbols.name(exported->mangled_name)),
+					import_type(imported.position, exported->return_type), std::move(parameters), ir::ast::expression::attribute_list{ node_resource() });
+				signature->is_extern = true;
+
+				if (!functions_.emplace(signature->name, signature).second)
+				{
+					std::stringstream error_message;
+					error_message << "cannot import function '" << symbols.name(exported->name) << "' from module '" << imported.name
+						<< "', a function with that name is already declared";
+					throw utils::parser_exception{ imported.position, error_message.str() };
+				}
+
+				declarations.push_back(make_node<ir::ast::statement::extern_function_definition>(
+					utils::position_range{ imported.position, imported.position }, signature));
+			}
+		}
+		return declarations;
+	}
+
+	parser::parser(std::shared_ptr<types::module> current_module, const std::uint32_t file_id, const std::string_view source,
+		utils::thread_pool* pool, const bool multi_pass, utils::statistics* statistics) :
+		current_module(current_module), lexer_(current_module, source, file_id, true), pool_(pool), statistics_(statistics),
+		multi_pass_(multi_pass)
+	{
+		if (multi_pass)
+		{
+			passes::pass::add_passes(passes_, *current_module, pool_);
+		}
+		else
+		{
+			passes_.add<passes::semantic>("semantic", {}, functions_, *current_module, pool_);
+			passes_.require("semantic");
+		}
+	}
+
+	ir::ast::statement::restricted_block* parser::parse()
+	{
+		const auto root = parse_syntax();
+		analyse(root);
+		return root;
+	}
+
+	ir::ast::statement::restricted_block* parser::parse_syntax()
+	{
+		// lex everything up front, then walk the buffer
+		{
+			utils::statistics::scope phase{ statistics_, "lex", "frontend" };
+			token_buffer_ = pool_ ? lexer_.tokenize(*pool_) : lexer_.tokenize();
+			phase.set_nodes(token_buffer_.size());
+		}
+		tokens_ = lexer::token_cursor{ token_buffer_ };
 
-		expect(lexer::lexeme_type::eof);
+		// look up auto type, and register built in types in a scope enclosing the root
+		auto_type = current_module->types.built_in(ir::ast::type::built_in_type::auto_);
+		types_.push_scope();
+		register_built_in_types(types_, current_module->symbols, current_module->types);
 
-		passes::pass::run_passes(root.get());
+		// parse root
+		ir::ast::statement::restricted_block* root;
+		{
+			utils::statistics::scope phase{ statistics_, "parse", "frontend" };
+			root = parse_restricted_block_statement();
+			expect(lexer::lexeme_type::eof);
+			phase.set_nodes(node_count_);
+		}
 
 		return root;
 	}
-}
\ No newline at end of file
+
+	void parser::analyse(ir::ast::statement::restricted_block* root)
+	{
+		run_passes(root, nullptr);
+	}
+
+	void parser::analyse(ir::ast::statement::restricted_block* root, const std::vector<ir::ast::statement::function_definition*>& functions)
+	{
+		run_passes(root, &functions);
+	}
+
+	void parser::run_passes(ir::ast::statement::restricted_block* root, const std::vector<ir::ast::statement::function_definition*>* functions)
+	{
+		// The separate passes collect functions from the tree, so they cannot leave any out.
+		const auto every_function = !functions || multi_pass_;
+
+		const auto imported = declare_imports();
+		if (imported.empty() && every_function)
+		{
+			passes_.run(root, statistics_);
+			return;
+		}
+
+		// Imported functions, then everything but the functions left out, in source order. The tree itself is left
+		// alone, as modules importing this one read it while it is analysed. Only function bodies are changed by the passes.
+		std::unordered_set<ir::ast::statement::restricted*> analysed;
+		if (!every_function)
+		{
+			analysed.insert(functions->cbegin(), functions->cend());
+		}
+
+		ir::ast::statement::restricted_list body{ imported.cbegin(), imported.cend(), node_resource() };
+		for (const auto statement : root->body)
+		{
+			if (every_function || statement->kind != ir::ast::node_kind::function_definition || analysed.count(statement) != 0)
+			{
+				body.push_back(statement);
+			}
+		}
+
+		passes_.run(current_module->arena.make<ir::ast::statement::restricted_block>(root->range, std::move(body)), statistics_);
+	}
+}
@@ -3,10 +3,17 @@
 #include "../ir/ast/statement.hpp"
 #include "../ir/ast/expression.hpp"
 #include "../lexer/lexer.hpp"
+#include "passes/function_collector.hpp"
+#include "passes/pass_manager.hpp"
 #include "../types/module.hpp"
+#include "../utils/statistics.hpp"
+#include "../utils/symbol_table.hpp"
 
 #include <memory>
+#include <memory_resource>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 namespace seam::parser
 {
@@ -14,17 +21,58 @@ namespace seam::parser
 	{
 		std::shared_ptr<types::module> current_module;
 
-		std::string_view filename_; // name of file currently being parsed.
 		lexer::lexer lexer_; // current lexer instance.
+		utils::thread_pool* pool_; // pool to lex and analyse on in parallel, or null to do both serially.
+		utils::statistics* statistics_; // statistics to record lexing, parsing and every pass in, or null.
+		lexer::token_buffer token_buffer_; // every lexeme of the source, filled by parse.
+		lexer::token_cursor tokens_; // current position in token_buffer_.
 
 		ir::ast::statement::base_block* current_block = nullptr;
+		utils::symbol_table<ir::ast::expression::variable> variables_; // variables visible in current_block.
+		utils::symbol_table<ir::ast::type> types_; // types visible in current_block.
+		passes::function_collector::function_map functions_; // every function declared so far.
+		passes::pass_manager passes_; // passes run over the tree once it is parsed.
+		bool multi_pass_; // whether passes_ collects functions from the tree itself, rather than taking functions_.
+		std::size_t node_count_ = 0; // nodes made so far.
 
-		std::shared_ptr<ir::ast::type> auto_type;
+		ir::ast::type* auto_type = nullptr;
+
+		/**
+		 * Constructs a node in the module's arena.
+		 *
+		 * @param args arguments to construct the node with.
+		 * @returns the node, owned by the module.
+		 */
+		template <typename T, typename... Args>
+		T* make_node(Args&&... args)
+		{
+			++node_count_;
+			return current_module->arena.make<T>(std::forward<Args>(args)...);
+		}
+
+		/**
+		 * Returns the memory resource for containers of nodes.
+		 *
+		 * @returns the module's arena resource.
+		 */
+		[[nodiscard]] std::pmr::memory_resource* node_resource() const
+		{
+			return current_module->arena.resource();
+		}
 
 		/**
 		 * 
 		 */
 		void skip_statement();
+
+		/**
+		 * Checks whether two positions in the current source are on the same line.
+		 *
+		 * @param start earlier position.
+		 * @param end later position.
+		 * @returns whether there is no newline between start and end.
+		 */
+		[[nodiscard]] bool is_same_line(utils::position start, utils::position end) const;
 		
 		/**
 		 * Checks whether current lexeme type matches expected.
@@ -43,7 +91,7 @@ namespace seam::parser
 		 *
 		 * @returns a type.
 		 */
-		std::shared_ptr<ir::ast::type> parse_type();
+		ir::ast::type* parse_type();
 
 		/**
 		 * Parses a parameter.
@@ -53,7 +101,7 @@ namespace seam::parser
 		 *
 		 * @returns a parameter.
 		 */
-		std::unique_ptr<ir::ast::expression::parameter> parse_parameter();
+		ir::ast::expression::parameter* parse_parameter();
 
 		/**
 		 * Parses a parameter list.
@@ -67,7 +115,7 @@ namespace seam::parser
 
 		ir::ast::expression::expression_list parse_expression_list();
 		
-		std::unique_ptr<ir::ast::expression::call> parse_call_expression(std::unique_ptr<ir::ast::expression::expression> function);
+		ir::ast::expression::call* parse_call_expression(ir::ast::expression::expression* function);
 		
 		/**
 		 * Parses any generic prefix expression.
@@ -75,9 +123,9 @@ namespace seam::parser
 		 * Attempts to parse a prefix expression and returns internal representation of
 		 * said expression.
 		 *
-		 * @returns a unique pointer to an expression node when successful, otherwise throws an exception.
+		 * @returns an expression node when successful, otherwise throws an exception.
 		 */
-		std::unique_ptr<ir::ast::expression::expression> parse_prefix_expression();
+		ir::ast::expression::expression* parse_prefix_expression();
 	
 		/**
 		 * Parses any generic expression.
@@ -85,29 +133,29 @@ namespace seam::parser
 		 * Attempts to parse an expression and returns internal representation of
 		 * said expression.
 		 *
-		 * @returns a unique pointer to an expression node when successful, otherwise throws an exception.
+		 * @returns an expression node when successful, otherwise throws an exception.
 		 */
-		std::unique_ptr<ir::ast::expression::expression> parse_expression();
+		ir::ast::expression::expression* parse_expression();
 		
-		std::pair<std::unique_ptr<ir::ast::expression::expression>, std::optional<lexer::lexeme_type>> parse_sub_expression(std::size_t limit = 0);
+		std::pair<ir::ast::expression::expression*, std::optional<lexer::lexeme_type>> parse_sub_expression(std::size_t limit = 0);
 
-		std::unique_ptr<ir::ast::expression::expression> parse_simple_expression();
+		ir::ast::expression::expression* parse_simple_expression();
 
 		/**
 		 * Parses primary expression
 		 * primary_expression = prefix_expression '.' name | prefix_expression call_args
 		 */
-		std::unique_ptr<ir::ast::expression::expression> parse_primary_expression();
+		ir::ast::expression::expression* parse_primary_expression();
 		
-		std::unique_ptr<ir::ast::statement::loop> parse_for_statement();
+		ir::ast::statement::loop* parse_for_statement();
 
-		std::unique_ptr<ir::ast::statement::ret> parse_return_statement();
+		ir::ast::statement::ret* parse_return_statement();
 
-		std::unique_ptr<ir::ast::statement::if_stat> parse_if_statement();
+		ir::ast::statement::if_stat* parse_if_statement();
 		
-		std::unique_ptr<ir::ast::statement::while_loop> parse_while_statement();
+		ir::ast::statement::while_loop* parse_while_statement();
 
-		std::unique_ptr<ir::ast::statement::statement> parse_assignment_statement();
+		ir::ast::statement::statement* parse_assignment_statement();
 		
 		/**
 		 * Parses a block statement.
@@ -115,32 +163,33 @@ namespace seam::parser
 		 * A block is considered to be the main body of any method,
 		 * and can contain both statements and expressions.
 		 *
-		 * @returns a unique pointer to a block ast node when successful, otherwise throws an exception.
+		 * @param parameters function parameters to bring into the block's scope.
+		 * @returns a block ast node when successful, otherwise throws an exception.
 		 */
-		std::unique_ptr<ir::ast::statement::normal_block> parse_block_statement();
+		ir::ast::statement::normal_block* parse_block_statement(const ir::ast::expression::parameter_list& parameters = {});
 
 		/**
 		 * Parses a function definition statement.
 		 *
-		 * @returns a unique pointer to a function definition ast node when successful, otherwise throws an exception.
+		 * @returns a function definition ast node when successful, otherwise throws an exception.
 		 */
-		std::shared_ptr<ir::ast::expression::function_signature> parse_function_signature();
+		ir::ast::expression::function_signature* parse_function_signature();
 
 		/**
 		 * Parses a function definition statement.
 		 *
-		 * @returns a unique pointer to a function definition ast node when successful, otherwise throws an exception.
+		 * @returns a function definition ast node when successful, otherwise throws an exception.
 		 */
-		std::unique_ptr<ir::ast::statement::function_definition> parse_function_definition_statement();
+		ir::ast::statement::function_definition* parse_function_definition_statement();
 		
-		std::unique_ptr<ir::ast::statement::extern_function_definition> parse_extern_function_definition_statement();
+		ir::ast::statement::extern_function_definition* parse_extern_function_definition_statement();
 
 		/**
 		 * Parses a type definition statement.
 		 *
-		 * @returns a unique pointer to a type definition ast node when successful, otherwise throws an exception.
+		 * @returns a type definition ast node when successful, otherwise throws an exception.
 		 */
-		std::unique_ptr<ir::ast::statement::type_definition> parse_type_definition_statement();
+		ir::ast::statement::type_definition* parse_type_definition_statement();
 		
 		/**
 		 * Parses a restricted statement.
@@ -151,9 +200,9 @@ namespace seam::parser
 		 * - type
 		 * - extern
 		 *
-		 * @returns a unique pointer to a restricted statement ast node when successful, otherwise throws an exception.
+		 * @returns a restricted statement ast node when successful, otherwise throws an exception.
 		 */
-		std::unique_ptr<ir::ast::statement::restricted> parse_restricted_statement();
+		ir::ast::statement::restricted* parse_restricted_statement();
 		
 		/**
 		 * Parses a restricted block statement.
@@ -166,23 +215,102 @@ namespace seam::parser
 		 * - extern
 		 *
 		 * @param is_type_scope whether we're parsing in a type scope.
-		 * @returns a unique pointer to a restricted block ast node when successful, otherwise throws an exception.
+		 * @returns a restricted block ast node when successful, otherwise throws an exception.
+		 */
+		ir::ast::statement::restricted_block* parse_restricted_block_statement(bool is_type_scope = false);
+
+		/**
+		 * Parses an import statement, adding the module it names to the imports of the current module.
+		 */
+		void parse_import_statement();
+
+		/**
+		 * Returns the type of the current module matching a type of another module.
+		 *
+		 * @param position position to report an error at.
+		 * @param imported type of the other module.
+		 * @returns the type, otherwise throws an exception.
+		 */
+		ir::ast::type* import_type(utils::position position, ir::ast::type* imported);
+
+		/**
+		 * Declares every function exported by an imported module, as an extern function of the current module.
+		 *
+		 * Each import must name one of the dependencies of the module, which
+		 * must have been parsed. Only their signatures are read, so they may
+		 * be analysed and generated at the same time.
+		 *
+		 * @returns declarations, which are not added to the tree.
+		 */
+		std::vector<ir::ast::statement::restricted*> declare_imports();
+
+		/**
+		 * Declares imported functions, then runs the passes over a tree made by parse_syntax.
+		 *
+		 * @param root root of the module.
+		 * @param functions functions to analyse, or null for every function.
 		 */
-		std::unique_ptr<ir::ast::statement::restricted_block> parse_restricted_block_statement(bool is_type_scope = false);
+		void run_passes(ir::ast::statement::restricted_block* root, const std::vector<ir::ast::statement::function_definition*>* functions);
 	public:
 		/**
-		 * Initialise parser with name of file being parsed, as well
+		 * Initialise parser with id of file being parsed, as well
 		 * as its respective source.
 		 *
 		 * @param current_module the module to be parsed.
-		 * @param filename name of file to be parsed.
+		 * @param file_id id of file to be parsed, see utils::source_map.
 		 * @param source source of file to parse.
+		 * @param pool pool to lex large sources and analyse function bodies on in parallel, or null to do both serially.
+		 * @param multi_pass whether to collect functions, resolve symbols and infer types in separate
+		 * passes over the tree rather than in one, which is slower but easier to debug.
+		 * @param statistics statistics to record lexing, parsing and every pass in, or null.
+		 */
+		explicit parser(std::shared_ptr<types::module> current_module, std::uint32_t file_id, std::string_view source,
+			utils::thread_pool* pool = nullptr, bool multi_pass = false, utils::statistics* statistics = nullptr);
+
+		/**
+		 * Returns the passes parse runs over the tree, so they can be disabled.
+		 *
+		 * @returns pass manager of the parser.
 		 */
-		explicit parser(std::shared_ptr<types::module> current_module, const std::string_view filename, const std::string_view source);
+		passes::pass_manager& passes()
+		{
+			return passes_;
+		}
 
 		/**
 		 * TODO: Comment this
 		 */
-		std::unique_ptr<ir::ast::statement::restricted_block> parse();
+		ir::ast::statement::restricted_block* parse();
+
+		/**
+		 * Parses the module without running any pass over it.
+		 *
+		 * Symbols are left unresolved and auto variables untyped, until
+		 * analyse runs the passes over the functions which need them. The
+		 * modules named by import statements are added to the imports of
+		 * the module, to be made its dependencies before then.
+		 *
+		 * @returns root of the module.
+		 */
+		ir::ast::statement::restricted_block* parse_syntax();
+
+		/**
+		 * Runs the passes over every function of a tree made by parse_syntax.
+		 *
+		 * @param root root of the module.
+		 */
+		void analyse(ir::ast::statement::restricted_block* root);
+
+		/**
+		 * Runs the passes over some functions of a tree made by parse_syntax.
+		 *
+		 * Functions left out stay unresolved, so they cannot be generated.
+		 * The separate passes of multi_pass collect functions from the tree
+		 * they run over, so with them every function is analysed.
+		 *
+		 * @param root root of the module.
+		 * @param functions functions to analyse, from the module.
+		 */
+		void analyse(ir::ast::statement::restricted_block* root, const std::vector<ir::ast::statement::function_definition*>& functions);
 	};
 }
@@ -1,7 +1,7 @@
 #include "function_collector.hpp"
 #include "../../utils/exception.hpp"
 #include "../../ir/ast/statement.hpp"
-#include "../../ir/ast/visitor.hpp"
+#include "../../ir/ast/walker.hpp"
 
 #include <sstream>
 
@@ -9,17 +9,19 @@ namespace seam::parser::passes
 {
     using namespace ir::ast;
 
-    struct collector : visitor
+    struct collector : walker<collector>
 	{
+        using walker::visit;
+
 		function_collector::function_map& function_map_;
 
-        bool visit(statement::extern_function_definition* node) override
+        bool visit(statement::extern_function_definition* node)
         {
             function_map_.emplace(node->signature->name, node->signature);
             return false;
         }
 
-        bool visit(statement::function_definition* node) override
+        bool visit(statement::function_definition* node)
 		{
             function_map_.emplace(node->signature->name, node->signature);
             return true;
@@ -33,6 +35,6 @@ namespace seam::parser::passes
     void function_collector::run(node* node)
     {
 	    collector vst{ function_map_ };
-	    node->visit(&vst);
+	    vst.walk(node);
     }
 }
@@ -5,13 +5,12 @@
 
 #include <memory>
 #include <unordered_map>
-#include <string>
 
 namespace seam::parser::passes
 {
     struct function_collector final : pass
 	{
-		using function_map = std::unordered_map<std::string, std::shared_ptr<ir::ast::expression::function_signature>>;
+		using function_map = std::unordered_map<utils::symbol_id, ir::ast::expression::function_signature*>;
 		function_map function_map_;
 
 		void run(ir::ast::node* node) override;
@@ -1,7 +1,8 @@
 #include "function_resolver.hpp"
+#include "parallel.hpp"
 #include "../../ir/ast/type.hpp"
 #include "../../utils/exception.hpp"
-#include "../../ir/ast/visitor.hpp"
+#include "../../ir/ast/walker.hpp"
 #include "../../ir/ast/expression.hpp"
 
 #include <memory>
@@ -11,37 +12,66 @@ namespace seam::parser::passes
 {
     using namespace ir::ast;
 
-	struct resolver : visitor
+	struct resolver : walker<resolver>
 	{
+		using walker::visit;
+
 		const function_collector::function_map& function_map_;
+		seam::types::module& module_;
+		utils::arena& arena_; // arena resolved symbols are made in
+		dependency_list& dependencies_; // calls found so far
+		statement::function_definition* function_ = nullptr; // function being walked, which depends on every function it calls
 
-		bool visit(expression::symbol_wrapper* node) override
+		bool visit(statement::function_definition* node)
 		{
-			const auto& symbol_name = static_cast<expression::unresolved_symbol*>(node->value.get())->value;
-			const auto& it = function_map_.find(symbol_name);
+			function_ = node;
+			return true;
+		}
+
+		bool visit(expression::symbol_wrapper* node)
+		{
+			const auto symbol = static_cast<expression::unresolved_symbol*>(node->value)->value;
+			const auto& it = function_map_.find(symbol);
 			if (it == function_map_.cend())
 			{
 				std::stringstream error_message;
-				error_message << "cannot resolve symbol '" << symbol_name << '\'';
+				error_message << "cannot resolve symbol '" << module_.symbols.name(symbol) << '\'';
 				throw utils::parser_exception{ node->range.start, error_message.str() };
 			}
-			node->value = std::make_unique<expression::resolved_symbol>(it->second);
+			node->value = arena_.make<expression::resolved_symbol>(it->second);
+			if (function_)
+			{
+				dependencies_.push_back({ function_, it->second });
+			}
 			
 			return false;
 		}
 
-		resolver(const function_collector::function_map& function_map_) :
-			function_map_(function_map_)
+		resolver(const function_collector::function_map& function_map_, seam::types::module& module_, utils::arena& arena_,
+			dependency_list& dependencies_) :
+			function_map_(function_map_), module_(module_), arena_(arena_), dependencies_(dependencies_)
 		{}
 	};
 
 	void function_resolver::run(node* node)
 	{
-		resolver vst{ function_map_ };
-		node->visit(&vst);
+		if (pool_)
+		{
+			walk_functions(node, module_, *pool_, [this](utils::arena& arena, dependency_list& dependencies)
+			{
+				return resolver{ collector_.function_map_, module_, arena, dependencies };
+			});
+			return;
+		}
+
+		dependency_list dependencies;
+		resolver vst{ collector_.function_map_, module_, module_.arena, dependencies };
+		vst.walk(node);
+		add_function_dependencies(dependencies);
 	}
 
-	function_resolver::function_resolver(const function_collector::function_map& function_map_) :
-		function_map_(function_map_)
+	function_resolver::function_resolver(const function_collector& collector_, seam::types::module& module_,
+		utils::thread_pool* pool_) :
+		collector_(collector_), module_(module_), pool_(pool_)
 	{}
 }
@@ -2,15 +2,20 @@
 
 #include "pass.hpp"
 #include "function_collector.hpp"
+#include "../../types/module.hpp"
+#include "../../utils/thread_pool.hpp"
 
 namespace seam::parser::passes
 {
 	struct function_resolver : pass
 	{
-		const function_collector::function_map& function_map_;
+		const function_collector& collector_;
+		seam::types::module& module_;
+		utils::thread_pool* pool_; // pool to resolve function bodies on in parallel, or null to resolve serially.
 
 		void run(ir::ast::node* node) override;
 
-		explicit function_resolver(const function_collector::function_map& function_map_);
+		explicit function_resolver(const function_collector& collector_, seam::types::module& module_,
+			utils::thread_pool* pool_ = nullptr);
 	};
 }
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "../../ir/ast/statement.hpp"
+#include "../../ir/ast/walker.hpp"
+#include "../../types/module.hpp"
+#include "../../utils/arena.hpp"
+#include "../../utils/exception.hpp"
+#include "../../utils/thread_pool.hpp"
+
+namespace seam::parser::passes
+{
+	/**
+	 * Finds every function definition of a tree, in source order.
+	 */
+	struct function_finder : ir::ast::walker<function_finder>
+	{
+		std::vector<ir::ast::statement::function_definition*> functions;
+
+		using walker::visit;
+
+		bool visit(ir::ast::statement::function_definition* node)
+		{
+			functions.push_back(node);
+			return false;
+		}
+	};
+
+	/**
+	 * A call found by a walker, recorded as a dependency of the calling function.
+	 */
+	struct function_dependency
+	{
+		ir::ast::statement::function_definition* caller;
+		ir::ast::expression::function_signature* callee;
+	};
+
+	/**
+	 * Calls found by a walker.
+	 *
+	 * The dependency sets of functions are made in the arena of the module,
+	 * which tasks may not allocate from, so walkers collect calls here and
+	 * add_function_dependencies copies them over once no task is running.
+	 */
+	using dependency_list = std::vector<function_dependency>;
+
+	/**
+	 * Adds calls collected by a walker to the dependencies of the functions making them.
+	 *
+	 * @param dependencies calls to add.
+	 */
+	inline void add_function_dependencies(const dependency_list& dependencies)
+	{
+		for (const auto& [caller, callee] : dependencies)
+		{
+			caller->function_dependencies.insert(callee);
+		}
+	}
+
+	/**
+	 * Walks every function definition of a tree on a pool, each task with a walker of its own.
+	 *
+	 * Symbols and assignments only appear in function bodies, which do not
+	 * share anything a pass modifies, so they can be walked in any order. The
+	 * functions are split into more tasks than there are workers so idle
+	 * workers have something to steal. Every function is walked even once one
+	 * throws, and the errors are rethrown in source order once every task is
+	 * done, so what is reported does not depend on scheduling. The calls
+	 * recorded by every task are added to the dependencies of their functions
+	 * after that.
+	 *
+	 * @param root root of tree.
+	 * @param module module the tree belongs to, which owns an arena per task, kept for later walks.
+	 * @param pool pool to walk the functions on.
+	 * @param make_walker makes the walker of a task, given an arena only that task allocates from and the list it records calls in.
+	 * @throws utils::exception_list when several functions fail.
+	 */
+	template <typename MakeWalker>
+	void walk_functions(ir::ast::node* root, seam::types::module& module, utils::thread_pool& pool, MakeWalker&& make_walker)
+	{
+		function_finder finder;
+		finder.walk(root);
+		const auto& functions = finder.functions;
+
+		constexpr std::size_t tasks_per_worker = 8;
+		const auto task_count = std::min(functions.size(), pool.size() * tasks_per_worker);
+		if (task_count == 0)
+		{
+			return;
+		}
+
+		// Nodes made by earlier walks may still be in use, so arenas are only ever added to.
+		while (module.task_arenas.size() < task_count)
+		{
+			module.task_arenas.push_back(std::make_unique<utils::arena>(4 * 1024));
+		}
+
+		std::vector<std::exception_ptr> failures(functions.size()); // exception of each function
+		std::vector<dependency_list> dependencies(task_count); // calls recorded by each task
+		std::vector<std::future<void>> pending;
+		pending.reserve(task_count);
+
+		for (std::size_t task = 0; task < task_count; ++task)
+		{
+			const auto begin = functions.size() * task / task_count;
+			const auto end = functions.size() * (task + 1) / task_count;
+
+			pending.push_back(pool.submit([&, task, begin, end]()
+			{
+				auto walker = make_walker(*module.task_arenas[task], dependencies[task]);
+				for (auto i = begin; i < end; ++i)
+				{
+					try
+					{
+						walker.walk(functions[i]);
+					}
+					catch (...)
+					{
+						failures[i] = std::current_exception();
+					}
+				}
+			}));
+		}
+
+		for (auto& result : pending)
+		{
+			pool.wait(result);
+			result.get();
+		}
+
+		utils::rethrow_all(failures);
+
+		for (const auto& task_dependencies : dependencies)
+		{
+			add_function_dependencies(task_dependencies);
+		}
+	}
+}
@@ -2,20 +2,27 @@
 
 #include "function_collector.hpp"
 #include "function_resolver.hpp"
+#include "pass_manager.hpp"
 #include "types.hpp"
 
 namespace seam::parser::passes
 {
-    void pass::run_passes(ir::ast::node* root)
+    void pass::add_passes(pass_manager& manager, seam::types::module& module, utils::thread_pool* pool)
     {
         // resolve symbols (types and functions)
-        function_collector function_collector_;
-		function_collector_.run(root);
+        const auto& function_collector_ = manager.add<function_collector>("function_collector", {});
+        manager.add<function_resolver>("function_resolver", { "function_collector" }, function_collector_, module, pool);
+        manager.add<types>("types", { "function_resolver" }, module, pool);
 
-        function_resolver function_resolver_{ function_collector_.function_map_ };
-		function_resolver_.run(root);
+        // Code generation takes every symbol to be resolved and every variable to be typed.
+        manager.require("function_resolver");
+        manager.require("types");
+    }
 
-		types types_;
-		types_.run(root);
+    void pass::run_passes(ir::ast::node* root, seam::types::module& module, utils::thread_pool* pool)
+    {
+        pass_manager manager;
+        add_passes(manager, module, pool);
+        manager.run(root);
     }
-}
\ No newline at end of file
+}
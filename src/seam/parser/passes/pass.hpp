@@ -1,14 +1,27 @@
 #pragma once
 
 #include "../../ir/ast/node.hpp"
+#include "../../types/module.hpp"
+#include "../../utils/thread_pool.hpp"
 
 namespace seam::parser::passes
 {
+    class pass_manager;
+
     struct pass
     {
         virtual void run(ir::ast::node* node) = 0;
         virtual ~pass() = default;
 
-        static void run_passes(ir::ast::node* root);
+        /**
+         * Registers the separate collection, resolution and typing passes, as required passes.
+         *
+         * @param manager manager to register the passes with.
+         * @param module module the passes resolve and type.
+         * @param pool pool to run the passes over function bodies in parallel on, or null to run them serially.
+         */
+        static void add_passes(pass_manager& manager, seam::types::module& module, utils::thread_pool* pool = nullptr);
+
+        static void run_passes(ir::ast::node* root, seam::types::module& module, utils::thread_pool* pool = nullptr);
     };
 }
@@ -0,0 +1,127 @@
+#include "pass_manager.hpp"
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+
+namespace seam::parser::passes
+{
+	std::size_t pass_manager::find(const std::string_view name) const
+	{
+		for (std::size_t i = 0; i < passes_.size(); ++i)
+		{
+			if (passes_[i].name == name)
+			{
+				return i;
+			}
+		}
+
+		std::stringstream error_message;
+		error_message << "unknown pass '" << name << '\'';
+		throw std::runtime_error(error_message.str());
+	}
+
+	void pass_manager::add(std::string name, std::unique_ptr<pass> instance, std::vector<std::string> dependencies)
+	{
+		for (const auto& existing : passes_)
+		{
+			if (existing.name == name)
+			{
+				std::stringstream error_message;
+				error_message << "pass '" << name << "' was already added";
+				throw std::runtime_error(error_message.str());
+			}
+		}
+
+		passes_.push_back({ std::move(name), std::move(instance), std::move(dependencies) });
+	}
+
+	void pass_manager::require(const std::string_view name)
+	{
+		passes_[find(name)].required = true;
+	}
+
+	void pass_manager::disable(const std::string_view name)
+	{
+		auto& disabled = passes_[find(name)];
+		if (disabled.required)
+		{
+			std::stringstream error_message;
+			error_message << "pass '" << name << "' is required and cannot be disabled";
+			throw std::runtime_error(error_message.str());
+		}
+
+		disabled.enabled = false;
+	}
+
+	std::vector<std::string> pass_manager::schedule() const
+	{
+		enum class state : std::uint8_t
+		{
+			pending,
+			visiting,
+			scheduled,
+			skipped,
+		};
+
+		std::vector<state> states(passes_.size(), state::pending);
+		std::vector<std::string> order;
+
+		// Depth first over dependencies, starting from each pass in the order they were added.
+		const auto visit = [&](const auto& self, const std::size_t index) -> void
+		{
+			if (states[index] == state::scheduled || states[index] == state::skipped)
+			{
+				return;
+			}
+
+			if (states[index] == state::visiting)
+			{
+				std::stringstream error_message;
+				error_message << "dependencies of pass '" << passes_[index].name << "' form a cycle";
+				throw std::runtime_error(error_message.str());
+			}
+
+			states[index] = state::visiting;
+
+			auto runnable = passes_[index].enabled;
+			for (const auto& dependency : passes_[index].dependencies)
+			{
+				const auto dependency_index = find(dependency);
+				self(self, dependency_index);
+				runnable = runnable && states[dependency_index] == state::scheduled;
+			}
+
+			// Later stages would read the results of a required pass, whether it ran or not.
+			if (!runnable && passes_[index].required)
+			{
+				std::stringstream error_message;
+				error_message << "pass '" << passes_[index].name << "' is required, but a pass it depends on is disabled";
+				throw std::runtime_error(error_message.str());
+			}
+
+			states[index] = runnable ? state::scheduled : state::skipped;
+			if (runnable)
+			{
+				order.push_back(passes_[index].name);
+			}
+		};
+
+		for (std::size_t i = 0; i < passes_.size(); ++i)
+		{
+			visit(visit, i);
+		}
+
+		return order;
+	}
+
+	void pass_manager::run(ir::ast::node* root, utils::statistics* statistics)
+	{
+		// Passes do not count the nodes they visit, which would slow their walkers down for every compilation.
+		for (const auto& name : schedule())
+		{
+			utils::statistics::scope phase{ statistics, name, "pass" };
+			passes_[find(name)].instance->run(root);
+		}
+	}
+}
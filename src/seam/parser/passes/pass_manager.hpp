@@ -0,0 +1,109 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "pass.hpp"
+#include "../../ir/ast/node.hpp"
+#include "../../utils/statistics.hpp"
+
+namespace seam::parser::passes
+{
+	/**
+	 * Owns a set of passes and runs them over a tree in an order which respects their dependencies.
+	 *
+	 * Passes run in the order they were added, except that a pass always runs
+	 * after every pass it depends on. A disabled pass does not run, and neither
+	 * does any pass which depends on it, directly or not. Passes which later
+	 * stages rely on are marked required, and may not be kept from running.
+	 */
+	class pass_manager
+	{
+		struct entry
+		{
+			std::string name;
+			std::unique_ptr<pass> instance;
+			std::vector<std::string> dependencies;
+			bool enabled = true;
+			bool required = false; // whether later stages rely on its results
+		};
+
+		std::vector<entry> passes_;
+
+		/**
+		 * Returns the entry of a pass.
+		 *
+		 * @param name name of pass.
+		 * @returns index of entry.
+		 * @throws std::runtime_error if no pass has that name.
+		 */
+		[[nodiscard]] std::size_t find(std::string_view name) const;
+
+	public:
+		/**
+		 * Adds a pass.
+		 *
+		 * @param name unique name of the pass, used for dependencies, disabling and statistics.
+		 * @param dependencies names of passes which must run before it, they may be added later.
+		 * @param args arguments to construct the pass with.
+		 * @returns the pass, owned by the manager.
+		 * @throws std::runtime_error if a pass with that name was already added.
+		 */
+		template <typename T, typename... Args>
+		T& add(std::string name, std::vector<std::string> dependencies, Args&&... args)
+		{
+			auto instance = std::make_unique<T>(std::forward<Args>(args)...);
+			auto& result = *instance;
+			add(std::move(name), std::move(instance), std::move(dependencies));
+			return result;
+		}
+
+		/**
+		 * Adds a pass.
+		 *
+		 * @param name unique name of the pass, used for dependencies, disabling and statistics.
+		 * @param instance the pass.
+		 * @param dependencies names of passes which must run before it, they may be added later.
+		 * @throws std::runtime_error if a pass with that name was already added.
+		 */
+		void add(std::string name, std::unique_ptr<pass> instance, std::vector<std::string> dependencies = {});
+
+		/**
+		 * Marks a pass as relied on by later stages, so neither it nor any pass it depends on may be disabled.
+		 *
+		 * @param name name of pass.
+		 * @throws std::runtime_error if no pass has that name.
+		 */
+		void require(std::string_view name);
+
+		/**
+		 * Stops a pass, and every pass depending on it, from running.
+		 *
+		 * @param name name of pass.
+		 * @throws std::runtime_error if no pass has that name or the pass is required.
+		 */
+		void disable(std::string_view name);
+
+		/**
+		 * Returns the names of the passes which would run, in the order they would run in.
+		 *
+		 * @returns names of passes.
+		 * @throws std::runtime_error if a dependency was never added, dependencies form a cycle or a required pass
+		 * would not run.
+		 */
+		[[nodiscard]] std::vector<std::string> schedule() const;
+
+		/**
+		 * Runs every enabled pass over a tree.
+		 *
+		 * @param root root of tree.
+		 * @param statistics statistics to record a phase per pass in, or null.
+		 * @throws std::runtime_error if a dependency was never added, dependencies form a cycle or a required pass
+		 * would not run.
+		 */
+		void run(ir::ast::node* root, utils::statistics* statistics = nullptr);
+	};
+}
@@ -0,0 +1,113 @@
+#include "semantic.hpp"
+#include "parallel.hpp"
+#include "types.hpp"
+#include "../../ir/ast/walker.hpp"
+#include "../../utils/exception.hpp"
+
+#include <sstream>
+
+namespace seam::parser::passes
+{
+	using namespace ir::ast;
+
+	struct analyser : walker<analyser>
+	{
+		const function_collector::function_map& functions_;
+		seam::types::module& module_;
+		utils::arena& arena_; // arena resolved symbols are made in
+		dependency_list& dependencies_; // calls found so far
+		type* auto_type;
+		statement::function_definition* function_ = nullptr; // function being walked, which depends on every function it calls
+
+		using walker::visit;
+
+		bool visit(statement::function_definition* node)
+		{
+			function_ = node;
+			return true;
+		}
+
+		bool visit(expression::symbol_wrapper* node)
+		{
+			const auto symbol = static_cast<expression::unresolved_symbol*>(node->value)->value;
+			const auto& it = functions_.find(symbol);
+			if (it == functions_.cend())
+			{
+				std::stringstream error_message;
+				error_message << "cannot resolve symbol '" << module_.symbols.name(symbol) << '\'';
+				throw utils::parser_exception{ node->range.start, error_message.str() };
+			}
+			node->value = arena_.make<expression::resolved_symbol>(it->second);
+			if (function_)
+			{
+				dependencies_.push_back({ function_, it->second });
+			}
+
+			return false;
+		}
+
+		bool visit(expression::variable_ref* node)
+		{
+			node->eval_type = node->var->type_;
+			return false;
+		}
+
+		bool visit(expression::unary* node)
+		{
+			walk(node->right);
+			node->eval_type = node->right->eval_type;
+			return false;
+		}
+
+		bool visit(expression::binary* node)
+		{
+			walk(node->left);
+			walk(node->right);
+			node->eval_type = get_dominant_type(module_.types, node->left->eval_type, node->right->eval_type);
+			return false;
+		}
+
+		bool visit(statement::assignment* node)
+		{
+			walk(node->from);
+			walk(node->to);
+
+			if (const auto var = dynamic_cast<expression::variable_ref*>(node->to))
+			{
+				if (var->var->type_ == auto_type)
+				{
+					var->var->type_ = node->from->eval_type;
+					var->eval_type = var->var->type_;
+				}
+			}
+			return false;
+		}
+
+		analyser(const function_collector::function_map& functions_, seam::types::module& module_, utils::arena& arena_,
+			dependency_list& dependencies_) :
+			functions_(functions_), module_(module_), arena_(arena_), dependencies_(dependencies_), auto_type(module_.types.built_in(type::built_in_type::auto_))
+		{}
+	};
+
+	void semantic::run(node* node)
+	{
+		if (pool_)
+		{
+			walk_functions(node, module_, *pool_, [this](utils::arena& arena, dependency_list& dependencies)
+			{
+				return analyser{ functions_, module_, arena, dependencies };
+			});
+			return;
+		}
+
+		dependency_list dependencies;
+		analyser vst{ functions_, module_, module_.arena, dependencies };
+		vst.walk(node);
+		add_function_dependencies(dependencies);
+	}
+
+	semantic::semantic(const function_collector::function_map& functions_, seam::types::module& module_,
+		utils::thread_pool* pool_) :
+		functions_(functions_), module_(module_), pool_(pool_)
+	{}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "pass.hpp"
+#include "function_collector.hpp"
+#include "../../types/module.hpp"
+#include "../../utils/thread_pool.hpp"
+
+namespace seam::parser::passes
+{
+	/**
+	 * Resolves function symbols and infers the types of auto variables in a single traversal.
+	 *
+	 * Does the work of function_resolver and types, but takes the functions
+	 * gathered by the parser instead of collecting them with another walk
+	 * over the tree. Expressions are typed bottom up as the walk leaves them,
+	 * and their eval_type is filled in along the way.
+	 */
+	struct semantic final : pass
+	{
+		const function_collector::function_map& functions_;
+		seam::types::module& module_;
+		utils::thread_pool* pool_; // pool to analyse function bodies on in parallel, or null to analyse serially.
+
+		void run(ir::ast::node* node) override;
+
+		explicit semantic(const function_collector::function_map& functions_, seam::types::module& module_,
+			utils::thread_pool* pool_ = nullptr);
+	};
+}
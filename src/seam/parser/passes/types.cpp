@@ -1,97 +1,118 @@
 #include "types.hpp"
-#include "../../ir/ast/visitor.hpp"
+#include "parallel.hpp"
+#include "../../ir/ast/walker.hpp"
 #include "../../utils/exception.hpp"
 
 #include <iostream>
 
 namespace seam::parser::passes
 {
-	std::shared_ptr<ir::ast::type> get_dominant_type(const std::shared_ptr<ir::ast::type>& a, const std::shared_ptr<ir::ast::type>& b)
+	ir::ast::type* get_dominant_type(seam::types::type_context& context, ir::ast::type* a, ir::ast::type* b)
 	{
-		const auto built_in_type_a = std::get_if<ir::ast::type::built_in_type>(&a->value);
-		const auto built_in_type_b = std::get_if<ir::ast::type::built_in_type>(&b->value);
-
-		if (built_in_type_a && built_in_type_b)
+		// Untyped operands, such as number literals without a suffix, take the type of the other side.
+		if (a == b || !b)
 		{
-			if (((*built_in_type_a >= ir::ast::type::built_in_type::i8 && *built_in_type_a <= ir::ast::type::built_in_type::i64)
-				&& (*built_in_type_b >= ir::ast::type::built_in_type::i8 && *built_in_type_b <= ir::ast::type::built_in_type::i64))
-
-				|| ((*built_in_type_a >= ir::ast::type::built_in_type::u8 && *built_in_type_a <= ir::ast::type::built_in_type::u64)
-					&& (*built_in_type_b >= ir::ast::type::built_in_type::u8 && *built_in_type_b <= ir::ast::type::built_in_type::u64))
+			return a;
+		}
 
-				|| ((*built_in_type_a >= ir::ast::type::built_in_type::f32 && *built_in_type_a <= ir::ast::type::built_in_type::f64))
-					&& (*built_in_type_b >= ir::ast::type::built_in_type::f32 && *built_in_type_b <= ir::ast::type::built_in_type::f64))
-			{
-				return (built_in_type_a > built_in_type_b) ? a : b;
-			}
-			else
-			{
-				throw std::runtime_error("can't determine dominant type, probably a type error");
-			}
+		if (!a)
+		{
+			return b;
 		}
-		else
+
+		if (const auto dominant = context.dominant(a, b))
 		{
-			throw std::runtime_error("class types are not supported");
+			return dominant;
 		}
+
+		throw std::runtime_error("can't determine dominant type, probably a type error");
 	}
 
-	struct type_getter : ir::ast::visitor
+	struct type_getter : ir::ast::walker<type_getter>
 	{
-		std::shared_ptr<ir::ast::type> type;
+		using walker::visit;
 
-		bool visit(ir::ast::expression::variable_ref* var) override
+		seam::types::type_context& context;
+		ir::ast::type* type = nullptr;
+
+		explicit type_getter(seam::types::type_context& context) :
+			context(context)
+		{}
+
+		bool visit(ir::ast::expression::variable_ref* var)
 		{
 			type = var->var->type_;
 			return false;
 		}
 
-		bool visit(ir::ast::expression::number_literal* num) override
+		bool visit(ir::ast::expression::number_literal* num)
 		{
+			type = num->eval_type;
 			return false;
 		}
 
-		bool visit(ir::ast::expression::binary* binary) override
+		bool visit(ir::ast::expression::binary* binary)
 		{
-			binary->left->visit(this);
+			walk(binary->left);
 			const auto left_type = type;
 
-			binary->right->visit(this);
+			walk(binary->right);
 			const auto right_type = type;
 
-			type = get_dominant_type(left_type, right_type);
+			type = get_dominant_type(context, left_type, right_type);
 
 			return false;
 		}
 	};
 
-	std::shared_ptr<ir::ast::type> resolve_type(ir::ast::expression::expression* expr)
+	ir::ast::type* resolve_type(seam::types::type_context& context, ir::ast::expression::expression* expr)
 	{
-		type_getter vst;
-		expr->visit(&vst);
+		type_getter vst{ context };
+		vst.walk(expr);
 		return vst.type;
 	}
 
-	struct visitor : ir::ast::visitor
+	struct visitor : ir::ast::walker<visitor>
 	{
-		bool visit(ir::ast::statement::assignment* node) override
+		using walker::visit;
+
+		seam::types::type_context& context;
+		ir::ast::type* auto_type;
+
+		explicit visitor(seam::types::type_context& context) :
+			context(context), auto_type(context.built_in(ir::ast::type::built_in_type::auto_))
+		{}
+
+		bool visit(ir::ast::statement::assignment* node)
 		{
-			if (const auto var = dynamic_cast<ir::ast::expression::variable_ref*>(node->to.get()))
+			if (const auto var = dynamic_cast<ir::ast::expression::variable_ref*>(node->to))
 			{
-				if (const auto built_in = std::get_if<ir::ast::type::built_in_type>(&var->var->type_->value))
+				if (var->var->type_ == auto_type)
 				{
-					if (*built_in == ir::ast::type::built_in_type::auto_)
-					{
-						var->var->type_ = resolve_type(node->from.get());
-					}
+					var->var->type_ = resolve_type(context, node->from);
 				}
 			}
 			return false;
 		}
 	};
 
+	types::types(seam::types::module& module_, utils::thread_pool* pool_) :
+		module_(module_), context_(module_.types), pool_(pool_)
+	{}
+
 	void types::run(ir::ast::node* node)
 	{
-		visitor vst;
-		node->visit(&vst);
+		// Variables belong to a single function and the type context is only read, so bodies can be typed in parallel.
+		if (pool_)
+		{
+			walk_functions(node, module_, *pool_, [this](utils::arena&, dependency_list&)
+			{
+				return visitor{ context_ };
+			});
+			return;
+		}
+
+		visitor vst{ context_ };
+		vst.walk(node);
 	}
 }
@@ -2,11 +2,31 @@
 
 #include "pass.hpp"
 #include "../../ir/ast/node.hpp"
+#include "../../types/module.hpp"
+#include "../../types/type_context.hpp"
+#include "../../utils/thread_pool.hpp"
 
 namespace seam::parser::passes
 {
+	/**
+	 * Returns the type a binary operation evaluates to.
+	 *
+	 * @param context type context of the module.
+	 * @param a type of left operand, or null if untyped.
+	 * @param b type of right operand, or null if untyped.
+	 * @returns the dominant type, or the type of the other operand if one is untyped.
+	 * @throws std::runtime_error if neither type converts to the other.
+	 */
+	ir::ast::type* get_dominant_type(seam::types::type_context& context, ir::ast::type* a, ir::ast::type* b);
+
 	struct types : pass
 	{
+		seam::types::module& module_;
+		seam::types::type_context& context_;
+		utils::thread_pool* pool_; // pool to type function bodies on in parallel, or null to type serially.
+
 		void run(ir::ast::node* node) override;
+
+		explicit types(seam::types::module& module_, utils::thread_pool* pool_ = nullptr);
 	};
 }
@@ -4,16 +4,47 @@
 #include <vector>
 #include <memory>
 
+#include "type_context.hpp"
 #include "../ir/ast/statement.hpp"
+#include "../utils/arena.hpp"
+#include "../utils/interner.hpp"
+#include "../utils/mapped_file.hpp"
+#include "../utils/position.hpp"
 
 namespace seam::types
 {
 	struct module
 	{
+		/**
+		 * Module named by an import statement.
+		 */
+		struct import
+		{
+			std::string name;
+			utils::position position; // position of the import statement
+		};
+
 		std::string name;
 		std::vector<std::shared_ptr<module>> dependencies;
 
-		std::unique_ptr<ir::ast::statement::restricted_block> body;
+		// Modules imported by the source, in source order, filled in by the parser.
+		std::vector<import> imports;
+
+		// Identifiers of the module, interned while lexing and shared by every later stage.
+		utils::interner symbols;
+
+		// Every type used by the module, interned so types compare by address.
+		type_context types;
+
+		// Source the module was parsed from, declared before body so it outlives the tree.
+		std::unique_ptr<utils::mapped_file> source;
+
+		// Owns every node of body, which is released in one go with the module.
+		utils::arena arena;
+
+		// Nodes made by passes running on several threads, one arena per task as arenas are not thread safe.
+		std::vector<std::unique_ptr<utils::arena>> task_arenas;
+		ir::ast::statement::restricted_block* body = nullptr;
 
 		module(std::string name) :
 			name(std::move(name))
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+
+#include "../ir/ast/type.hpp"
+
+namespace seam::types
+{
+	/**
+	 * Groups built in types which implicitly convert to each other.
+	 */
+	enum class type_family
+	{
+		none,
+		signed_integer,
+		unsigned_integer,
+		floating_point,
+	};
+
+	/**
+	 * Returns the family of a built in type.
+	 *
+	 * @param type kind of built in type.
+	 * @returns family of type, none if it converts to no other type.
+	 */
+	constexpr type_family family_of(const ir::ast::type::built_in_type type)
+	{
+		using built_in_type = ir::ast::type::built_in_type;
+
+		if (type >= built_in_type::i8 && type <= built_in_type::i64)
+		{
+			return type_family::signed_integer;
+		}
+
+		if (type >= built_in_type::u8 && type <= built_in_type::u64)
+		{
+			return type_family::unsigned_integer;
+		}
+
+		if (type >= built_in_type::f32 && type <= built_in_type::f64)
+		{
+			return type_family::floating_point;
+		}
+
+		return type_family::none;
+	}
+
+	/**
+	 * Owns the single instance of every type used by a module.
+	 *
+	 * Types are interned, so two types are equal exactly when they are the
+	 * same object and later stages compare them by pointer. Built in types are
+	 * created up front and are looked up by their kind.
+	 */
+	class type_context
+	{
+		using built_in_type = ir::ast::type::built_in_type;
+
+		constexpr static std::size_t built_in_count = static_cast<std::size_t>(built_in_type::f64) + 1;
+		constexpr static std::uint8_t no_dominant = 0xff;
+
+		// Type an operation on two built in types evaluates to, indexed by the kinds of both operands.
+		constexpr static auto dominant_table_ = []
+		{
+			std::array<std::array<std::uint8_t, built_in_count>, built_in_count> table{};
+			for (std::size_t a = 0; a < built_in_count; ++a)
+			{
+				for (std::size_t b = 0; b < built_in_count; ++b)
+				{
+					const auto family_a = family_of(static_cast<built_in_type>(a));
+					const auto family_b = family_of(static_cast<built_in_type>(b));
+
+					// The wider of the two when they belong to the same family.
+					table[a][b] = family_a != type_family::none && family_a == family_b
+						? static_cast<std::uint8_t>(a > b ? a : b)
+						: no_dominant;
+				}
+			}
+			return table;
+		}();
+
+		std::array<ir::ast::type, built_in_count> built_ins_;
+
+		template <std::size_t... Kinds>
+		explicit type_context(std::index_sequence<Kinds...>) :
+			built_ins_{ ir::ast::type{ static_cast<built_in_type>(Kinds) }... }
+		{}
+
+	public:
+		type_context() :
+			type_context(std::make_index_sequence<built_in_count>{})
+		{}
+
+		type_context(const type_context&) = delete;
+		type_context& operator=(const type_context&) = delete;
+
+		/**
+		 * Returns the instance of a built in type.
+		 *
+		 * @param type kind of built in type.
+		 * @returns the type, valid for the lifetime of the context.
+		 */
+		[[nodiscard]] ir::ast::type* built_in(const built_in_type type)
+		{
+			return &built_ins_[static_cast<std::size_t>(type)];
+		}
+
+		/**
+		 * Returns the type a binary operation on two types evaluates to.
+		 *
+		 * @param a type of left operand.
+		 * @param b type of right operand.
+		 * @returns the dominant type, or null if neither type converts to the other.
+		 * @throws std::runtime_error if either type is a class type.
+		 */
+		[[nodiscard]] ir::ast::type* dominant(const ir::ast::type* a, const ir::ast::type* b)
+		{
+			const auto built_in_a = std::get_if<built_in_type>(&a->value);
+			const auto built_in_b = std::get_if<built_in_type>(&b->value);
+			if (!built_in_a || !built_in_b)
+			{
+				throw std::runtime_error("class types are not supported");
+			}
+
+			const auto dominant = dominant_table_[static_cast<std::size_t>(*built_in_a)][static_cast<std::size_t>(*built_in_b)];
+			return dominant == no_dominant ? nullptr : &built_ins_[dominant];
+		}
+	};
+}
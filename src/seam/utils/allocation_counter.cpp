@@ -0,0 +1,84 @@
+#include "statistics.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new and delete to count every allocation, so statistics can report how many each
+// phase makes. Only linked into benchmarks, and into the compiler when built with SEAM_ALLOCATION_STATISTICS.
+
+namespace
+{
+	void* allocate(const std::size_t size)
+	{
+		seam::utils::count_allocation();
+		if (const auto memory = std::malloc(size == 0 ? 1 : size))
+		{
+			return memory;
+		}
+		throw std::bad_alloc{};
+	}
+}
+
+void* operator new(const std::size_t size)
+{
+	return allocate(size);
+}
+
+void* operator new[](const std::size_t size)
+{
+	return allocate(size);
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return allocate(size);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return nullptr;
+	}
+}
+
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return allocate(size);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return nullptr;
+	}
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+namespace seam::utils
+{
+	/**
+	 * Bump allocator owning every node of a syntax tree.
+	 *
+	 * Objects are carved out of large blocks and are never destroyed one by
+	 * one, all blocks are released at once when the arena is destroyed. Objects
+	 * placed in an arena must therefore not own anything outside of it: their
+	 * containers allocate from resource() and they refer to other objects by
+	 * plain pointers.
+	 *
+	 * @note not thread safe.
+	 */
+	class arena
+	{
+		std::pmr::monotonic_buffer_resource resource_;
+
+	public:
+		/**
+		 * Initialise arena.
+		 *
+		 * @param initial_size size of the first block, later blocks grow geometrically.
+		 */
+		explicit arena(const std::size_t initial_size = 64 * 1024) :
+			resource_(initial_size)
+		{}
+
+		arena(const arena&) = delete;
+		arena& operator=(const arena&) = delete;
+
+		/**
+		 * Returns the memory resource for containers owned by objects in the arena.
+		 *
+		 * @returns memory resource allocating from the arena.
+		 */
+		[[nodiscard]] std::pmr::memory_resource* resource() { return &resource_; }
+
+		/**
+		 * Constructs an object in the arena.
+		 *
+		 * @param args arguments to construct the object with.
+		 * @returns the object, valid until the arena is destroyed, its destructor never runs.
+		 */
+		template <typename T, typename... Args>
+		T* make(Args&&... args)
+		{
+			return new (resource_.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+	};
+}
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <exception>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "position.hpp"
 
@@ -42,4 +45,67 @@ namespace seam::utils
 		explicit compiler_exception(utils::position position, const std::string& msg) :
 			exception(position, msg) {}
 	};
-}
\ No newline at end of file
+
+	/**
+	 * Several Seam exceptions, reported together in the order they are held.
+	 */
+	struct exception_list final : std::runtime_error
+	{
+		std::vector<utils::exception> errors;
+
+		explicit exception_list(std::vector<utils::exception> errors) :
+			std::runtime_error(std::to_string(errors.size()) + " errors"), errors(std::move(errors))
+		{}
+	};
+
+	/**
+	 * Rethrows the failures of several tasks, in order.
+	 *
+	 * A single Seam exception is rethrown as is and several are thrown as an
+	 * exception_list, with any lists among them flattened. Other exceptions
+	 * are internal errors, and the first of those is rethrown on its own.
+	 *
+	 * @param failures exceptions to rethrow, null for tasks which succeeded.
+	 * @throws exception_list when several failures are Seam exceptions.
+	 */
+	inline void rethrow_all(const std::vector<std::exception_ptr>& failures)
+	{
+		std::vector<exception> errors;
+		std::exception_ptr first; // first failure, rethrown unchanged when it is the only one
+		for (const auto& failure : failures)
+		{
+			if (!failure)
+			{
+				continue;
+			}
+
+			// Anything but a Seam exception propagates from here.
+			try
+			{
+				std::rethrow_exception(failure);
+			}
+			catch (const exception& ex)
+			{
+				if (errors.empty())
+				{
+					first = failure;
+				}
+				errors.push_back(ex);
+			}
+			catch (const exception_list& ex)
+			{
+				errors.insert(errors.end(), ex.errors.begin(), ex.errors.end());
+			}
+		}
+
+		if (errors.size() == 1 && first)
+		{
+			std::rethrow_exception(first);
+		}
+
+		if (!errors.empty())
+		{
+			throw exception_list{ std::move(errors) };
+		}
+	}
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace seam::utils
+{
+	/**
+	 * Id of an interned string, equal ids always name equal strings.
+	 */
+	using symbol_id = std::uint32_t;
+
+	/**
+	 * Id of lexemes and nodes which do not name anything.
+	 */
+	constexpr symbol_id no_symbol = std::numeric_limits<symbol_id>::max();
+
+	/**
+	 * Thread safe table handing out a stable id for every distinct string.
+	 *
+	 * Strings are copied into blocks owned by the table, so the views returned
+	 * by name stay valid for its lifetime. The table is split into shards by
+	 * hash, so threads interning different strings rarely wait on each other,
+	 * and a string already in the table only takes a shared lock.
+	 */
+	class interner
+	{
+		constexpr static std::size_t shard_bits = 4;
+		constexpr static std::size_t shard_count = 1 << shard_bits;
+		constexpr static std::size_t block_size = 64 * 1024;
+
+		struct key
+		{
+			std::string_view value;
+			std::size_t hash;
+
+			bool operator==(const key& other) const { return value == other.value; }
+		};
+
+		struct key_hash
+		{
+			std::size_t operator()(const key& value) const { return value.hash; }
+		};
+
+		struct shard
+		{
+			mutable std::shared_mutex mutex;
+			std::unordered_map<key, symbol_id, key_hash> ids;
+			std::vector<std::string_view> names; // names by index, the upper bits of an id
+
+			std::vector<std::unique_ptr<char[]>> blocks;
+			std::size_t block_remaining = 0;
+
+			/**
+			 * Copies a string into storage owned by the shard.
+			 *
+			 * @param value string to copy.
+			 * @returns view of the copy.
+			 */
+			std::string_view store(const std::string_view value)
+			{
+				if (value.empty())
+				{
+					return {};
+				}
+
+				if (value.length() > block_remaining)
+				{
+					// Oversized strings get a block of their own, leaving the current block in use.
+					if (value.length() > block_size / 4)
+					{
+						auto& block = blocks.emplace_back(std::make_unique<char[]>(value.length()));
+						std::memcpy(block.get(), value.data(), value.length());
+						return { block.get(), value.length() };
+					}
+
+					blocks.emplace_back(std::make_unique<char[]>(block_size));
+					block_remaining = block_size;
+				}
+
+				const auto destination = blocks.back().get() + (block_size - block_remaining);
+				std::memcpy(destination, value.data(), value.length());
+				block_remaining -= value.length();
+				return { destination, value.length() };
+			}
+		};
+
+		std::array<shard, shard_count> shards_;
+
+		/**
+		 * Picks the shard of a hash, using its upper bits as the lower bits pick the bucket.
+		 *
+		 * @param hash hash of string.
+		 * @returns shard index.
+		 */
+		constexpr static std::size_t shard_index(const std::size_t hash)
+		{
+			return hash >> (std::numeric_limits<std::size_t>::digits - shard_bits);
+		}
+
+	public:
+		interner() = default;
+
+		interner(const interner&) = delete;
+		interner& operator=(const interner&) = delete;
+
+		/**
+		 * Returns the id of a string along with the interned copy, adding it to the table if it is new.
+		 *
+		 * @param value string to intern, copied when new so it need not outlive the table.
+		 * @returns id of string and a view of the interned copy, valid for the lifetime of the table.
+		 * @throws std::length_error if the table is full.
+		 */
+		std::pair<symbol_id, std::string_view> insert(const std::string_view value)
+		{
+			const key lookup{ value, std::hash<std::string_view>{}(value) };
+			const auto index = shard_index(lookup.hash);
+			auto& current_shard = shards_[index];
+
+			{
+				std::shared_lock lock{ current_shard.mutex };
+				if (const auto it = current_shard.ids.find(lookup); it != current_shard.ids.cend())
+				{
+					return { it->second, it->first.value };
+				}
+			}
+
+			std::unique_lock lock{ current_shard.mutex };
+
+			// Another thread may have added it between the two locks.
+			if (const auto it = current_shard.ids.find(lookup); it != current_shard.ids.cend())
+			{
+				return { it->second, it->first.value };
+			}
+
+			if (current_shard.names.size() >= (no_symbol >> shard_bits))
+			{
+				throw std::length_error{ "too many distinct symbols" };
+			}
+
+			const auto id = static_cast<symbol_id>(current_shard.names.size() << shard_bits | index);
+			const auto stored = current_shard.store(value);
+			current_shard.names.push_back(stored);
+			current_shard.ids.emplace(key{ stored, lookup.hash }, id);
+			return { id, stored };
+		}
+
+		/**
+		 * Returns the id of a string, adding it to the table if it is new.
+		 *
+		 * @param value string to intern, copied when new so it need not outlive the table.
+		 * @returns id of string.
+		 * @throws std::length_error if the table is full.
+		 */
+		symbol_id intern(const std::string_view value)
+		{
+			return insert(value).first;
+		}
+
+		/**
+		 * Returns the string an id was handed out for.
+		 *
+		 * @param id id returned by intern.
+		 * @returns interned string, valid for the lifetime of the table.
+		 */
+		[[nodiscard]] std::string_view name(const symbol_id id) const
+		{
+			const auto& current_shard = shards_[id & (shard_count - 1)];
+			std::shared_lock lock{ current_shard.mutex };
+			return current_shard.names[id >> shard_bits];
+		}
+
+		/**
+		 * Returns the number of distinct strings in the table.
+		 *
+		 * @returns number of interned strings.
+		 */
+		[[nodiscard]] std::size_t size() const
+		{
+			std::size_t count = 0;
+			for (const auto& current_shard : shards_)
+			{
+				std::shared_lock lock{ current_shard.mutex };
+				count += current_shard.names.size();
+			}
+			return count;
+		}
+	};
+
+	/**
+	 * Small direct mapped cache in front of an interner, owned by a single thread.
+	 *
+	 * Identifiers repeat heavily within a source, so most lookups hit here and
+	 * skip both hashing the whole string and locking the shared table.
+	 */
+	class symbol_cache
+	{
+		constexpr static std::size_t size_bits = 10;
+
+		struct entry
+		{
+			std::string_view value; // view of the interned copy
+			symbol_id id = no_symbol;
+		};
+
+		interner* symbols_;
+		std::array<entry, 1 << size_bits> entries_{};
+
+		/**
+		 * Cheaply hashes a string from its length and its first and last 8 bytes.
+		 *
+		 * @param value string to hash.
+		 * @returns entry index.
+		 */
+		static std::size_t slot(const std::string_view value)
+		{
+			const auto count = value.length() < 8 ? value.length() : 8;
+
+			std::uint64_t head = 0;
+			std::uint64_t tail = 0;
+			std::memcpy(&head, value.data(), count);
+			std::memcpy(&tail, value.data() + value.length() - count, count);
+
+			constexpr std::uint64_t multiplier = 0x9e3779b97f4a7c15;
+			const auto hash = ((head * multiplier ^ tail) * multiplier) ^ value.length();
+			return static_cast<std::size_t>((hash * multiplier) >> (64 - size_bits));
+		}
+
+	public:
+		explicit symbol_cache(interner& symbols) :
+			symbols_(&symbols)
+		{}
+
+		/**
+		 * Returns the id of a string, adding it to the interner if it is new.
+		 *
+		 * @param value string to intern.
+		 * @returns id of string.
+		 */
+		symbol_id intern(const std::string_view value)
+		{
+			auto& cached = entries_[slot(value)];
+			if (cached.id != no_symbol && cached.value == value)
+			{
+				return cached.id;
+			}
+
+			std::tie(cached.id, cached.value) = symbols_->insert(value);
+			return cached.id;
+		}
+	};
+}
@@ -0,0 +1,250 @@
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <system_error>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace seam::utils
+{
+	constexpr std::size_t initial_read_size = 64 * 1024;
+
+#ifdef _WIN32
+	[[noreturn]] void throw_last_error(const std::string& message)
+	{
+		throw std::system_error{ static_cast<int>(GetLastError()), std::system_category(), message };
+	}
+
+	void read_all(const HANDLE handle, std::vector<char>& buffer, const std::string& path)
+	{
+		std::size_t size = 0;
+		buffer.resize(initial_read_size);
+
+		while (true)
+		{
+			if (size == buffer.size())
+			{
+				buffer.resize(buffer.size() * 2);
+			}
+
+			DWORD count = 0;
+			const auto chunk = static_cast<DWORD>(std::min<std::size_t>(buffer.size() - size, MAXDWORD));
+			if (!ReadFile(handle, buffer.data() + size, chunk, &count, nullptr))
+			{
+				if (GetLastError() == ERROR_BROKEN_PIPE) // Writer closed the pipe, treat as end of file.
+				{
+					break;
+				}
+				throw_last_error("cannot read '" + path + "'");
+			}
+
+			if (count == 0)
+			{
+				break;
+			}
+			size += count;
+		}
+
+		buffer.resize(size);
+	}
+
+	std::unique_ptr<mapped_file> mapped_file::open(const std::string& path)
+	{
+		std::unique_ptr<mapped_file> file{ new mapped_file() };
+
+		if (path == "-")
+		{
+			read_all(GetStdHandle(STD_INPUT_HANDLE), file->buffer_, path);
+			file->data_ = file->buffer_.data();
+			file->size_ = file->buffer_.size();
+			return file;
+		}
+
+		const auto file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file_handle == INVALID_HANDLE_VALUE)
+		{
+			throw_last_error("cannot open '" + path + "'");
+		}
+		file->file_handle_ = file_handle;
+
+		LARGE_INTEGER size;
+		if (GetFileType(file_handle) != FILE_TYPE_DISK || !GetFileSizeEx(file_handle, &size))
+		{
+			read_all(file_handle, file->buffer_, path);
+			file->data_ = file->buffer_.data();
+			file->size_ = file->buffer_.size();
+			return file;
+		}
+
+		if (size.QuadPart == 0) // Empty files cannot be mapped.
+		{
+			return file;
+		}
+
+		const auto mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping_handle)
+		{
+			throw_last_error("cannot map '" + path + "'");
+		}
+		file->mapping_handle_ = mapping_handle;
+
+		const auto view = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+		if (!view)
+		{
+			throw_last_error("cannot map '" + path + "'");
+		}
+
+		file->data_ = static_cast<const char*>(view);
+		file->size_ = static_cast<std::size_t>(size.QuadPart);
+		file->is_mapped_ = true;
+		return file;
+	}
+
+	mapped_file::~mapped_file()
+	{
+		if (is_mapped_)
+		{
+			UnmapViewOfFile(data_);
+		}
+
+		if (mapping_handle_)
+		{
+			CloseHandle(mapping_handle_);
+		}
+
+		if (file_handle_)
+		{
+			CloseHandle(file_handle_);
+		}
+	}
+#else
+	[[noreturn]] void throw_errno(const std::string& message)
+	{
+		throw std::system_error{ errno, std::generic_category(), message };
+	}
+
+	void read_all(const int fd, std::vector<char>& buffer, const std::string& path)
+	{
+		std::size_t size = 0;
+		buffer.resize(initial_read_size);
+
+		while (true)
+		{
+			if (size == buffer.size())
+			{
+				buffer.resize(buffer.size() * 2);
+			}
+
+			const auto count = ::read(fd, buffer.data() + size, buffer.size() - size);
+			if (count < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				throw_errno("cannot read '" + path + "'");
+			}
+
+			if (count == 0)
+			{
+				break;
+			}
+			size += static_cast<std::size_t>(count);
+		}
+
+		buffer.resize(size);
+	}
+
+	/**
+	 * Closes a file descriptor when going out of scope, mappings stay valid after closing.
+	 */
+	struct file_descriptor
+	{
+		int fd;
+
+		~file_descriptor()
+		{
+			if (fd >= 0)
+			{
+				::close(fd);
+			}
+		}
+	};
+
+	std::unique_ptr<mapped_file> mapped_file::open(const std::string& path)
+	{
+		std::unique_ptr<mapped_file> file{ new mapped_file() };
+
+		if (path == "-")
+		{
+			read_all(STDIN_FILENO, file->buffer_, path);
+			file->data_ = file->buffer_.data();
+			file->size_ = file->buffer_.size();
+			return file;
+		}
+
+		const file_descriptor descriptor{ ::open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+		if (descriptor.fd < 0)
+		{
+			throw_errno("cannot open '" + path + "'");
+		}
+
+		struct stat status {};
+		if (::fstat(descriptor.fd, &status) != 0)
+		{
+			throw_errno("cannot open '" + path + "'");
+		}
+
+		if (!S_ISREG(status.st_mode)) // Pipes, terminals and devices cannot be mapped.
+		{
+			read_all(descriptor.fd, file->buffer_, path);
+			file->data_ = file->buffer_.data();
+			file->size_ = file->buffer_.size();
+			return file;
+		}
+
+		if (status.st_size == 0) // Empty files cannot be mapped.
+		{
+			return file;
+		}
+
+		const auto size = static_cast<std::size_t>(status.st_size);
+
+		auto flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+		flags |= MAP_POPULATE; // Prefault the whole file, the lexer reads all of it.
+#endif
+		const auto mapping = ::mmap(nullptr, size, PROT_READ, flags, descriptor.fd, 0);
+		if (mapping == MAP_FAILED)
+		{
+			throw_errno("cannot map '" + path + "'");
+		}
+
+		::madvise(mapping, size, MADV_SEQUENTIAL);
+
+		file->data_ = static_cast<const char*>(mapping);
+		file->size_ = size;
+		file->is_mapped_ = true;
+		return file;
+	}
+
+	mapped_file::~mapped_file()
+	{
+		if (is_mapped_)
+		{
+			::munmap(const_cast<char*>(data_), size_);
+		}
+	}
+#endif
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace seam::utils
+{
+	/**
+	 * Read-only contents of a source file.
+	 *
+	 * Regular files are memory mapped and handed out as a view of the mapping,
+	 * so their contents are never copied. Anything which cannot be mapped, such
+	 * as a pipe or standard input, is read into an owned buffer instead.
+	 */
+	class mapped_file
+	{
+		const char* data_ = nullptr;
+		std::size_t size_ = 0;
+
+		bool is_mapped_ = false;
+		std::vector<char> buffer_; // contents when not mapped
+
+#ifdef _WIN32
+		void* file_handle_ = nullptr;
+		void* mapping_handle_ = nullptr;
+#endif
+
+		mapped_file() = default;
+
+	public:
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		~mapped_file();
+
+		/**
+		 * Opens a source file.
+		 *
+		 * @param path path of file to open, or "-" for standard input.
+		 * @returns the opened file.
+		 * @throws std::system_error if the file cannot be opened or read.
+		 */
+		static std::unique_ptr<mapped_file> open(const std::string& path);
+
+		/**
+		 * Returns the contents of the file.
+		 *
+		 * @returns view of the contents, valid for the lifetime of this object.
+		 */
+		[[nodiscard]] std::string_view contents() const { return { data_, size_ }; }
+
+		/**
+		 * Returns whether the contents are memory mapped rather than read into a buffer.
+		 *
+		 * @returns whether the file is memory mapped.
+		 */
+		[[nodiscard]] bool is_mapped() const { return is_mapped_; }
+	};
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace seam::utils
+{
+	/**
+	 * Immutable string keyed map backed by a perfect hash, built at compile time.
+	 *
+	 * The hash only mixes the length, the first two bytes and the last byte
+	 * of a key, and the multiplier is searched for at compile time so that no
+	 * two keys share a slot. A lookup is therefore a single hash, one table load
+	 * and one string comparison, and never allocates.
+	 *
+	 * @tparam T mapped value type.
+	 * @tparam N number of entries.
+	 * @tparam TableSize number of slots, must be a power of two larger than N.
+	 */
+	template <typename T, std::size_t N, std::size_t TableSize>
+	class perfect_hash_map
+	{
+		static_assert((TableSize & (TableSize - 1)) == 0, "table size must be a power of two");
+		static_assert(TableSize > N, "table size must be larger than the number of entries");
+
+		struct slot
+		{
+			std::string_view key{};
+			T value{};
+		};
+
+		std::array<slot, TableSize> slots_{};
+		std::uint32_t seed_ = 0;
+
+		[[nodiscard]] static constexpr std::size_t hash(const std::string_view key, const std::uint32_t seed)
+		{
+			const auto size = key.size();
+
+			auto h = static_cast<std::uint32_t>(size) * 0x9e3779b1u;
+			h = (h ^ static_cast<std::uint8_t>(key[0])) * seed;
+			h = (h ^ static_cast<std::uint8_t>(key[size > 1 ? 1 : 0])) * seed;
+			h = (h ^ static_cast<std::uint8_t>(key[size - 1])) * seed;
+			return (h ^ (h >> 16)) & (TableSize - 1);
+		}
+
+	public:
+		/**
+		 * Builds the table, searching for a collision free seed.
+		 *
+		 * @param entries keys and their values, keys must be unique and non-empty.
+		 * @throws std::logic_error if no seed is found, which fails compilation
+		 *         when evaluated in a constant expression.
+		 */
+		constexpr explicit perfect_hash_map(const std::pair<std::string_view, T> (&entries)[N])
+		{
+			for (std::uint32_t seed = 1; seed < 0x10000; seed += 2)
+			{
+				std::array<bool, TableSize> occupied{};
+				auto collision = false;
+
+				for (std::size_t i = 0; i < N && !collision; ++i)
+				{
+					const auto index = hash(entries[i].first, seed);
+					collision = occupied[index];
+					occupied[index] = true;
+				}
+
+				if (!collision)
+				{
+					seed_ = seed;
+					for (std::size_t i = 0; i < N; ++i)
+					{
+						auto& entry = slots_[hash(entries[i].first, seed)];
+						entry.key = entries[i].first;
+						entry.value = entries[i].second;
+					}
+					return;
+				}
+			}
+
+			throw std::logic_error("no perfect hash seed found");
+		}
+
+		/**
+		 * Looks up a key.
+		 *
+		 * @param key key to look up, must not be empty.
+		 * @returns pointer to the mapped value, or nullptr if the key is absent.
+		 */
+		[[nodiscard]] constexpr const T* find(const std::string_view key) const
+		{
+			const auto& entry = slots_[hash(key, seed_)];
+			return entry.key == key ? &entry.value : nullptr;
+		}
+	};
+
+	/**
+	 * Builds a perfect hash map, deducing the number of entries.
+	 *
+	 * @tparam T mapped value type.
+	 * @tparam TableSize number of slots, must be a power of two larger than the number of entries.
+	 * @param entries keys and their values.
+	 * @returns the built map.
+	 */
+	template <typename T, std::size_t TableSize, std::size_t N>
+	constexpr perfect_hash_map<T, N, TableSize> make_perfect_hash_map(const std::pair<std::string_view, T> (&entries)[N])
+	{
+		return perfect_hash_map<T, N, TableSize>{ entries };
+	}
+}
@@ -1,16 +1,20 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 
 namespace seam::utils
 {
 	/**
-	 * Container for line and column position.
+	 * Position within a source file.
+	 *
+	 * Only the byte offset is tracked while compiling, the line and column
+	 * are resolved from a line_table when a diagnostic needs them.
 	 */
 	struct position
 	{
-		std::size_t line; // line position
-		std::size_t column; // column position
+		std::uint32_t offset; // byte offset into the source
+		std::uint32_t file_id; // id of the source file, see source_map
 	};
 
 	/**
@@ -21,4 +25,13 @@ namespace seam::utils
 		position start; // start position
 		position end; // end position
 	};
-}
\ No newline at end of file
+
+	/**
+	 * Container for a resolved line and column position, both starting at 1.
+	 */
+	struct line_column
+	{
+		std::size_t line; // line position
+		std::size_t column; // column position
+	};
+}
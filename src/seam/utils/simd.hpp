@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SEAM_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SEAM_SIMD_SSE2 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace seam::utils::simd
+{
+	/**
+	 * Returns the index of the lowest set bit.
+	 *
+	 * @param mask non-zero mask.
+	 * @returns index of lowest set bit.
+	 */
+	inline std::size_t count_trailing_zeros(const std::uint32_t mask)
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return static_cast<std::size_t>(__builtin_ctz(mask));
+#endif
+	}
+
+	inline bool is_whitespace(const char c)
+	{
+		return c == ' ' || (c >= '\t' && c <= '\r');
+	}
+
+	inline bool is_identifier(const char c)
+	{
+		const auto lower = static_cast<char>(c | 0x20);
+		return (lower >= 'a' && lower <= 'z') || (c >= '0' && c <= '9') || c == '_';
+	}
+
+#if defined(SEAM_SIMD_AVX2)
+	constexpr std::size_t block_size = 32;
+	using block = __m256i;
+
+	inline block load(const char* data) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)); }
+	inline block splat(const char c) { return _mm256_set1_epi8(c); }
+	inline block equal(const block a, const block b) { return _mm256_cmpeq_epi8(a, b); }
+	inline block either(const block a, const block b) { return _mm256_or_si256(a, b); }
+	inline block both(const block a, const block b) { return _mm256_and_si256(a, b); }
+	inline std::uint32_t to_mask(const block a) { return static_cast<std::uint32_t>(_mm256_movemask_epi8(a)); }
+
+	// unsigned lo <= a <= hi per byte
+	inline block in_range(const block a, const char lo, const char hi)
+	{
+		return both(equal(_mm256_max_epu8(a, splat(lo)), a), equal(_mm256_min_epu8(a, splat(hi)), a));
+	}
+#elif defined(SEAM_SIMD_SSE2)
+	constexpr std::size_t block_size = 16;
+	using block = __m128i;
+
+	inline block load(const char* data) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)); }
+	inline block splat(const char c) { return _mm_set1_epi8(c); }
+	inline block equal(const block a, const block b) { return _mm_cmpeq_epi8(a, b); }
+	inline block either(const block a, const block b) { return _mm_or_si128(a, b); }
+	inline block both(const block a, const block b) { return _mm_and_si128(a, b); }
+	inline std::uint32_t to_mask(const block a) { return static_cast<std::uint32_t>(_mm_movemask_epi8(a)); }
+
+	// unsigned lo <= a <= hi per byte
+	inline block in_range(const block a, const char lo, const char hi)
+	{
+		return both(equal(_mm_max_epu8(a, splat(lo)), a), equal(_mm_min_epu8(a, splat(hi)), a));
+	}
+#endif
+
+	/**
+	 * Finds the first character at or after offset which does not satisfy a predicate.
+	 *
+	 * @param source source to scan.
+	 * @param offset offset to start scanning from.
+	 * @param classify_block returns a mask of the characters in a block which satisfy the predicate.
+	 * @param classify scalar version of the predicate.
+	 * @returns offset of the first character which does not satisfy the predicate, or source size.
+	 */
+	template <typename BlockFn, typename ScalarFn>
+	std::size_t find_first_not(const std::string_view source, std::size_t offset, [[maybe_unused]] BlockFn&& classify_block, ScalarFn&& classify)
+	{
+		const auto data = source.data();
+		const auto size = source.size();
+
+#if defined(SEAM_SIMD_AVX2) || defined(SEAM_SIMD_SSE2)
+		constexpr auto full_mask = static_cast<std::uint32_t>((std::uint64_t{ 1 } << block_size) - 1);
+		for (; offset + block_size <= size; offset += block_size)
+		{
+			if (const auto mask = ~classify_block(load(data + offset)) & full_mask)
+			{
+				return offset + count_trailing_zeros(mask);
+			}
+		}
+#endif
+		while (offset < size && classify(data[offset]))
+		{
+			++offset;
+		}
+		return offset;
+	}
+
+	/**
+	 * Finds the end of a whitespace run.
+	 *
+	 * @param source source to scan.
+	 * @param offset offset to start scanning from.
+	 * @returns offset of first non-whitespace character, or source size.
+	 */
+	inline std::size_t skip_whitespace(const std::string_view source, const std::size_t offset)
+	{
+		return find_first_not(source, offset,
+#if defined(SEAM_SIMD_AVX2) || defined(SEAM_SIMD_SSE2)
+			[](const block b) { return to_mask(either(equal(b, splat(' ')), in_range(b, '\t', '\r'))); },
+#else
+			nullptr,
+#endif
+			is_whitespace);
+	}
+
+	/**
+	 * Finds the end of an identifier run.
+	 *
+	 * @param source source to scan.
+	 * @param offset offset to start scanning from.
+	 * @returns offset of first character which cannot be part of an identifier, or source size.
+	 */
+	inline std::size_t skip_identifier(const std::string_view source, const std::size_t offset)
+	{
+		return find_first_not(source, offset,
+#if defined(SEAM_SIMD_AVX2) || defined(SEAM_SIMD_SSE2)
+			[](const block b)
+			{
+				const auto letter = in_range(either(b, splat(0x20)), 'a', 'z');
+				const auto digit = in_range(b, '0', '9');
+				return to_mask(either(either(letter, digit), equal(b, splat('_'))));
+			},
+#else
+			nullptr,
+#endif
+			is_identifier);
+	}
+
+	/**
+	 * Finds the first occurrence of either of two characters.
+	 *
+	 * @param source source to scan.
+	 * @param offset offset to start scanning from.
+	 * @param a first character to find.
+	 * @param b second character to find.
+	 * @returns offset of the first match, or source size.
+	 */
+	inline std::size_t find_either(const std::string_view source, const std::size_t offset, const char a, const char b)
+	{
+		return find_first_not(source, offset,
+#if defined(SEAM_SIMD_AVX2) || defined(SEAM_SIMD_SSE2)
+			[a, b](const block value) { return ~to_mask(either(equal(value, splat(a)), equal(value, splat(b)))); },
+#else
+			nullptr,
+#endif
+			[a, b](const char c) { return c != a && c != b; });
+	}
+
+	/**
+	 * Finds the first occurrence of a character.
+	 *
+	 * @param source source to scan.
+	 * @param offset offset to start scanning from.
+	 * @param c character to find.
+	 * @returns offset of the first match, or source size.
+	 */
+	inline std::size_t find(const std::string_view source, const std::size_t offset, const char c)
+	{
+		return find_either(source, offset, c, c);
+	}
+
+	/**
+	 * Calls a function with the offset of every occurrence of a character, in order.
+	 *
+	 * @param source source to scan.
+	 * @param c character to find.
+	 * @param fn function to call with each offset.
+	 */
+	template <typename Fn>
+	void for_each_match(const std::string_view source, const char c, Fn&& fn)
+	{
+		const auto data = source.data();
+		const auto size = source.size();
+		std::size_t offset = 0;
+
+#if defined(SEAM_SIMD_AVX2) || defined(SEAM_SIMD_SSE2)
+		const auto needle = splat(c);
+		for (; offset + block_size <= size; offset += block_size)
+		{
+			auto mask = to_mask(equal(load(data + offset), needle));
+			while (mask)
+			{
+				fn(offset + count_trailing_zeros(mask));
+				mask &= mask - 1;
+			}
+		}
+#endif
+		for (; offset < size; ++offset)
+		{
+			if (data[offset] == c)
+			{
+				fn(offset);
+			}
+		}
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "position.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace seam::utils
+{
+	/**
+	 * Offsets of the start of every line in a source, for resolving byte offsets to lines and columns.
+	 */
+	class line_table
+	{
+		std::vector<std::uint32_t> line_starts_;
+
+	public:
+		/**
+		 * Builds the table with a single vectorized scan for newlines.
+		 *
+		 * @param source source to build the table for.
+		 */
+		explicit line_table(const std::string_view source)
+		{
+			line_starts_.push_back(0);
+			simd::for_each_match(source, '\n', [this](const std::size_t offset)
+			{
+				line_starts_.push_back(static_cast<std::uint32_t>(offset + 1));
+			});
+		}
+
+		/**
+		 * Returns the number of lines in the source.
+		 *
+		 * @returns number of lines, at least one.
+		 */
+		[[nodiscard]] std::size_t line_count() const
+		{
+			return line_starts_.size();
+		}
+
+		/**
+		 * Resolves a byte offset to a line and column.
+		 *
+		 * @param offset byte offset into the source.
+		 * @returns line and column of offset.
+		 */
+		[[nodiscard]] line_column resolve(const std::uint32_t offset) const
+		{
+			const auto next_line = std::upper_bound(line_starts_.cbegin(), line_starts_.cend(), offset);
+			const auto line = static_cast<std::size_t>(next_line - line_starts_.cbegin());
+			return { line, offset - line_starts_[line - 1] + 1 };
+		}
+	};
+
+	/**
+	 * Registry of every source file being compiled, indexed by file id.
+	 *
+	 * Line tables are built the first time a position in a file is resolved,
+	 * so files without diagnostics never pay for them. Not thread safe.
+	 */
+	class source_map
+	{
+		struct file
+		{
+			std::string name;
+			std::string_view source;
+			mutable std::optional<line_table> lines;
+		};
+
+		std::vector<file> files_;
+
+	public:
+		/**
+		 * Registers a source file.
+		 *
+		 * @param name name of the file, used in diagnostics.
+		 * @param source source of the file, must outlive the source map.
+		 * @returns id of the file.
+		 */
+		std::uint32_t add(std::string name, const std::string_view source)
+		{
+			files_.push_back({ std::move(name), source, std::nullopt });
+			return static_cast<std::uint32_t>(files_.size() - 1);
+		}
+
+		/**
+		 * Returns the name of a file.
+		 *
+		 * @param file_id id of the file.
+		 * @returns name of the file.
+		 */
+		[[nodiscard]] const std::string& name(const std::uint32_t file_id) const
+		{
+			return files_.at(file_id).name;
+		}
+
+		/**
+		 * Returns the source of a file.
+		 *
+		 * @param file_id id of the file.
+		 * @returns source of the file.
+		 */
+		[[nodiscard]] std::string_view source(const std::uint32_t file_id) const
+		{
+			return files_.at(file_id).source;
+		}
+
+		/**
+		 * Resolves a position to a line and column.
+		 *
+		 * @param pos position to resolve.
+		 * @returns line and column of pos.
+		 */
+		[[nodiscard]] line_column resolve(const position pos) const
+		{
+			const auto& target = files_.at(pos.file_id);
+			if (!target.lines)
+			{
+				target.lines.emplace(target.source);
+			}
+			return target.lines->resolve(pos.offset);
+		}
+	};
+}
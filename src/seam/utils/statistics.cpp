@@ -0,0 +1,156 @@
+#include "statistics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace seam::utils
+{
+	namespace
+	{
+		std::atomic<std::size_t> allocations{ 0 };
+	}
+
+	void count_allocation()
+	{
+		allocations.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void write_json_string(std::ostream& stream, const std::string_view value)
+	{
+		stream << '"';
+		for (const auto c : value)
+		{
+			switch (c)
+			{
+				case '"': stream << "\\\""; break;
+				case '\\': stream << "\\\\"; break;
+				case '\n': stream << "\\n"; break;
+				case '\t': stream << "\\t"; break;
+				default:
+				{
+					if (static_cast<unsigned char>(c) < 0x20)
+					{
+						char escaped[8];
+						std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+						stream << escaped;
+					}
+					else
+					{
+						stream << c;
+					}
+					break;
+				}
+			}
+		}
+		stream << '"';
+	}
+
+	std::size_t allocation_count()
+	{
+		return allocations.load(std::memory_order_relaxed);
+	}
+
+	std::size_t peak_resident_size()
+	{
+#ifdef _WIN32
+		return 0;
+#else
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+		return static_cast<std::size_t>(usage.ru_maxrss); // bytes on macOS
+#else
+		return static_cast<std::size_t>(usage.ru_maxrss) * 1024; // kilobytes elsewhere
+#endif
+#endif
+	}
+
+	statistics::scope::scope(statistics* owner, std::string name, std::string category) :
+		owner_(owner)
+	{
+		if (!owner_)
+		{
+			return;
+		}
+
+		record_.name = std::move(name);
+		record_.category = std::move(category);
+		start_allocations_ = allocation_count();
+		start_peak_ = peak_resident_size();
+		record_.start = std::chrono::duration<double>(std::chrono::steady_clock::now() - owner_->created_).count();
+	}
+
+	statistics::scope::~scope()
+	{
+		if (!owner_)
+		{
+			return;
+		}
+
+		record_.duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - owner_->created_).count() - record_.start;
+		record_.allocations = allocation_count() - start_allocations_;
+		record_.peak_memory_delta = peak_resident_size() - start_peak_;
+		owner_->records_.push_back(std::move(record_));
+	}
+
+	void statistics::write_text(std::ostream& stream) const
+	{
+		auto sorted = records_;
+		std::stable_sort(sorted.begin(), sorted.end(), [](const record& a, const record& b)
+		{
+			return a.start < b.start;
+		});
+
+		char line[160];
+		stream << "===-------------------------------------------------------------------------===\n";
+		stream << "                          Seam compilation statistics\n";
+		stream << "===-------------------------------------------------------------------------===\n";
+		std::snprintf(line, sizeof(line), "%12s %12s %14s %12s  %-10s %s\n",
+			"Wall time", "Allocations", "Peak growth", "Nodes", "Category", "Name");
+		stream << line;
+
+		// Nothing is counted unless allocation_counter.cpp is linked in, which makes the process allocate before this.
+		const auto counting = allocation_count() > 0;
+		for (const auto& record : sorted)
+		{
+			// Passes do not count the nodes they visit.
+			const auto nodes = record.nodes ? std::to_string(record.nodes) : "-";
+			const auto allocations = counting ? std::to_string(record.allocations) : "-";
+			std::snprintf(line, sizeof(line), "%9.3f ms %12s %10.2f MiB %12s  %-10s %s\n",
+				record.duration * 1000.0, allocations.c_str(),
+				static_cast<double>(record.peak_memory_delta) / (1024.0 * 1024.0),
+				nodes.c_str(), record.category.c_str(), record.name.c_str());
+			stream << line;
+		}
+	}
+
+	void statistics::write_chrome_trace(std::ostream& stream) const
+	{
+		stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		for (std::size_t i = 0; i < records_.size(); ++i)
+		{
+			const auto& record = records_[i];
+			stream << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+			write_json_string(stream, record.name);
+			stream << ",\"cat\":";
+			write_json_string(stream, record.category);
+
+			// Complete events, with times in microseconds.
+			stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+				<< ",\"ts\":" << static_cast<std::uint64_t>(record.start * 1e6)
+				<< ",\"dur\":" << static_cast<std::uint64_t>(record.duration * 1e6)
+				<< ",\"args\":{\"allocations\":" << record.allocations
+				<< ",\"peak_memory_delta\":" << record.peak_memory_delta
+				<< ",\"nodes\":" << record.nodes << "}}";
+		}
+		stream << "\n]}\n";
+	}
+}
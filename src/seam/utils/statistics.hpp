@@ -0,0 +1,126 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace seam::utils
+{
+	/**
+	 * Counts a heap allocation, called by the operator new of allocation_counter.cpp.
+	 */
+	void count_allocation();
+
+	/**
+	 * Returns the number of heap allocations made by the process so far.
+	 *
+	 * @returns number of allocations, 0 if allocations are not counted.
+	 */
+	std::size_t allocation_count();
+
+	/**
+	 * Returns the peak resident set size of the process so far.
+	 *
+	 * @returns peak resident set size in bytes, 0 where unsupported.
+	 */
+	std::size_t peak_resident_size();
+
+	/**
+	 * Writes a string as a JSON string literal.
+	 *
+	 * @param stream stream to write to.
+	 * @param value string to write.
+	 */
+	void write_json_string(std::ostream& stream, std::string_view value);
+
+	/**
+	 * Time, allocations, memory and nodes spent on each phase of a compilation.
+	 *
+	 * Phases are recorded by scopes, which measure from their construction to
+	 * their destruction. Scopes may nest, a phase's figures then include those
+	 * of the phases within it.
+	 *
+	 * @note not thread safe.
+	 */
+	class statistics
+	{
+	public:
+		struct record
+		{
+			std::string name;
+			std::string category; // stage the phase belongs to, such as frontend or codegen
+			double start = 0; // seconds since the statistics were created
+			double duration = 0; // seconds
+			std::size_t allocations = 0;
+			std::size_t peak_memory_delta = 0; // bytes the peak resident set size grew by
+			std::size_t nodes = 0; // lexemes, nodes or functions the phase went through
+		};
+
+		/**
+		 * Measures a phase for as long as it lives, does nothing if it has no statistics.
+		 */
+		class scope
+		{
+			statistics* owner_;
+			record record_;
+			std::size_t start_allocations_ = 0;
+			std::size_t start_peak_ = 0;
+
+		public:
+			/**
+			 * Starts measuring a phase.
+			 *
+			 * @param owner statistics to record the phase in, or null to measure nothing.
+			 * @param name name of the phase.
+			 * @param category stage the phase belongs to.
+			 */
+			scope(statistics* owner, std::string name, std::string category);
+			~scope();
+
+			scope(const scope&) = delete;
+			scope& operator=(const scope&) = delete;
+
+			/**
+			 * Sets the number of nodes the phase went through.
+			 *
+			 * @param nodes number of nodes.
+			 */
+			void set_nodes(const std::size_t nodes)
+			{
+				record_.nodes = nodes;
+			}
+		};
+
+	private:
+		std::chrono::steady_clock::time_point created_ = std::chrono::steady_clock::now();
+		std::vector<record> records_;
+
+	public:
+		/**
+		 * Returns every recorded phase, in the order they finished.
+		 *
+		 * @returns recorded phases.
+		 */
+		[[nodiscard]] const std::vector<record>& records() const
+		{
+			return records_;
+		}
+
+		/**
+		 * Writes a table of every recorded phase, in the order they started.
+		 *
+		 * @param stream stream to write to.
+		 */
+		void write_text(std::ostream& stream) const;
+
+		/**
+		 * Writes every recorded phase in the Chrome trace event format, for chrome://tracing or Perfetto.
+		 *
+		 * @param stream stream to write to.
+		 */
+		void write_chrome_trace(std::ostream& stream) const;
+	};
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "interner.hpp"
+
+namespace seam::utils
+{
+	/**
+	 * Lexically scoped table binding interned names to values.
+	 *
+	 * Bindings of every open scope live in a single stack, and each name keeps
+	 * the index of its innermost binding in a vector indexed by symbol id, so
+	 * lookups never hash or walk enclosing scopes. A binding remembers the one
+	 * it shadows, which is restored when its scope is closed.
+	 *
+	 * @note not thread safe.
+	 */
+	template <typename T>
+	class symbol_table
+	{
+		constexpr static std::uint32_t no_binding = std::numeric_limits<std::uint32_t>::max();
+
+		struct binding
+		{
+			symbol_id name;
+			std::uint32_t shadowed; // binding of the same name in an enclosing scope
+			T* value;
+		};
+
+		std::vector<binding> bindings_;
+		std::vector<std::size_t> scopes_; // size of bindings_ when each open scope began
+		std::vector<std::uint32_t> innermost_; // innermost binding by symbol id
+
+	public:
+		/**
+		 * Opens a scope, bindings added from now on are dropped by the matching pop_scope.
+		 */
+		void push_scope()
+		{
+			scopes_.push_back(bindings_.size());
+		}
+
+		/**
+		 * Closes the innermost scope, making the bindings it shadowed visible again.
+		 */
+		void pop_scope()
+		{
+			const auto first = scopes_.back();
+			scopes_.pop_back();
+
+			while (bindings_.size() > first)
+			{
+				const auto& last = bindings_.back();
+				innermost_[last.name] = last.shadowed;
+				bindings_.pop_back();
+			}
+		}
+
+		/**
+		 * Binds a name in the innermost scope, shadowing any binding of it in enclosing scopes.
+		 *
+		 * @param name interned name.
+		 * @param value value to bind, must outlive the binding.
+		 */
+		void add(const symbol_id name, T* value)
+		{
+			if (name >= innermost_.size())
+			{
+				innermost_.resize(static_cast<std::size_t>(name) + 1, no_binding);
+			}
+
+			bindings_.push_back({ name, innermost_[name], value });
+			innermost_[name] = static_cast<std::uint32_t>(bindings_.size() - 1);
+		}
+
+		/**
+		 * Returns the value bound to a name in the innermost scope that binds it.
+		 *
+		 * @param name interned name.
+		 * @returns bound value, or null if no open scope binds the name.
+		 */
+		[[nodiscard]] T* find(const symbol_id name) const
+		{
+			if (name >= innermost_.size() || innermost_[name] == no_binding)
+			{
+				return nullptr;
+			}
+
+			return bindings_[innermost_[name]].value;
+		}
+	};
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace seam::utils
+{
+	/**
+	 * Fixed size pool of worker threads balancing tasks by work stealing.
+	 *
+	 * Every worker has a queue of its own. Tasks submitted by a worker go to
+	 * the back of its queue and it takes its newest task first, so nested work
+	 * stays on the thread which made it. Tasks submitted from outside the pool
+	 * are dealt to the workers in turn. A worker with nothing left to do steals
+	 * the oldest task of another worker, so uneven tasks still keep every
+	 * worker busy.
+	 */
+	class thread_pool
+	{
+		struct queue
+		{
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		std::vector<std::thread> workers_;
+		std::vector<std::unique_ptr<queue>> queues_;
+
+		std::atomic<std::size_t> next_queue_{ 0 }; // queue the next task from outside the pool goes to
+		std::atomic<std::size_t> pending_{ 0 }; // tasks queued but not yet taken
+
+		std::mutex sleep_mutex_;
+		std::condition_variable condition_;
+		bool stopping_ = false;
+
+		struct current_worker
+		{
+			const thread_pool* pool;
+			std::size_t index;
+		};
+
+		static current_worker& current()
+		{
+			thread_local current_worker worker{ nullptr, 0 };
+			return worker;
+		}
+
+		/**
+		 * Takes a task, from the back of a worker's own queue or else from the front of another's.
+		 *
+		 * @param index index of worker.
+		 * @returns the task, or nothing if every queue is empty.
+		 */
+		std::optional<std::function<void()>> take(const std::size_t index)
+		{
+			for (std::size_t i = 0; i < queues_.size(); ++i)
+			{
+				auto& victim = *queues_[(index + i) % queues_.size()];
+
+				std::lock_guard lock{ victim.mutex };
+				if (victim.tasks.empty())
+				{
+					continue;
+				}
+
+				std::function<void()> task;
+				if (i == 0)
+				{
+					task = std::move(victim.tasks.back());
+					victim.tasks.pop_back();
+				}
+				else
+				{
+					task = std::move(victim.tasks.front());
+					victim.tasks.pop_front();
+				}
+
+				pending_.fetch_sub(1, std::memory_order_relaxed);
+				return task;
+			}
+
+			return std::nullopt;
+		}
+
+		void work(const std::size_t index)
+		{
+			current() = { this, index };
+
+			while (true)
+			{
+				if (auto task = take(index))
+				{
+					(*task)();
+					continue;
+				}
+
+				std::unique_lock lock{ sleep_mutex_ };
+				condition_.wait(lock, [this] { return stopping_ || pending_.load(std::memory_order_relaxed) != 0; });
+
+				if (stopping_ && pending_.load(std::memory_order_relaxed) == 0) // Every task has been taken.
+				{
+					return;
+				}
+			}
+		}
+
+	public:
+		/**
+		 * Starts the worker threads.
+		 *
+		 * @param thread_count number of workers, 0 for the number of hardware threads.
+		 */
+		explicit thread_pool(std::size_t thread_count = 0)
+		{
+			if (thread_count == 0)
+			{
+				thread_count = std::max(1u, std::thread::hardware_concurrency());
+			}
+
+			queues_.reserve(thread_count);
+			for (std::size_t i = 0; i < thread_count; ++i)
+			{
+				queues_.push_back(std::make_unique<queue>());
+			}
+
+			workers_.reserve(thread_count);
+			for (std::size_t i = 0; i < thread_count; ++i)
+			{
+				workers_.emplace_back([this, i] { work(i); });
+			}
+		}
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		/**
+		 * Finishes every queued task, then joins the workers.
+		 */
+		~thread_pool()
+		{
+			{
+				std::lock_guard lock{ sleep_mutex_ };
+				stopping_ = true;
+			}
+			condition_.notify_all();
+
+			for (auto& worker : workers_)
+			{
+				worker.join();
+			}
+		}
+
+		/**
+		 * Returns the number of worker threads.
+		 *
+		 * @returns number of workers.
+		 */
+		[[nodiscard]] std::size_t size() const
+		{
+			return workers_.size();
+		}
+
+		/**
+		 * Queues a task.
+		 *
+		 * @param fn task to run on a worker.
+		 * @returns future holding the result of the task, or the exception it threw.
+		 */
+		template <typename Fn>
+		std::future<std::invoke_result_t<Fn>> submit(Fn&& fn)
+		{
+			using result_t = std::invoke_result_t<Fn>;
+
+			auto task = std::make_shared<std::packaged_task<result_t()>>(std::forward<Fn>(fn));
+			auto result = task->get_future();
+
+			const auto& worker = current();
+			const auto index = worker.pool == this
+				? worker.index
+				: next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+			// Counted under the queue lock, which take holds too, so the count never drops below zero, and only once
+			// queued, so a worker woken by it finds it.
+			{
+				std::lock_guard lock{ queues_[index]->mutex };
+				queues_[index]->tasks.emplace_back([task] { (*task)(); });
+				pending_.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			// A worker which saw no tasks holds the sleep lock until it sleeps, so taking it here means it cannot miss the notification.
+			{
+				std::lock_guard lock{ sleep_mutex_ };
+			}
+			condition_.notify_one();
+
+			return result;
+		}
+
+		/**
+		 * Waits for a task, running queued tasks in the meantime.
+		 *
+		 * A task waiting on tasks it submitted would otherwise hold up its
+		 * worker, and once every worker waits nothing is left to run them.
+		 * Helping instead means waiting from a task never deadlocks.
+		 *
+		 * @param future future of the task to wait for, still valid on return.
+		 */
+		template <typename T>
+		void wait(const std::future<T>& future)
+		{
+			const auto& worker = current();
+			const auto index = worker.pool == this ? worker.index : 0;
+
+			while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				if (auto task = take(index))
+				{
+					(*task)();
+				}
+				else
+				{
+					// The task is running, or another waiter took what it is waiting on.
+					future.wait_for(std::chrono::microseconds(100));
+				}
+			}
+		}
+	};
+}
@@ -0,0 +1,215 @@
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "benchmark.hpp"
+#include "../../seam/ir/ast/visitor.hpp"
+#include "../../seam/ir/ast/walker.hpp"
+#include "../../seam/ir/flat/tree.hpp"
+#include "../../seam/parser/parser.hpp"
+#include "../../seam/parser/passes/function_collector.hpp"
+#include "../../seam/parser/passes/pass.hpp"
+#include "../../seam/parser/passes/semantic.hpp"
+#include "../../seam/types/module.hpp"
+#include "../../seam/utils/thread_pool.hpp"
+#include "../3rdparty/catch2.hpp"
+
+namespace
+{
+	/**
+	 * Turns every resolved symbol of a flat tree back into the name it was resolved from.
+	 *
+	 * @param tree flat tree to unresolve.
+	 */
+	void unresolve(seam::ir::flat::tree& tree)
+	{
+		for (seam::ir::flat::node_index i = 0; i < tree.size(); ++i)
+		{
+			if (tree.kinds[i] == seam::ir::flat::node_kind::resolved_symbol)
+			{
+				tree.kinds[i] = seam::ir::flat::node_kind::unresolved_symbol;
+				tree.data[i] = tree.signatures[tree.data[tree.data[i]]].name;
+			}
+		}
+	}
+
+	struct counting_visitor : seam::ir::ast::visitor
+	{
+		std::size_t nodes = 0;
+		std::size_t calls = 0;
+
+		bool visit(seam::ir::ast::node*) override
+		{
+			++nodes;
+			return true;
+		}
+
+		bool visit(seam::ir::ast::expression::call* node) override
+		{
+			++calls;
+			return visit(static_cast<seam::ir::ast::node*>(node));
+		}
+	};
+
+	struct counting_walker : seam::ir::ast::walker<counting_walker>
+	{
+		std::size_t nodes = 0;
+		std::size_t calls = 0;
+
+		using walker::visit;
+
+		bool visit(seam::ir::ast::node*)
+		{
+			++nodes;
+			return true;
+		}
+
+		bool visit(seam::ir::ast::expression::call* node)
+		{
+			++calls;
+			return visit(static_cast<seam::ir::ast::node*>(node));
+		}
+	};
+}
+
+TEST_CASE("AST traversal", "[benchmark][ast]") {
+	const auto source = seam::benchmarks::generate_corpus(20000);
+
+	const auto module = std::make_shared<seam::types::module>("benchmark");
+	seam::parser::parser parser(module, 0, source);
+	module->body = parser.parse();
+
+	counting_visitor visitor;
+	const auto visitor_seconds = seam::benchmarks::measure(10, [&]()
+	{
+		visitor = {};
+		module->body->visit(&visitor);
+	});
+
+	counting_walker walker;
+	const auto walker_seconds = seam::benchmarks::measure(10, [&]()
+	{
+		walker = {};
+		walker.walk(module->body);
+	});
+
+	REQUIRE(walker.nodes == visitor.nodes);
+	REQUIRE(walker.calls == visitor.calls);
+
+	const auto node_count = static_cast<double>(walker.nodes);
+	seam::benchmarks::report("virtual visitor", node_count, "nodes", visitor_seconds);
+	seam::benchmarks::report("walker", node_count, "nodes", walker_seconds);
+}
+
+TEST_CASE("Flat AST conversion", "[benchmark][ast]") {
+	const auto source = seam::benchmarks::generate_corpus(20000);
+
+	const auto module = std::make_shared<seam::types::module>("benchmark");
+	seam::parser::parser parser(module, 0, source);
+	module->body = parser.parse();
+
+	seam::ir::flat::tree flat;
+	const auto flatten_seconds = seam::benchmarks::measure(5, [&]()
+	{
+		flat = seam::ir::flat::flatten(module->body);
+	});
+
+	const auto unflatten_seconds = seam::benchmarks::measure(5, [&]()
+	{
+		seam::utils::arena arena;
+		REQUIRE(seam::ir::flat::unflatten(flat, arena));
+	});
+
+	const auto node_count = static_cast<double>(flat.size());
+	seam::benchmarks::report("flatten", node_count, "nodes", flatten_seconds);
+	seam::benchmarks::report("unflatten", node_count, "nodes", unflatten_seconds);
+}
+
+TEST_CASE("Semantic analysis", "[benchmark][ast]") {
+	const auto source = seam::benchmarks::generate_corpus(20000);
+
+	const auto parse_seconds = [&](const bool multi_pass)
+	{
+		return seam::benchmarks::measure(3, [&]()
+		{
+			const auto module = std::make_shared<seam::types::module>("benchmark");
+			seam::parser::parser parser(module, 0, source, nullptr, multi_pass);
+			module->body = parser.parse();
+		});
+	};
+
+	const auto bytes = static_cast<double>(source.size());
+	seam::benchmarks::report("parse (separate passes)", bytes / (1024.0 * 1024.0), "MiB", parse_seconds(true));
+	seam::benchmarks::report("parse (fused pass)", bytes / (1024.0 * 1024.0), "MiB", parse_seconds(false));
+
+	const auto module = std::make_shared<seam::types::module>("benchmark");
+	seam::parser::parser parser(module, 0, source);
+	module->body = parser.parse();
+
+	// Undo what parsing already resolved and inferred, so both paths redo all of it.
+	auto unresolved = seam::ir::flat::flatten(module->body);
+	unresolve(unresolved);
+	const auto auto_type = module->types.built_in(seam::ir::ast::type::built_in_type::auto_);
+	for (auto& variable : unresolved.variables)
+	{
+		const auto name = module->symbols.name(variable.name);
+		if (name == "intermediate_sum" || name == "scaled_value" || name == "difference")
+		{
+			variable.type = auto_type;
+		}
+	}
+
+	seam::utils::thread_pool pool;
+
+	auto separate_seconds = std::numeric_limits<double>::max();
+	auto fused_seconds = std::numeric_limits<double>::max();
+	auto parallel_seconds = std::numeric_limits<double>::max();
+	for (auto i = 0; i < 5; ++i)
+	{
+		{
+			seam::utils::arena arena;
+			const auto root = seam::ir::flat::unflatten(unresolved, arena);
+
+			const auto start = std::chrono::steady_clock::now();
+			seam::parser::passes::pass::run_passes(root, *module);
+			const auto end = std::chrono::steady_clock::now();
+			separate_seconds = std::min(separate_seconds, std::chrono::duration<double>(end - start).count());
+		}
+
+		{
+			seam::utils::arena arena;
+			const auto root = seam::ir::flat::unflatten(unresolved, arena);
+
+			// The parser gathers these as it goes, so gathering them is not timed.
+			seam::parser::passes::function_collector collector;
+			collector.run(root);
+
+			const auto start = std::chrono::steady_clock::now();
+			seam::parser::passes::semantic semantic{ collector.function_map_, *module };
+			semantic.run(root);
+			const auto end = std::chrono::steady_clock::now();
+			fused_seconds = std::min(fused_seconds, std::chrono::duration<double>(end - start).count());
+		}
+
+		{
+			seam::utils::arena arena;
+			const auto root = seam::ir::flat::unflatten(unresolved, arena);
+
+			seam::parser::passes::function_collector collector;
+			collector.run(root);
+
+			const auto start = std::chrono::steady_clock::now();
+			seam::parser::passes::semantic semantic{ collector.function_map_, *module, &pool };
+			semantic.run(root);
+			const auto end = std::chrono::steady_clock::now();
+			parallel_seconds = std::min(parallel_seconds, std::chrono::duration<double>(end - start).count());
+		}
+	}
+
+	const auto node_count = static_cast<double>(unresolved.size());
+	seam::benchmarks::report("semantic analysis (separate passes)", node_count, "nodes", separate_seconds);
+	seam::benchmarks::report("semantic analysis (fused pass)", node_count, "nodes", fused_seconds);
+	seam::benchmarks::report("semantic analysis (fused pass, " + std::to_string(pool.size()) + " threads)", node_count, "nodes",
+		parallel_seconds);
+}
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace seam::benchmarks
+{
+	/**
+	 * Generates a deterministic Seam program for benchmarking.
+	 *
+	 * The program is made up of functions with long identifiers, block and
+	 * line comments, typed and inferred locals, loops, branches and calls
+	 * to previously generated functions, and is accepted by the parser.
+	 *
+	 * @param function_count number of functions to generate.
+	 * @param seed random seed, the same seed always yields the same source.
+	 * @returns generated source.
+	 */
+	inline std::string generate_corpus(const std::size_t function_count, const std::uint32_t seed = 0x5ea3)
+	{
+		std::mt19937 random{ seed };
+		std::string source;
+		source.reserve(function_count * 640);
+
+		const auto function_name = [](const std::size_t index)
+		{
+			return "compute_value_for_iteration_" + std::to_string(index);
+		};
+
+		for (std::size_t i = 0; i < function_count; ++i)
+		{
+			const auto callee = function_name(i == 0 ? 0 : random() % i);
+
+			source += "/// Generated function number " + std::to_string(i) + ", combines both of its\n";
+			source += "    arguments and forwards the intermediate values to an earlier function. ///\n";
+			source += "fn " + function_name(i) + "(first_argument: i32, second_argument: i32) -> i32\n";
+			source += "{\n";
+			source += "\t// accumulate a handful of values\n";
+			source += "\taccumulated_result: i32 = " + std::to_string(random() % 100000) + "\n";
+			source += "\tintermediate_sum := first_argument + second_argument * first_argument\n";
+			source += "\tscaled_value := intermediate_sum - second_argument / first_argument\n";
+			source += "\twhile (scaled_value < first_argument)\n";
+			source += "\t{\n";
+			source += "\t\t" + callee + "(scaled_value, intermediate_sum)\n";
+			source += "\t}\n";
+			source += "\tif (scaled_value == intermediate_sum)\n";
+			source += "\t{\n";
+			source += "\t\tmessage: string = \"values matched in generated function\"\n";
+			source += "\t}\n";
+			source += "\telse\n";
+			source += "\t{\n";
+			source += "\t\tdifference := scaled_value - intermediate_sum\n";
+			source += "\t}\n";
+			source += "\treturn scaled_value + intermediate_sum\n";
+			source += "}\n\n";
+		}
+
+		return source;
+	}
+
+	/**
+	 * Generates a deterministic Seam program made of deeply nested arithmetic.
+	 *
+	 * Every function returns a single expression mixing all binary operator
+	 * precedences, unary minus and parentheses, so parsing it is dominated by
+	 * the expression parser rather than by statements.
+	 *
+	 * @param function_count number of functions to generate.
+	 * @param depth nesting depth of each expression, which holds about 2^depth operands.
+	 * @param seed random seed, the same seed always yields the same source.
+	 * @returns generated source.
+	 */
+	inline std::string generate_expression_corpus(const std::size_t function_count, const std::size_t depth,
+		const std::uint32_t seed = 0x5ea3)
+	{
+		constexpr std::string_view operators[] = { " + ", " - ", " * ", " / ", " % ", " < ", " == ", " >= " };
+		constexpr std::string_view operands[] = { "first", "second", "17", "third" };
+
+		std::mt19937 random{ seed };
+		std::string source;
+
+		const auto append_expression = [&](const auto& self, const std::size_t remaining) -> void
+		{
+			if (remaining == 0)
+			{
+				source += operands[random() % std::size(operands)];
+				return;
+			}
+
+			const auto parenthesised = random() % 3 == 0;
+			if (random() % 8 == 0)
+			{
+				source += '-';
+			}
+			if (parenthesised)
+			{
+				source += '(';
+			}
+
+			self(self, remaining - 1);
+			source += operators[random() % std::size(operators)];
+			self(self, remaining - 1);
+
+			if (parenthesised)
+			{
+				source += ')';
+			}
+		};
+
+		for (std::size_t i = 0; i < function_count; ++i)
+		{
+			source += "fn nested_" + std::to_string(i) + "(first: i32, second: i32, third: i32) -> i32\n{\n\treturn ";
+			append_expression(append_expression, depth);
+			source += "\n}\n\n";
+		}
+
+		return source;
+	}
+
+	/**
+	 * Generates a deterministic Seam program made of deeply nested blocks.
+	 *
+	 * Every function nests blocks depth levels deep, each declaring a number
+	 * of locals initialised from locals of the enclosing block and from the
+	 * parameters, so name lookups have to see through every enclosing scope.
+	 *
+	 * @param function_count number of functions to generate.
+	 * @param depth number of nested blocks in each function.
+	 * @param local_count number of locals declared in each block.
+	 * @returns generated source.
+	 */
+	inline std::string generate_block_corpus(const std::size_t function_count, const std::size_t depth, const std::size_t local_count)
+	{
+		std::string source;
+
+		const auto local_name = [](const std::size_t level, const std::size_t index)
+		{
+			return "local_" + std::to_string(level) + '_' + std::to_string(index);
+		};
+
+		for (std::size_t i = 0; i < function_count; ++i)
+		{
+			source += "fn nested_blocks_" + std::to_string(i) + "(first: i32, second: i32) -> i32\n{\n";
+
+			for (std::size_t level = 0; level < depth; ++level)
+			{
+				const std::string indent(level + 1, '\t');
+				for (std::size_t index = 0; index < local_count; ++index)
+				{
+					const auto outer = level == 0 ? std::string{ "second" } : local_name(level - 1, index);
+					source += indent + local_name(level, index) + " := " + outer + " * first + " + std::to_string(index) + '\n';
+				}
+				source += indent + "while (" + local_name(level, 0) + " < second)\n" + indent + "{\n";
+			}
+
+			for (std::size_t level = depth; level > 0; --level)
+			{
+				source += std::string(level, '\t') + "}\n";
+			}
+
+			source += "\treturn first\n}\n\n";
+		}
+
+		return source;
+	}
+
+	/**
+	 * Generates a deterministic Seam program which code generation can compile.
+	 *
+	 * Code generation does not handle everything the parser accepts yet, so
+	 * the functions only use typed locals, suffixed literals, calls to extern
+	 * and generated functions, branches and loops.
+	 *
+	 * @param function_count number of functions to generate.
+	 * @param seed random seed, the same seed always yields the same source.
+	 * @returns generated source.
+	 */
+	inline std::string generate_codegen_corpus(const std::size_t function_count, const std::uint32_t seed = 0x5ea3)
+	{
+		std::mt19937 random{ seed };
+		std::string source = "extern report_value(value: i32)\n\n";
+
+		for (std::size_t i = 0; i < function_count; ++i)
+		{
+			const auto callee = "generated_function_" + std::to_string(random() % function_count);
+			const auto constant = std::to_string(random() % 100000) + "i32";
+
+			source += "fn generated_function_" + std::to_string(i) + "(first_argument: i32) -> i32\n";
+			source += "{\n";
+			source += "\tresult: i32 = " + callee + "(" + constant + ")\n";
+			source += "\tif (true)\n\t{\n\t\treport_value(" + constant + ")\n\t}\n";
+			source += "\telse\n\t{\n\t\tfallback: i32 = " + constant + "\n\t}\n";
+			source += "\twhile (false)\n\t{\n\t\t" + callee + "(" + constant + ")\n\t}\n";
+			source += "\treturn result\n";
+			source += "}\n\n";
+		}
+
+		return source;
+	}
+
+	/**
+	 * Returns the number of heap allocations made by the process so far.
+	 *
+	 * @returns number of allocations.
+	 */
+	std::size_t allocation_count();
+
+	/**
+	 * Returns the peak resident set size of the process so far.
+	 *
+	 * @returns peak resident set size in bytes, 0 where unsupported.
+	 */
+	std::size_t peak_resident_size();
+
+	/**
+	 * Runs a function repeatedly and returns the fastest run.
+	 *
+	 * @param iterations number of times to run the function.
+	 * @param fn function to measure.
+	 * @returns fastest run in seconds.
+	 */
+	template <typename Fn>
+	double measure(const std::size_t iterations, Fn&& fn)
+	{
+		auto best = std::numeric_limits<double>::max();
+		for (std::size_t i = 0; i < iterations; ++i)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			fn();
+			const auto end = std::chrono::steady_clock::now();
+			best = std::min(best, std::chrono::duration<double>(end - start).count());
+		}
+		return best;
+	}
+
+	/**
+	 * Prints the throughput of a benchmark.
+	 *
+	 * @param name name of the benchmark.
+	 * @param units number of units processed per run.
+	 * @param unit_name name of a unit, e.g. "tokens".
+	 * @param seconds duration of a single run.
+	 */
+	inline void report(const std::string_view name, const double units, const std::string_view unit_name, const double seconds)
+	{
+		std::cout << name << ": " << static_cast<std::uint64_t>(units / seconds) << ' ' << unit_name << "/s ("
+			<< seconds * 1000.0 << " ms per run)\n";
+	}
+}
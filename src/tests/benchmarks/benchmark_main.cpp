@@ -0,0 +1,19 @@
+#define CATCH_CONFIG_MAIN
+#include "../3rdparty/catch2.hpp"
+
+#include "benchmark.hpp"
+#include "../../seam/utils/statistics.hpp"
+
+namespace seam::benchmarks
+{
+	// Allocations are counted by the operator new in utils/allocation_counter.cpp.
+	std::size_t allocation_count()
+	{
+		return utils::allocation_count();
+	}
+
+	std::size_t peak_resident_size()
+	{
+		return utils::peak_resident_size();
+	}
+}
@@ -0,0 +1,485 @@
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "../../seam/build/scheduler.hpp"
+#include "../../seam/code_generation/code_generation.hpp"
+#include "../../seam/code_generation/compilation_cache.hpp"
+#include "../../seam/code_generation/dependency_graph.hpp"
+#include "../../seam/code_generation/jit.hpp"
+#include "../../seam/parser/parser.hpp"
+#include "../../seam/types/module.hpp"
+#include "../../seam/utils/mapped_file.hpp"
+#include "../../seam/utils/thread_pool.hpp"
+#include "../3rdparty/catch2.hpp"
+
+TEST_CASE("Code generation", "[benchmark][codegen]") {
+	constexpr std::size_t function_count = 20000;
+	const auto source = seam::benchmarks::generate_codegen_corpus(function_count);
+
+	const auto module = std::make_shared<seam::types::module>("benchmark");
+	seam::parser::parser parser(module, 0, source);
+	module->body = parser.parse();
+
+	const auto generate_seconds = [&](seam::utils::thread_pool* pool)
+	{
+		return seam::benchmarks::measure(3, [&]()
+		{
+			seam::code_generation::code_generation generator{ module.get(), nullptr, pool };
+			generator.generate();
+		});
+	};
+
+	const auto partition_seconds = [&](seam::utils::thread_pool* pool)
+	{
+		return seam::benchmarks::measure(3, [&]()
+		{
+			seam::code_generation::code_generation generator{ module.get(), nullptr, pool };
+			generator.generate_partitions();
+		});
+	};
+
+	seam::utils::thread_pool pool;
+	const auto threads = std::to_string(pool.size()) + " threads";
+
+	seam::benchmarks::report("generate (one context)", function_count, "functions", generate_seconds(nullptr));
+	seam::benchmarks::report("generate (linked, " + threads + ")", function_count, "functions", generate_seconds(&pool));
+	seam::benchmarks::report("generate (partitions, 1 thread)", function_count, "functions", partition_seconds(nullptr));
+	seam::benchmarks::report("generate (partitions, " + threads + ")", function_count, "functions", partition_seconds(&pool));
+}
+
+TEST_CASE("End to end compilation", "[benchmark][codegen]") {
+	constexpr std::size_t function_count = 2000;
+	const auto source = seam::benchmarks::generate_codegen_corpus(function_count);
+
+	llvm::SmallString<128> bitcode_path;
+	llvm::SmallString<128> object_path;
+	llvm::sys::fs::createTemporaryFile("seam-benchmark", "bc", bitcode_path);
+	llvm::sys::fs::createTemporaryFile("seam-benchmark", "o", object_path);
+
+	// Compiles the source and writes an object file, with llc if given a path to it and in process otherwise.
+	const auto compile = [&](const std::string& llc_path)
+	{
+		const auto module = std::make_shared<seam::types::module>("benchmark");
+		seam::parser::parser parser(module, 0, source);
+		module->body = parser.parse();
+
+		seam::code_generation::code_generation generator{ module.get() };
+		const auto llvm_module = generator.generate();
+
+		if (llc_path.empty())
+		{
+			std::error_code error_code;
+			llvm::raw_fd_ostream output{ object_path, error_code };
+			generator.emit(*llvm_module, output);
+			return;
+		}
+
+		{
+			std::error_code error_code;
+			llvm::raw_fd_ostream bitcode{ bitcode_path, error_code };
+			llvm::WriteBitcodeToFile(*llvm_module, bitcode);
+		}
+
+		const llvm::StringRef arguments[] = { llc_path, "-filetype=obj", "-relocation-model=pic", "-o", object_path, bitcode_path };
+		if (llvm::sys::ExecuteAndWait(llc_path, arguments) != 0)
+		{
+			throw std::runtime_error("llc failed");
+		}
+	};
+
+	seam::benchmarks::report("compile (in process)", function_count, "functions", seam::benchmarks::measure(3, [&]()
+	{
+		compile({});
+	}));
+
+	if (const auto llc_path = llvm::sys::findProgramByName("llc"))
+	{
+		seam::benchmarks::report("compile (bitcode and llc)", function_count, "functions", seam::benchmarks::measure(3, [&]()
+		{
+			compile(*llc_path);
+		}));
+	}
+	else
+	{
+		std::cout << "compile (bitcode and llc): skipped, llc not found\n";
+	}
+
+	llvm::sys::fs::remove(bitcode_path);
+	llvm::sys::fs::remove(object_path);
+}
+
+TEST_CASE("JIT execution", "[benchmark][codegen]") {
+	constexpr std::size_t function_count = 2000;
+
+	// The program only calls one of its functions, as a snippet run while working on a larger program would.
+	const auto source = seam::benchmarks::generate_codegen_corpus(function_count) +
+		"fn main() @constructor\n{\n\treport_value(1i32)\n}\n";
+
+	const auto report_value = +[](std::int32_t) {};
+
+	// Compiles the source and runs it, from source to the entry function returning.
+	const auto run = [&](const bool lazy)
+	{
+		const auto module = std::make_shared<seam::types::module>("benchmark");
+		seam::parser::parser parser(module, 0, source);
+		module->body = parser.parse();
+
+		seam::code_generation::code_generation generator{ module.get() };
+		generator.generate();
+
+		seam::code_generation::jit engine{ seam::code_generation::optimization_level::o0, lazy };
+		engine.define("report_value", reinterpret_cast<void*>(report_value));
+		engine.add(generator.release());
+		engine.run();
+	};
+
+	seam::benchmarks::report("run (lazy JIT)", function_count, "functions", seam::benchmarks::measure(3, [&]()
+	{
+		run(true);
+	}));
+	seam::benchmarks::report("run (eager JIT)", function_count, "functions", seam::benchmarks::measure(3, [&]()
+	{
+		run(false);
+	}));
+}
+
+TEST_CASE("Compilation cache", "[benchmark][codegen]") {
+	constexpr std::size_t function_count = 2000;
+	const auto source = seam::benchmarks::generate_codegen_corpus(function_count);
+
+	// The same corpus with the body of one function changed.
+	auto edited = source;
+	const auto edit = edited.find("\t\treport_value(") + 15;
+	edited.insert(edit, "1");
+
+	llvm::SmallString<128> directory;
+	llvm::sys::fs::createUniqueDirectory("seam-benchmark-cache", directory);
+
+	const auto parse = [](const std::string& text)
+	{
+		const auto module = std::make_shared<seam::types::module>("benchmark");
+		seam::parser::parser parser(module, 0, text);
+		module->body = parser.parse();
+		return module;
+	};
+
+	// Each run starts from a cache holding only what fill puts in it, and only the run is timed.
+	const auto measure = [&](const auto& fill, const auto& run)
+	{
+		auto best = std::numeric_limits<double>::max();
+		for (auto i = 0; i < 3; ++i)
+		{
+			llvm::sys::fs::remove_directories(directory);
+			seam::code_generation::compilation_cache cache{ directory.str().str() };
+			fill(cache);
+
+			const auto start = std::chrono::steady_clock::now();
+			run(cache);
+			best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	};
+
+	const auto nothing = [](seam::code_generation::compilation_cache&) {};
+
+	const auto objects = [&](const std::string& text)
+	{
+		return [&](seam::code_generation::compilation_cache& cache)
+		{
+			const auto module = parse(text);
+			seam::code_generation::code_generation generator{ module.get() };
+			generator.generate_objects(&cache);
+		};
+	};
+
+	const auto whole_module = [&](seam::code_generation::compilation_cache& cache)
+	{
+		const auto module = parse(source);
+		seam::code_generation::code_generation generator{ module.get() };
+
+		const auto key = generator.module_cache_key(source, llvm::CGFT_ObjectFile);
+		if (!cache.load(key))
+		{
+			llvm::SmallVector<char, 0> object;
+			llvm::raw_svector_ostream stream{ object };
+			generator.emit(*generator.generate(), stream);
+			cache.store(key, llvm::StringRef{ object.data(), object.size() });
+		}
+	};
+
+	seam::benchmarks::report("module (cold)", function_count, "functions", measure(nothing, whole_module));
+	seam::benchmarks::report("module (cached)", function_count, "functions", measure(whole_module, whole_module));
+	seam::benchmarks::report("functions (cold)", function_count, "functions", measure(nothing, objects(source)));
+	seam::benchmarks::report("functions (cached)", function_count, "functions", measure(objects(source), objects(source)));
+	seam::benchmarks::report("functions (one edited)", function_count, "functions", measure(objects(source), objects(edited)));
+
+	llvm::sys::fs::remove_directories(directory);
+}
+
+TEST_CASE("Incremental compilation", "[benchmark][codegen]") {
+	using seam::code_generation::dependency_graph;
+
+	constexpr std::size_t function_count = 2000;
+	const auto source = seam::benchmarks::generate_codegen_corpus(function_count);
+
+	llvm::SmallString<128> directory;
+	llvm::sys::fs::createUniqueDirectory("seam-benchmark-incremental", directory);
+
+	// Builds as the driver does with a cache and the JIT, returning the number of functions compiled again.
+	const auto build = [&](seam::code_generation::compilation_cache& cache, const std::string& text)
+	{
+		const auto module = std::make_shared<seam::types::module>("benchmark");
+		seam::parser::parser parser(module, 0, text);
+		seam::code_generation::code_generation generator{ module.get() };
+
+		const auto entry = cache.load(dependency_graph::cache_entry(module->name));
+		auto graph = entry ? dependency_graph::read(entry->getBuffer()) : dependency_graph{};
+
+		module->body = parser.parse_syntax();
+		seam::code_generation::function_keys keys;
+		const auto changed = graph.update(module->body, text, module->symbols, generator.configuration_key(), cache, keys);
+		parser.analyse(module->body, changed);
+		generator.generate_objects(&cache, &keys);
+
+		graph.record(changed, module->symbols, keys);
+		cache.store(dependency_graph::cache_entry(module->name), graph.write());
+		return changed.size();
+	};
+
+	// Each run starts from a cache filled by building the source, and only the build of the edited source is timed.
+	const auto measure = [&](const std::string& edited, const bool filled, std::size_t& changed)
+	{
+		auto best = std::numeric_limits<double>::max();
+		for (auto i = 0; i < 3; ++i)
+		{
+			llvm::sys::fs::remove_directories(directory);
+			seam::code_generation::compilation_cache cache{ directory.str().str() };
+			if (filled)
+			{
+				build(cache, source);
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			changed = build(cache, edited);
+			best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	};
+
+	// Scripted edits, each applied to the corpus on its own.
+	const auto edit_bodies = [&](const std::size_t count)
+	{
+		auto edited = source;
+		auto position = std::string::size_type{ 0 };
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			position = edited.find("\t\treport_value(", position + 1);
+			edited.insert(position + 15, "1");
+			for (std::size_t skip = 0; skip < function_count / count - 1; ++skip)
+			{
+				position = edited.find("\t\treport_value(", position + 1);
+			}
+		}
+		return edited;
+	};
+
+	auto blank_lines = source;
+	for (auto position = blank_lines.find("\n\nfn "); position != std::string::npos; position = blank_lines.find("\n\nfn ", position + 200))
+	{
+		blank_lines.insert(position, "\n");
+	}
+
+	// The function the first one calls, so at least one caller is compiled again.
+	const auto callee_start = source.find("result: i32 = ") + 14;
+	const auto callee = source.substr(callee_start, source.find('(', callee_start) - callee_start);
+	auto signature = source;
+	const auto declaration = "fn " + callee + "(first_argument: i32) -> i32";
+	signature.insert(signature.find(declaration + "\n") + declaration.size(), " @export");
+
+	const std::pair<const char*, std::string> edits[] = {
+		{ "unchanged", source },
+		{ "one body edited", edit_bodies(1) },
+		{ "ten bodies edited", edit_bodies(10) },
+		{ "one signature edited", signature },
+		{ "blank lines added", blank_lines },
+	};
+
+	std::size_t changed;
+	const auto full_seconds = measure(source, false, changed);
+	std::cout << "incremental compilation, full build: " << changed << " functions, " << full_seconds * 1000.0 << " ms\n";
+
+	for (const auto& [name, edited] : edits)
+	{
+		const auto seconds = measure(edited, true, changed);
+		std::cout << "incremental compilation, " << name << ": " << changed << " of " << function_count
+			<< " functions compiled again, " << seconds * 1000.0 << " ms, saving " << (full_seconds - seconds) * 1000.0 << " ms\n";
+	}
+
+	llvm::sys::fs::remove_directories(directory);
+}
+
+TEST_CASE("Build scheduling", "[benchmark][codegen]") {
+	constexpr std::size_t layers = 4;
+	constexpr std::size_t width = 4;
+	constexpr std::size_t function_count = 150;
+
+	const auto module_name = [](const std::size_t layer, const std::size_t index)
+	{
+		return "layer_" + std::to_string(layer) + '_' + std::to_string(index);
+	};
+
+	// Every module imports the whole layer below it, and exports a function calling each of their exported functions.
+	std::vector<std::pair<std::string, std::string>> sources;
+	for (std::size_t layer = 0; layer < layers; ++layer)
+	{
+		for (std::size_t index = 0; index < width; ++index)
+		{
+			std::string source;
+			std::string calls;
+			for (std::size_t below = 0; layer > 0 && below < width; ++below)
+			{
+				source += "import " + module_name(layer - 1, below) + '\n';
+				calls += "\tresult_" + std::to_string(below) + ": i32 = " + module_name(layer - 1, below) + "_export(value)\n";
+			}
+
+			source += seam::benchmarks::generate_codegen_corpus(function_count, static_cast<std::uint32_t>(layer * width + index));
+			source += "fn " + module_name(layer, index) + "_export(value: i32) -> i32 @export\n{\n" + calls + "\treturn value\n}\n";
+			sources.emplace_back(module_name(layer, index), std::move(source));
+		}
+	}
+
+	const auto build = [&](const std::size_t thread_count)
+	{
+		std::vector<seam::build::source_file> files;
+		for (std::size_t i = 0; i < sources.size(); ++i)
+		{
+			files.push_back({ std::make_shared<seam::types::module>(sources[i].first), static_cast<std::uint32_t>(i), sources[i].second });
+		}
+
+		seam::utils::thread_pool pool{ thread_count };
+		seam::build::scheduler scheduler{ pool };
+		return scheduler.build(files, [](seam::types::module& module)
+		{
+			seam::code_generation::code_generation generator{ &module };
+			llvm::SmallVector<char, 0> object;
+			llvm::raw_svector_ostream stream{ object };
+			generator.emit(*generator.generate(), stream);
+		});
+	};
+
+	for (const std::size_t thread_count : { 1, 2, 4 })
+	{
+		auto best = build(thread_count);
+		for (auto i = 0; i < 2; ++i)
+		{
+			auto report = build(thread_count);
+			if (report.duration < best.duration)
+			{
+				best = std::move(report);
+			}
+		}
+
+		std::cout << "build scheduling, " << sources.size() << " modules on " << thread_count << " threads: " << best.duration * 1000.0
+			<< " ms, " << best.work() * 1000.0 << " ms of work, critical path " << best.critical_path_length() * 1000.0
+			<< " ms, utilization " << best.utilization() * 100.0 << "%\n";
+	}
+}
+
+TEST_CASE("Optimization levels", "[benchmark][codegen]") {
+	using seam::code_generation::local_storage;
+	using seam::code_generation::optimization_level;
+
+	struct configuration
+	{
+		optimization_level level;
+		local_storage locals;
+		const char* name;
+	};
+
+	constexpr configuration configurations[] = {
+		{ optimization_level::o0, local_storage::stack, "O0" },
+		{ optimization_level::o0, local_storage::ssa, "O0 --locals=ssa" },
+		{ optimization_level::o1, local_storage::stack, "O1" },
+		{ optimization_level::o2, local_storage::stack, "O2" },
+		{ optimization_level::o3, local_storage::stack, "O3" },
+		{ optimization_level::os, local_storage::stack, "Os" },
+	};
+
+	const std::string programs = SEAM_BENCHMARK_PROGRAMS;
+	const auto harness_path = programs + "/harness.c";
+
+	// Programs are only run if they can be linked into executables.
+	const auto cc_path = llvm::sys::findProgramByName("cc");
+	if (!cc_path)
+	{
+		std::cout << "optimization levels: cc not found, only measuring compilation\n";
+	}
+
+	llvm::SmallString<128> directory;
+	llvm::sys::fs::createUniqueDirectory("seam-benchmark", directory);
+	const std::string object_path = (directory + "/program.o").str();
+	const std::string executable_path = (directory + "/program").str();
+
+	for (const auto program : { "fibonacci", "loops", "calls", "collatz" })
+	{
+		for (const auto& [level, locals, configuration_name] : configurations)
+		{
+			const auto compile_seconds = seam::benchmarks::measure(3, [&]()
+			{
+				const auto module = std::make_shared<seam::types::module>(program);
+				module->source = seam::utils::mapped_file::open(programs + "/" + program + ".sm");
+				seam::parser::parser parser(module, 0, module->source->contents());
+				module->body = parser.parse();
+
+				seam::code_generation::code_generation generator{ module.get(), nullptr, nullptr,
+					seam::code_generation::code_generation::default_partition_size, level, locals };
+				const auto llvm_module = generator.generate();
+
+				std::error_code error_code;
+				llvm::raw_fd_ostream output{ object_path, error_code };
+				generator.emit(*llvm_module, output);
+			});
+
+			const auto name = std::string{ program } + " -" + configuration_name;
+			std::cout << name << ": compiled in " << compile_seconds * 1000.0 << " ms";
+
+			if (cc_path)
+			{
+				const llvm::StringRef link_arguments[] = { *cc_path, harness_path, object_path, "-o", executable_path };
+				if (llvm::sys::ExecuteAndWait(*cc_path, link_arguments) != 0)
+				{
+					throw std::runtime_error("cannot link " + name);
+				}
+
+				// Only its result is printed, so the output is dropped.
+				const llvm::Optional<llvm::StringRef> redirects[] = { llvm::None, llvm::StringRef{}, llvm::None };
+				const llvm::StringRef run_arguments[] = { executable_path };
+				const auto run_seconds = seam::benchmarks::measure(3, [&]()
+				{
+					if (llvm::sys::ExecuteAndWait(executable_path, run_arguments, llvm::None, redirects) != 0)
+					{
+						throw std::runtime_error(name + " failed");
+					}
+				});
+				std::cout << ", ran in " << run_seconds * 1000.0 << " ms";
+			}
+			std::cout << '\n';
+		}
+	}
+
+	llvm::sys::fs::remove_directories(directory);
+}
@@ -0,0 +1,75 @@
+#include <memory>
+
+#include "benchmark.hpp"
+#include "../../seam/types/module.hpp"
+#include "../../seam/lexer/lexer.hpp"
+#include "../../seam/utils/thread_pool.hpp"
+#include "../3rdparty/catch2.hpp"
+
+TEST_CASE("Lexer throughput", "[benchmark][lexer]") {
+	const auto source = seam::benchmarks::generate_corpus(20000);
+	const auto module = std::make_shared<seam::types::module>("benchmark");
+
+	std::size_t token_count = 0;
+	const auto seconds = seam::benchmarks::measure(5, [&]()
+	{
+		seam::lexer::lexer lexer(module, source);
+
+		token_count = 0;
+		do
+		{
+			lexer.next_lexeme();
+			++token_count;
+		} while (lexer.current_lexeme().type != seam::lexer::lexeme_type::eof);
+	});
+
+	seam::benchmarks::report("lexer", static_cast<double>(token_count), "tokens", seconds);
+	REQUIRE(token_count > 0);
+}
+
+TEST_CASE("Lexer batch throughput", "[benchmark][lexer]") {
+	const auto source = seam::benchmarks::generate_corpus(20000);
+	const auto module = std::make_shared<seam::types::module>("benchmark");
+
+	std::size_t token_count = 0;
+	const auto seconds = seam::benchmarks::measure(5, [&]()
+	{
+		seam::lexer::lexer lexer(module, source);
+		token_count = lexer.tokenize().size();
+	});
+
+	seam::benchmarks::report("lexer (batch)", static_cast<double>(token_count), "tokens", seconds);
+	REQUIRE(token_count > 0);
+}
+
+TEST_CASE("Lexer batch throughput, interning identifiers", "[benchmark][lexer]") {
+	const auto source = seam::benchmarks::generate_corpus(20000);
+	const auto module = std::make_shared<seam::types::module>("benchmark");
+
+	std::size_t token_count = 0;
+	const auto seconds = seam::benchmarks::measure(5, [&]()
+	{
+		seam::lexer::lexer lexer(module, source, 0, true);
+		token_count = lexer.tokenize().size();
+	});
+
+	seam::benchmarks::report("lexer (batch, interning)", static_cast<double>(token_count), "tokens", seconds);
+	REQUIRE(token_count > 0);
+}
+
+TEST_CASE("Lexer parallel throughput", "[benchmark][lexer]") {
+	const auto source = seam::benchmarks::generate_corpus(20000);
+	const auto module = std::make_shared<seam::types::module>("benchmark");
+	seam::utils::thread_pool pool;
+
+	std::size_t token_count = 0;
+	const auto seconds = seam::benchmarks::measure(5, [&]()
+	{
+		seam::lexer::lexer lexer(module, source);
+		token_count = lexer.tokenize(pool).size();
+	});
+
+	seam::benchmarks::report("lexer (parallel, " + std::to_string(pool.size()) + " threads)",
+		static_cast<double>(token_count), "tokens", seconds);
+	REQUIRE(token_count > 0);
+}
@@ -0,0 +1,76 @@
+#include <chrono>
+#include <memory>
+
+#include "benchmark.hpp"
+#include "../../seam/types/module.hpp"
+#include "../../seam/parser/parser.hpp"
+#include "../3rdparty/catch2.hpp"
+
+TEST_CASE("Parser throughput", "[benchmark][parser]") {
+	const auto source = seam::benchmarks::generate_corpus(20000);
+
+	std::size_t allocations = 0;
+	const auto seconds = seam::benchmarks::measure(5, [&]()
+	{
+		const auto first_allocation = seam::benchmarks::allocation_count();
+		{
+			const auto module = std::make_shared<seam::types::module>("benchmark");
+			seam::parser::parser parser(module, 0, source);
+			module->body = parser.parse();
+		}
+		allocations = seam::benchmarks::allocation_count() - first_allocation;
+	});
+
+	seam::benchmarks::report("parser", static_cast<double>(source.size()) / (1024.0 * 1024.0), "MiB", seconds);
+	std::cout << "parser: " << allocations << " allocations per run\n";
+}
+
+TEST_CASE("Parser nested expressions", "[benchmark][parser]") {
+	const auto source = seam::benchmarks::generate_expression_corpus(2000, 10);
+
+	const auto seconds = seam::benchmarks::measure(5, [&]()
+	{
+		const auto module = std::make_shared<seam::types::module>("benchmark");
+		seam::parser::parser parser(module, 0, source);
+		module->body = parser.parse();
+	});
+
+	seam::benchmarks::report("parser (nested expressions)", static_cast<double>(source.size()) / (1024.0 * 1024.0), "MiB", seconds);
+}
+
+TEST_CASE("Parser nested blocks", "[benchmark][parser]") {
+	const auto source = seam::benchmarks::generate_block_corpus(1000, 32, 8);
+
+	const auto seconds = seam::benchmarks::measure(5, [&]()
+	{
+		const auto module = std::make_shared<seam::types::module>("benchmark");
+		seam::parser::parser parser(module, 0, source);
+		module->body = parser.parse();
+	});
+
+	seam::benchmarks::report("parser (nested blocks)", static_cast<double>(source.size()) / (1024.0 * 1024.0), "MiB", seconds);
+}
+
+TEST_CASE("Parser memory", "[benchmark][parser][memory]") {
+	// Peak RSS covers the whole process, run this test on its own for a meaningful number.
+	const auto source = seam::benchmarks::generate_corpus(100000);
+
+	auto module = std::make_shared<seam::types::module>("benchmark");
+
+	const auto parse_start = std::chrono::steady_clock::now();
+	{
+		seam::parser::parser parser(module, 0, source);
+		module->body = parser.parse();
+	}
+	const auto parse_end = std::chrono::steady_clock::now();
+
+	module.reset();
+	const auto destroy_end = std::chrono::steady_clock::now();
+
+	const auto parse_seconds = std::chrono::duration<double>(parse_end - parse_start).count();
+	const auto destroy_seconds = std::chrono::duration<double>(destroy_end - parse_end).count();
+
+	seam::benchmarks::report("parser (100k functions)", static_cast<double>(source.size()) / (1024.0 * 1024.0), "MiB", parse_seconds);
+	std::cout << "parser (100k functions): " << destroy_seconds * 1000.0 << " ms to destroy, "
+		<< seam::benchmarks::peak_resident_size() / (1024 * 1024) << " MiB peak resident\n";
+}
@@ -0,0 +1,28 @@
+/*
+ * Runs a Seam benchmark program, which is linked against this file.
+ *
+ * The programs read their input from seed, which the optimiser cannot see
+ * through, so their work cannot be done at compile time, and hand their
+ * results to consume so it cannot be thrown away.
+ */
+#include <stdio.h>
+
+void entry(void);
+
+volatile int seed_value = 0;
+
+int seed(void)
+{
+	return seed_value;
+}
+
+void consume(int value)
+{
+	printf("%d\n", value);
+}
+
+int main(void)
+{
+	entry();
+	return 0;
+}
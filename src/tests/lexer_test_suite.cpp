@@ -1,11 +1,105 @@
 #define CATCH_CONFIG_MAIN
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 #include "../seam/types/module.hpp"
+#include "../seam/build/scheduler.hpp"
+#include "../seam/code_generation/code_generation.hpp"
+#include "../seam/code_generation/compilation_cache.hpp"
+#include "../seam/code_generation/dependency_graph.hpp"
+#include "../seam/code_generation/jit.hpp"
+#include "../seam/ir/flat/tree.hpp"
+#include "../seam/parser/parser.hpp"
+#include "../seam/parser/passes/pass.hpp"
+#include "../seam/parser/passes/pass_manager.hpp"
 #include "../seam/lexer/lexeme.hpp"
 #include "../seam/lexer/lexer.hpp"
+#include "../seam/utils/exception.hpp"
+#include "../seam/utils/interner.hpp"
+#include "../seam/utils/source_map.hpp"
+#include "../seam/utils/statistics.hpp"
+#include "../seam/utils/thread_pool.hpp"
 #include "3rdparty/catch2.hpp"
 
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace
+{
+	enum class lex_mode
+	{
+		streaming,
+		batch,
+	};
+
+	struct recording_pass : seam::parser::passes::pass
+	{
+		std::string name;
+		std::vector<std::string>& ran;
+
+		recording_pass(std::string name, std::vector<std::string>& ran) :
+			name(std::move(name)), ran(ran)
+		{}
+
+		void run(seam::ir::ast::node*) override
+		{
+			ran.push_back(name);
+		}
+	};
+
+	/**
+	 * Lexes a whole source up to and including eof.
+	 *
+	 * @param source source to lex.
+	 * @param mode whether to pull lexemes one by one or walk a token buffer.
+	 * @param intern_identifiers whether the lexer interns identifiers.
+	 * @returns every lexeme of the source.
+	 */
+	std::vector<seam::lexer::lexeme> lex_all(const std::string_view source, const lex_mode mode,
+		const bool intern_identifiers = true)
+	{
+		seam::lexer::lexer lexer(std::make_shared<seam::types::module>("test"), source, 0, intern_identifiers);
+		std::vector<seam::lexer::lexeme> lexemes;
+
+		if (mode == lex_mode::batch)
+		{
+			const auto buffer = lexer.tokenize();
+			seam::lexer::token_cursor cursor{ buffer };
+			while (true)
+			{
+				lexemes.push_back(cursor.current_lexeme());
+				if (cursor.current_lexeme().type == seam::lexer::lexeme_type::eof)
+				{
+					return lexemes;
+				}
+				cursor.next_lexeme();
+			}
+		}
+
+		do
+		{
+			lexer.next_lexeme();
+			lexemes.push_back(lexer.current_lexeme());
+		} while (lexer.current_lexeme().type != seam::lexer::lexeme_type::eof);
+		return lexemes;
+	}
+}
+
 TEST_CASE("Example lexed source", "[lexer]") {
 	std::vector<seam::lexer::lexeme> expected_lexemes = {
 		{ seam::lexer::lexeme_type::kw_fn },
@@ -37,9 +131,8 @@ TEST_CASE("Example lexed source", "[lexer]") {
 		{ seam::lexer::lexeme_type::eof },
 	};
 	
-    seam::lexer::lexer lexer(
-		std::make_shared<seam::types::module>("test"),
-	R"(
+	const auto mode = GENERATE(lex_mode::streaming, lex_mode::batch);
+	const auto lexemes = lex_all(R"(
 		fn test_arrow_method(arg: i32) -> i32
 		{
 			return arg + 1
@@ -49,16 +142,1411 @@ TEST_CASE("Example lexed source", "[lexer]") {
 		{
 			test_arrow_method(2)
 		}
-	)");	
+	)", mode);
 
-	for (auto expected_lexeme: expected_lexemes)
+	REQUIRE(lexemes.size() == expected_lexemes.size());
+	for (std::size_t i = 0; i < expected_lexemes.size(); ++i)
 	{
-		lexer.next_lexeme();
-		auto next_lexeme = lexer.current_lexeme();
+		const auto& expected_lexeme = expected_lexemes[i];
+		const auto& next_lexeme = lexemes[i];
 		REQUIRE(next_lexeme.type == expected_lexeme.type);
 		if (!expected_lexeme.value.empty())
 		{
 			REQUIRE(next_lexeme.value == expected_lexeme.value);
 		}
 	}
-}
\ No newline at end of file
+}
+TEST_CASE("Keywords and symbols", "[lexer]") {
+	std::vector<seam::lexer::lexeme_type> expected_types = {
+		seam::lexer::lexeme_type::kw_fn, seam::lexer::lexeme_type::kw_as, seam::lexer::lexeme_type::kw_return,
+		seam::lexer::lexeme_type::kw_type, seam::lexer::lexeme_type::kw_try, seam::lexer::lexeme_type::kw_catch,
+		seam::lexer::lexeme_type::kw_switch, seam::lexer::lexeme_type::kw_throw, seam::lexer::lexeme_type::kw_true,
+		seam::lexer::lexeme_type::kw_false, seam::lexer::lexeme_type::kw_while, seam::lexer::lexeme_type::kw_for,
+		seam::lexer::lexeme_type::kw_if, seam::lexer::lexeme_type::kw_elseif, seam::lexer::lexeme_type::kw_else,
+		seam::lexer::lexeme_type::kw_extern, seam::lexer::lexeme_type::identifier, seam::lexer::lexeme_type::identifier,
+		seam::lexer::lexeme_type::identifier,
+		seam::lexer::lexeme_type::symbol_add, seam::lexer::lexeme_type::symbol_add_assign,
+		seam::lexer::lexeme_type::symbol_minus, seam::lexer::lexeme_type::symbol_minus_assign,
+		seam::lexer::lexeme_type::symbol_multiply, seam::lexer::lexeme_type::symbol_multiply_assign,
+		seam::lexer::lexeme_type::symbol_divide, seam::lexer::lexeme_type::symbol_divide_assign,
+		seam::lexer::lexeme_type::symbol_mod, seam::lexer::lexeme_type::symbol_open_parenthesis,
+		seam::lexer::lexeme_type::symbol_close_parenthesis, seam::lexer::lexeme_type::symbol_open_bracket,
+		seam::lexer::lexeme_type::symbol_close_bracket, seam::lexer::lexeme_type::symbol_open_brace,
+		seam::lexer::lexeme_type::symbol_close_brace, seam::lexer::lexeme_type::symbol_arrow,
+		seam::lexer::lexeme_type::symbol_equals, seam::lexer::lexeme_type::symbol_not,
+		seam::lexer::lexeme_type::symbol_question_mark, seam::lexer::lexeme_type::symbol_colon,
+		seam::lexer::lexeme_type::symbol_colon_equals, seam::lexer::lexeme_type::symbol_comma,
+		seam::lexer::lexeme_type::symbol_eq, seam::lexer::lexeme_type::symbol_neq,
+		seam::lexer::lexeme_type::symbol_lt, seam::lexer::lexeme_type::symbol_lteq,
+		seam::lexer::lexeme_type::symbol_gt, seam::lexer::lexeme_type::symbol_gteq,
+		seam::lexer::lexeme_type::symbol_and, seam::lexer::lexeme_type::symbol_or,
+		seam::lexer::lexeme_type::symbol_gt,
+		seam::lexer::lexeme_type::eof,
+	};
+
+	const auto mode = GENERATE(lex_mode::streaming, lex_mode::batch);
+	const auto lexemes = lex_all(
+		"fn as return type try catch switch throw true false while for if elseif else extern "
+		"types Fn else_ "
+		"+ += - -= * *= / /= % ( ) [ ] { } -> = ! ? : := , == != < <= > >= && || >", mode);
+
+	REQUIRE(lexemes.size() == expected_types.size());
+	for (std::size_t i = 0; i < expected_types.size(); ++i)
+	{
+		REQUIRE(lexemes[i].type == expected_types[i]);
+	}
+}
+
+TEST_CASE("Comments, strings and positions", "[lexer]") {
+	const auto mode = GENERATE(lex_mode::streaming, lex_mode::batch);
+	const std::string_view source =
+		"first // line comment\n"
+		"/// long comment\n"
+		"    spanning two lines ///second\n"
+		"\t\"string \\\" with\nnewline\" third // trailing";
+	const auto lexemes = lex_all(source, mode);
+	const seam::utils::line_table lines{ source };
+
+	REQUIRE(lexemes.size() == 5);
+
+	REQUIRE(lexemes[0].value == "first");
+	REQUIRE(lines.resolve(lexemes[0].position.offset).line == 1);
+	REQUIRE(lines.resolve(lexemes[0].position.offset).column == 1);
+
+	REQUIRE(lexemes[1].value == "second");
+	REQUIRE(lines.resolve(lexemes[1].position.offset).line == 3);
+	REQUIRE(lines.resolve(lexemes[1].position.offset).column == 27);
+
+	REQUIRE(lexemes[2].type == seam::lexer::lexeme_type::literal_string);
+	REQUIRE(lexemes[2].value == "string \\\" with\nnewline");
+	REQUIRE(lines.resolve(lexemes[2].position.offset).line == 4);
+	REQUIRE(lines.resolve(lexemes[2].position.offset).column == 2);
+
+	REQUIRE(lexemes[3].value == "third");
+	REQUIRE(lines.resolve(lexemes[3].position.offset).line == 5);
+	REQUIRE(lines.resolve(lexemes[3].position.offset).column == 10);
+
+	REQUIRE(lexemes[4].type == seam::lexer::lexeme_type::eof);
+}
+
+TEST_CASE("Unterminated literals", "[lexer]") {
+	const auto mode = GENERATE(lex_mode::streaming, lex_mode::batch);
+
+	REQUIRE_THROWS_AS(lex_all("\"never closed", mode), seam::utils::lexical_exception);
+	REQUIRE_THROWS_AS(lex_all("/// never closed //", mode), seam::utils::lexical_exception);
+}
+
+TEST_CASE("Number literals", "[lexer]") {
+	using seam::lexer::number_suffix;
+	const auto mode = GENERATE(lex_mode::streaming, lex_mode::batch);
+	const auto lexemes = lex_all("42 1_000_000 0xff_ff 18446744073709551615 3.25 1_0.5 255u8 7i64 2f32 1.5f64 0x10u16", mode);
+
+	REQUIRE(lexemes.size() == 12);
+	for (auto i = 0; i < 11; ++i)
+	{
+		REQUIRE(lexemes[i].type == seam::lexer::lexeme_type::literal_number);
+	}
+
+	REQUIRE(lexemes[0].number == seam::lexer::number_value{ std::uint64_t{ 42 } });
+	REQUIRE(lexemes[1].number == seam::lexer::number_value{ std::uint64_t{ 1000000 } });
+	REQUIRE(lexemes[2].number == seam::lexer::number_value{ std::uint64_t{ 0xffff } });
+	REQUIRE(lexemes[3].number == seam::lexer::number_value{ std::uint64_t{ UINT64_MAX } });
+	REQUIRE(lexemes[4].number == seam::lexer::number_value{ 3.25 });
+	REQUIRE(lexemes[5].number == seam::lexer::number_value{ 10.5 });
+	REQUIRE(lexemes[6].number == seam::lexer::number_value{ std::uint64_t{ 255 }, number_suffix::u8 });
+	REQUIRE(lexemes[7].number == seam::lexer::number_value{ std::uint64_t{ 7 }, number_suffix::i64 });
+	REQUIRE(lexemes[8].number == seam::lexer::number_value{ 2.0, number_suffix::f32 });
+	REQUIRE(lexemes[9].number == seam::lexer::number_value{ 1.5, number_suffix::f64 });
+	REQUIRE(lexemes[10].number == seam::lexer::number_value{ std::uint64_t{ 16 }, number_suffix::u16 });
+	REQUIRE(lexemes[6].value == "255u8");
+
+	REQUIRE_THROWS_AS(lex_all("18446744073709551616", mode), seam::utils::lexical_exception);
+	REQUIRE_THROWS_AS(lex_all("256u8", mode), seam::utils::lexical_exception);
+	REQUIRE_THROWS_AS(lex_all("128i8", mode), seam::utils::lexical_exception);
+	REQUIRE_THROWS_AS(lex_all("1.5u8", mode), seam::utils::lexical_exception);
+	REQUIRE_THROWS_AS(lex_all("0x1.5", mode), seam::utils::lexical_exception);
+	REQUIRE_THROWS_AS(lex_all("1.2.3", mode), seam::utils::lexical_exception);
+	REQUIRE_THROWS_AS(lex_all("0x", mode), seam::utils::lexical_exception);
+	REQUIRE_THROWS_AS(lex_all("12abc", mode), seam::utils::lexical_exception);
+}
+
+TEST_CASE("Token cursor lookahead", "[lexer]") {
+	seam::lexer::lexer lexer(std::make_shared<seam::types::module>("test"), "a := b + 1");
+	const auto buffer = lexer.tokenize();
+	seam::lexer::token_cursor cursor{ buffer };
+
+	REQUIRE(buffer.size() == 6);
+	REQUIRE(cursor.peek_type(0) == seam::lexer::lexeme_type::identifier);
+	REQUIRE(cursor.peek_type(1) == seam::lexer::lexeme_type::symbol_colon_equals);
+	REQUIRE(cursor.peek_lexeme(2).value == "b");
+	REQUIRE(cursor.peek_lexeme(4).value == "1");
+	REQUIRE(cursor.peek_type(5) == seam::lexer::lexeme_type::eof);
+	REQUIRE(cursor.peek_type(100) == seam::lexer::lexeme_type::eof);
+
+	for (auto i = 0; i < 10; ++i)
+	{
+		cursor.next_lexeme();
+	}
+	REQUIRE(cursor.current_lexeme().type == seam::lexer::lexeme_type::eof);
+}
+
+TEST_CASE("Line table", "[lexer]") {
+	const std::string source =
+		"a\n"
+		"\n"
+		"bc\n" + std::string(100, 'x') + "\n" + std::string(40, '\n') + "end";
+	const seam::utils::line_table lines{ source };
+
+	REQUIRE(lines.line_count() == 45);
+
+	REQUIRE(lines.resolve(0).line == 1);
+	REQUIRE(lines.resolve(0).column == 1);
+	REQUIRE(lines.resolve(1).line == 1);
+	REQUIRE(lines.resolve(1).column == 2);
+	REQUIRE(lines.resolve(2).line == 2);
+	REQUIRE(lines.resolve(4).line == 3);
+	REQUIRE(lines.resolve(4).column == 2);
+	REQUIRE(lines.resolve(106).line == 4);
+	REQUIRE(lines.resolve(106).column == 101);
+
+	const auto end = static_cast<std::uint32_t>(source.size() - 1);
+	REQUIRE(lines.resolve(end).line == 45);
+	REQUIRE(lines.resolve(end).column == 3);
+
+	seam::utils::source_map sources;
+	sources.add("first", "one");
+	const auto file_id = sources.add("second", source);
+	REQUIRE(sources.name(file_id) == "second");
+	REQUIRE(sources.resolve({ end, file_id }).line == 45);
+}
+
+TEST_CASE("Parallel tokenize matches serial", "[lexer]") {
+	// Chunk boundaries land inside strings and long comments, forcing chunks to be merged.
+	const std::vector<std::string_view> pieces = {
+		"fn main() {\n\tx := 1 + 2\n}\n",
+		"type point {\n\tx: i32\n}\n",
+		"extern fn puts(s: *u8) -> i32\n",
+		"\"string with\nfn inside\"\n",
+		"/// long comment\nfn inside ///\n",
+		"// line comment fn\n",
+		"fnord := 1\n",
+	};
+
+	seam::utils::thread_pool pool{ 4 };
+	std::mt19937 random{ GENERATE(1u, 2u, 3u, 4u, 5u) };
+	std::uniform_int_distribution<std::size_t> pick{ 0, pieces.size() - 1 };
+
+	std::string source;
+	for (auto i = 0; i < 200; ++i)
+	{
+		source += pieces[pick(random)];
+	}
+
+	const auto broken = GENERATE(false, true);
+	if (broken) // Leave a string open somewhere in the middle.
+	{
+		source.insert(source.size() / 2, "\nfn \"");
+	}
+
+	// Modules of their own, so symbol ids only match if both number them in the same order.
+	const auto tokenize = [&](seam::utils::thread_pool* chunk_pool)
+	{
+		seam::lexer::lexer lexer(std::make_shared<seam::types::module>("test"), source, 0, true);
+		return chunk_pool ? lexer.tokenize(*chunk_pool, 64) : lexer.tokenize();
+	};
+
+	std::optional<seam::lexer::token_buffer> serial;
+	std::optional<seam::utils::lexical_exception> serial_error;
+	try
+	{
+		serial = tokenize(nullptr);
+	}
+	catch (const seam::utils::lexical_exception& exception)
+	{
+		serial_error = exception;
+	}
+	REQUIRE(serial_error.has_value() == broken);
+
+	if (broken)
+	{
+		try
+		{
+			tokenize(&pool);
+			FAIL("parallel tokenize did not throw");
+		}
+		catch (const seam::utils::lexical_exception& exception)
+		{
+			REQUIRE(std::string{ exception.what() } == serial_error->what());
+			REQUIRE(exception.position.offset == serial_error->position.offset);
+		}
+		return;
+	}
+
+	const auto parallel = tokenize(&pool);
+	REQUIRE(parallel.types == serial->types);
+	REQUIRE(parallel.offsets == serial->offsets);
+	REQUIRE(parallel.lengths == serial->lengths);
+	REQUIRE(parallel.symbols == serial->symbols);
+	REQUIRE(parallel.numbers == serial->numbers);
+}
+
+TEST_CASE("Identifier interning", "[lexer]") {
+	const auto mode = GENERATE(lex_mode::streaming, lex_mode::batch);
+	const auto lexemes = lex_all("value fn other value @constructor", mode);
+
+	REQUIRE(lexemes[0].symbol != seam::utils::no_symbol);
+	REQUIRE(lexemes[0].symbol == lexemes[3].symbol);
+	REQUIRE(lexemes[0].symbol != lexemes[2].symbol);
+	REQUIRE(lexemes[1].symbol == seam::utils::no_symbol);
+	REQUIRE(lexemes[4].symbol == seam::utils::no_symbol);
+
+	for (const auto& lexeme : lex_all("value fn other value", mode, false))
+	{
+		REQUIRE(lexeme.symbol == seam::utils::no_symbol);
+	}
+
+	seam::utils::interner symbols;
+	const auto long_name = std::string(100000, 'x');
+	REQUIRE(symbols.intern("value") == symbols.intern(std::string{ "val" } + "ue"));
+	REQUIRE(symbols.name(symbols.intern(long_name)) == long_name);
+	REQUIRE(symbols.name(symbols.intern("")).empty());
+	REQUIRE(symbols.size() == 3);
+
+	// Threads interning overlapping names must agree on every id.
+	std::vector<std::vector<seam::utils::symbol_id>> ids(4);
+	std::vector<std::thread> threads;
+	for (auto& thread_ids : ids)
+	{
+		threads.emplace_back([&symbols, &thread_ids]
+		{
+			for (auto i = 0; i < 5000; ++i)
+			{
+				thread_ids.push_back(symbols.intern("name_" + std::to_string(i)));
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	for (const auto& thread_ids : ids)
+	{
+		REQUIRE(thread_ids == ids[0]);
+	}
+	REQUIRE(symbols.name(ids[0][1234]) == "name_1234");
+	REQUIRE(symbols.size() == 5003);
+}
+
+TEST_CASE("Type context", "[types]") {
+	using built_in_type = seam::ir::ast::type::built_in_type;
+	seam::types::type_context types;
+
+	const auto i8 = types.built_in(built_in_type::i8);
+	const auto i32 = types.built_in(built_in_type::i32);
+	const auto u16 = types.built_in(built_in_type::u16);
+	const auto f64 = types.built_in(built_in_type::f64);
+
+	REQUIRE(types.built_in(built_in_type::i32) == i32);
+	REQUIRE(i8 != i32);
+
+	REQUIRE(types.dominant(i8, i32) == i32);
+	REQUIRE(types.dominant(i32, i8) == i32);
+	REQUIRE(types.dominant(types.built_in(built_in_type::f32), f64) == f64);
+	REQUIRE(types.dominant(i32, u16) == nullptr);
+	REQUIRE(types.dominant(i32, f64) == nullptr);
+	REQUIRE(types.dominant(types.built_in(built_in_type::bool_), types.built_in(built_in_type::bool_)) == nullptr);
+}
+
+TEST_CASE("Flat tree round trip", "[ast]") {
+	const std::string source =
+		"extern print(text: string)\n"
+		"type number = i32\n"
+		"fn main() -> i32 @constructor\n"
+		"{\n"
+		"\ttotal := twice(3) + 4i32\n"
+		"\tif (total > 2) { print(\"big\") } else { small := -total }\n"
+		"\twhile (total < 10) { twice(total) }\n"
+		"\treturn total\n"
+		"}\n"
+		"fn twice(value: number) -> i32\n"
+		"{\n"
+		"\treturn value * 2\n"
+		"}\n";
+
+	const auto module = std::make_shared<seam::types::module>("test");
+	seam::parser::parser parser(module, 0, source);
+	module->body = parser.parse();
+
+	const auto flat = seam::ir::flat::flatten(module->body);
+	REQUIRE(flat.sizes[flat.root()] == flat.size());
+	REQUIRE(flat.kinds[flat.root()] == seam::ir::flat::node_kind::restricted_block);
+	REQUIRE(flat.child_count(flat.root()) == 4);
+	REQUIRE(flat.child(flat.root(), 3) == flat.root() - 1);
+	REQUIRE(flat.child(flat.root(), 4) == seam::ir::flat::no_node);
+	REQUIRE(flat.signatures.size() == 3);
+	REQUIRE(flat.strings.size() == 1);
+
+	const auto require_same = [](const seam::ir::flat::tree& a, const seam::ir::flat::tree& b)
+	{
+		REQUIRE(a.kinds == b.kinds);
+		REQUIRE(a.sizes == b.sizes);
+		REQUIRE(a.data == b.data);
+		REQUIRE(a.types == b.types);
+		REQUIRE(a.strings == b.strings);
+		REQUIRE(a.variables.size() == b.variables.size());
+		for (std::size_t i = 0; i < a.variables.size(); ++i)
+		{
+			REQUIRE(a.variables[i].name == b.variables[i].name);
+			REQUIRE(a.variables[i].type == b.variables[i].type);
+		}
+		for (std::size_t i = 0; i < a.size(); ++i)
+		{
+			REQUIRE(a.ranges[i].start.offset == b.ranges[i].start.offset);
+			REQUIRE(a.ranges[i].end.offset == b.ranges[i].end.offset);
+		}
+	};
+
+	SECTION("Pointer tree rebuilt from the flat tree flattens to the same tree") {
+		const auto rebuilt = seam::ir::flat::unflatten(flat, module->arena);
+		require_same(seam::ir::flat::flatten(rebuilt), flat);
+	}
+}
+
+TEST_CASE("Fused semantic pass matches separate passes", "[passes]") {
+	const std::string source =
+		"extern print(text: string)\n"
+		"fn main() -> i32\n"
+		"{\n"
+		"\ttotal := twice(3) + 4i32\n"
+		"\twide := total * 2i64\n"
+		"\tnegated := -wide\n"
+		"\twhile (total < 10) { print(\"loop\") }\n"
+		"\treturn twice(total)\n"
+		"}\n"
+		"fn twice(value: i32) -> i32\n"
+		"{\n"
+		"\treturn value * 2\n"
+		"}\n";
+
+	const auto parse = [&](const bool multi_pass)
+	{
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser(module, 0, source, nullptr, multi_pass);
+		module->body = parser.parse();
+		return std::make_pair(module, seam::ir::flat::flatten(module->body));
+	};
+
+	const auto fused_result = parse(false);
+	const auto separate_result = parse(true);
+	const auto& fused_module = fused_result.first;
+	const auto& fused = fused_result.second;
+	const auto& separate = separate_result.second;
+
+	// Flattening points resolved symbols at their signature, so equal data means equal resolution.
+	REQUIRE(fused.kinds == separate.kinds);
+	REQUIRE(fused.data == separate.data);
+
+	REQUIRE(fused.variables.size() == separate.variables.size());
+	for (std::size_t i = 0; i < fused.variables.size(); ++i)
+	{
+		using built_in_type = seam::ir::ast::type::built_in_type;
+		REQUIRE(std::get<built_in_type>(fused.variables[i].type->value) == std::get<built_in_type>(separate.variables[i].type->value));
+	}
+
+	const auto type_of = [&](const std::string_view name)
+	{
+		for (const auto& variable : fused.variables)
+		{
+			if (fused_module->symbols.name(variable.name) == name)
+			{
+				return variable.type;
+			}
+		}
+		return static_cast<seam::ir::ast::type*>(nullptr);
+	};
+
+	using built_in_type = seam::ir::ast::type::built_in_type;
+	REQUIRE(type_of("total") == fused_module->types.built_in(built_in_type::i32));
+	REQUIRE(type_of("wide") == fused_module->types.built_in(built_in_type::i64));
+	REQUIRE(type_of("negated") == fused_module->types.built_in(built_in_type::i64));
+
+	SECTION("Unknown functions are reported the same way") {
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser(module, 0, "fn main()\n{\n\tmissing()\n}\n");
+		REQUIRE_THROWS_WITH(parser.parse(), "cannot resolve symbol 'missing'");
+	}
+}
+
+TEST_CASE("Pass manager", "[passes]") {
+	using seam::parser::passes::pass_manager;
+
+	std::vector<std::string> ran;
+	pass_manager manager;
+	manager.add<recording_pass>("types", { "resolve" }, "types", ran);
+	manager.add<recording_pass>("collect", {}, "collect", ran);
+	manager.add<recording_pass>("resolve", { "collect" }, "resolve", ran);
+	manager.add<recording_pass>("lint", {}, "lint", ran);
+
+	SECTION("Passes run after their dependencies") {
+		seam::utils::statistics statistics;
+		manager.run(nullptr, &statistics);
+		REQUIRE(ran == std::vector<std::string>{ "collect", "resolve", "types", "lint" });
+
+		REQUIRE(statistics.records().size() == 4);
+		for (std::size_t i = 0; i < ran.size(); ++i)
+		{
+			REQUIRE(statistics.records()[i].name == ran[i]);
+			REQUIRE(statistics.records()[i].nodes == 0);
+		}
+
+		std::stringstream trace;
+		statistics.write_chrome_trace(trace);
+		REQUIRE(trace.str().find("\"name\":\"resolve\",\"cat\":\"pass\",\"ph\":\"X\"") != std::string::npos);
+	}
+
+	SECTION("Disabling a pass disables its dependents") {
+		manager.disable("collect");
+		manager.run(nullptr);
+		REQUIRE(ran == std::vector<std::string>{ "lint" });
+	}
+
+	SECTION("Unknown and cyclic dependencies are reported") {
+		REQUIRE_THROWS_WITH(manager.disable("missing"), "unknown pass 'missing'");
+		REQUIRE_THROWS_WITH(manager.add<recording_pass>("lint", {}, "lint", ran), "pass 'lint' was already added");
+
+		manager.add<recording_pass>("first", { "second" }, "first", ran);
+		manager.add<recording_pass>("second", { "first" }, "second", ran);
+		REQUIRE_THROWS_WITH(manager.run(nullptr), "dependencies of pass 'first' form a cycle");
+		REQUIRE(ran.empty());
+	}
+
+	SECTION("Parsing records lexing, parsing and every pass") {
+		seam::utils::statistics statistics;
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser(module, 0, "fn main()\n{\n\tvalue := 1 + 2\n}\n", nullptr, true, &statistics);
+		parser.parse();
+
+		std::vector<std::string> phases;
+		for (const auto& record : statistics.records())
+		{
+			phases.push_back(record.name);
+			REQUIRE((record.nodes > 0) == (record.category != "pass"));
+		}
+		REQUIRE(phases == std::vector<std::string>{ "lex", "parse", "function_collector", "function_resolver", "types" });
+	}
+
+	SECTION("Passes later stages rely on cannot be disabled") {
+		manager.require("types");
+		REQUIRE_THROWS_WITH(manager.disable("types"), "pass 'types' is required and cannot be disabled");
+
+		manager.disable("collect");
+		REQUIRE_THROWS_WITH(manager.run(nullptr), "pass 'types' is required, but a pass it depends on is disabled");
+		REQUIRE(ran.empty());
+
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser(module, 0, "fn main()\n{\n}\n", nullptr, true);
+		REQUIRE_THROWS_WITH(parser.passes().disable("function_resolver"),
+			"pass 'function_resolver' is required and cannot be disabled");
+		parser.passes().disable("function_collector");
+		REQUIRE_THROWS_WITH(parser.parse(), "pass 'function_resolver' is required, but a pass it depends on is disabled");
+	}
+}
+
+TEST_CASE("Thread pool", "[utils]") {
+	seam::utils::thread_pool pool{ 4 };
+
+	SECTION("Every task runs, including tasks queued by other tasks") {
+		std::atomic<std::size_t> sum{ 0 };
+		std::vector<std::future<void>> outer;
+		for (std::size_t i = 0; i < 64; ++i)
+		{
+			outer.push_back(pool.submit([&, i]()
+			{
+				sum += i;
+				pool.submit([&]() { sum += 1000; });
+			}));
+		}
+
+		for (auto& result : outer)
+		{
+			result.get();
+		}
+
+		// Nested tasks are not waited on, the pool finishes them before it is destroyed.
+		while (sum.load() != 64 * 1000 + 63 * 64 / 2)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	SECTION("Exceptions reach the future") {
+		auto result = pool.submit([]() -> int { throw std::runtime_error("task failed"); });
+		REQUIRE_THROWS_WITH(result.get(), "task failed");
+	}
+	SECTION("Tasks waiting on tasks they queued help instead of blocking") {
+		// With a single worker, a task blocking on its own nested tasks would never see them run.
+		seam::utils::thread_pool single{ 1 };
+		auto outer = single.submit([&]()
+		{
+			std::vector<std::future<std::size_t>> inner;
+			for (std::size_t i = 0; i < 8; ++i)
+			{
+				inner.push_back(single.submit([i]() { return i; }));
+			}
+
+			std::size_t sum = 0;
+			for (auto& result : inner)
+			{
+				single.wait(result);
+				sum += result.get();
+			}
+			return sum;
+		});
+
+		single.wait(outer);
+		REQUIRE(outer.get() == 28);
+	}
+}
+
+TEST_CASE("Parallel semantic analysis matches serial", "[passes]") {
+	std::string source = "extern print(text: string)\n";
+	for (auto i = 0; i < 40; ++i)
+	{
+		const auto name = "function_" + std::to_string(i);
+		const auto callee = "function_" + std::to_string((i * 7 + 3) % 40);
+		source += "fn " + name + "(value: i32) -> i32\n{\n";
+		source += "\tscaled := value * " + std::to_string(i + 1) + "i64\n";
+		source += "\twhile (value < 10) { " + callee + "(value) }\n";
+		source += "\tif (value == 3) { print(\"three\") } else { negated := -scaled }\n";
+		source += "\treturn " + callee + "(value)\n}\n";
+	}
+
+	const auto multi_pass = GENERATE(false, true);
+	seam::utils::thread_pool pool{ 4 };
+
+	const auto parse = [&](seam::utils::thread_pool* analysis_pool)
+	{
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser(module, 0, source, analysis_pool, multi_pass);
+		module->body = parser.parse();
+		return std::make_pair(module, seam::ir::flat::flatten(module->body));
+	};
+
+	const auto serial = parse(nullptr);
+	const auto parallel = parse(&pool);
+	REQUIRE_FALSE(parallel.first->task_arenas.empty());
+
+	REQUIRE(parallel.second.kinds == serial.second.kinds);
+	REQUIRE(parallel.second.data == serial.second.data);
+	REQUIRE(parallel.second.variables.size() == serial.second.variables.size());
+	for (std::size_t i = 0; i < serial.second.variables.size(); ++i)
+	{
+		using built_in_type = seam::ir::ast::type::built_in_type;
+		REQUIRE(std::get<built_in_type>(parallel.second.variables[i].type->value)
+			== std::get<built_in_type>(serial.second.variables[i].type->value));
+	}
+
+	SECTION("Every error is reported in source order whatever the schedule") {
+		std::string broken;
+		for (auto i = 0; i < 40; ++i)
+		{
+			broken += "fn function_" + std::to_string(i) + "()\n{\n";
+			broken += i % 10 == 5 ? "\tmissing_" + std::to_string(i) + "()\n}\n" : "\tfunction_0()\n}\n";
+		}
+
+		for (auto i = 0; i < 10; ++i)
+		{
+			const auto module = std::make_shared<seam::types::module>("test");
+			seam::parser::parser parser(module, 0, broken, &pool, multi_pass);
+			try
+			{
+				parser.parse();
+				FAIL("every function calling a missing function should fail");
+			}
+			catch (const seam::utils::exception_list& ex)
+			{
+				REQUIRE(ex.errors.size() == 4);
+				for (std::size_t error = 0; error < ex.errors.size(); ++error)
+				{
+					REQUIRE(std::string{ ex.errors[error].what() } == "cannot resolve symbol 'missing_" + std::to_string(error * 10 + 5) + "'");
+				}
+			}
+
+			// Arenas of earlier walks are reused rather than added to on every run.
+			const auto arenas = module->task_arenas.size();
+			seam::parser::parser again(module, 0, broken, &pool, multi_pass);
+			REQUIRE_THROWS_AS(again.parse(), seam::utils::exception_list);
+			REQUIRE(module->task_arenas.size() == arenas);
+		}
+	}
+}
+
+TEST_CASE("Function dependencies", "[passes]") {
+	const std::string source =
+		"extern record(value: i32)\n"
+		"fn leaf() -> i32\n{\n\treturn 7i32\n}\n"
+		"fn middle() -> i32\n{\n\treturn leaf() + leaf()\n}\n"
+		"fn top() @constructor\n{\n\trecord(middle())\n\trecord(leaf())\n}\n";
+
+	const auto multi_pass = GENERATE(false, true);
+	const auto parallel = GENERATE(false, true);
+	seam::utils::thread_pool pool{ 4 };
+
+	const auto module = std::make_shared<seam::types::module>("test");
+	seam::parser::parser parser(module, 0, source, parallel ? &pool : nullptr, multi_pass);
+	module->body = parser.parse();
+
+	std::map<std::string, std::set<std::string>> dependencies;
+	for (const auto statement : module->body->body)
+	{
+		if (const auto func = dynamic_cast<seam::ir::ast::statement::function_definition*>(statement))
+		{
+			auto& callees = dependencies[std::string{ module->symbols.name(func->signature->name) }];
+			for (const auto callee : func->function_dependencies)
+			{
+				callees.emplace(module->symbols.name(callee->name));
+			}
+		}
+	}
+
+	REQUIRE(dependencies == std::map<std::string, std::set<std::string>>{
+		{ "leaf", {} },
+		{ "middle", { "leaf" } },
+		{ "top", { "leaf", "middle", "record" } } });
+}
+
+TEST_CASE("Parallel code generation matches serial", "[codegen]") {
+	std::string source = "extern print(value: i32)\n";
+	for (auto i = 0; i < 40; ++i)
+	{
+		const auto callee = "function_" + std::to_string((i * 7 + 3) % 40);
+		source += "fn function_" + std::to_string(i) + "(value: i32) -> i32\n{\n";
+		source += "\tx: i32 = " + callee + "(" + std::to_string(i) + "i32)\n";
+		source += "\tif (true) { print(" + std::to_string(i) + "i32) } else { y: i32 = 4i32 }\n";
+		source += "\twhile (false) { print(" + std::to_string(i) + "i32) }\n";
+		source += "\treturn x\n}\n";
+	}
+
+	const auto generate = [&](seam::utils::thread_pool* pool)
+	{
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser(module, 0, source);
+		module->body = parser.parse();
+
+		seam::code_generation::code_generation generator{ module.get(), nullptr, pool, 8 };
+		const auto llvm_module = generator.generate();
+		REQUIRE_FALSE(llvm::verifyModule(*llvm_module, &llvm::errs()));
+
+		std::string ir;
+		llvm::raw_string_ostream stream{ ir };
+		llvm_module->print(stream, nullptr);
+		return stream.str();
+	};
+
+	seam::utils::thread_pool two{ 2 };
+	seam::utils::thread_pool four{ 4 };
+
+	const auto serial = generate(nullptr);
+	REQUIRE(generate(&two) == serial);
+	REQUIRE(generate(&four) == serial);
+
+	SECTION("Generating from a task of the pool runs the partitions instead of waiting on them") {
+		// The only worker generates, so nothing else would be left to compile its partitions.
+		seam::utils::thread_pool one{ 1 };
+		auto generated = one.submit([&]()
+		{
+			const auto module = std::make_shared<seam::types::module>("test");
+			seam::parser::parser parser(module, 0, source);
+			module->body = parser.parse();
+
+			seam::code_generation::code_generation generator{ module.get(), nullptr, &one, 8 };
+			std::string ir;
+			llvm::raw_string_ostream stream{ ir };
+			generator.generate()->print(stream, nullptr);
+			return stream.str();
+		});
+
+		REQUIRE(generated.get() == serial);
+	}
+
+	SECTION("Partitions are the same whatever the number of threads") {
+		const auto generate_partitions = [&](seam::utils::thread_pool* pool)
+		{
+			const auto module = std::make_shared<seam::types::module>("test");
+			seam::parser::parser parser(module, 0, source);
+			module->body = parser.parse();
+
+			seam::code_generation::code_generation generator{ module.get(), nullptr, pool, 8 };
+			std::vector<std::string> partitions;
+			for (const auto& partition : generator.generate_partitions())
+			{
+				REQUIRE_FALSE(llvm::verifyModule(*partition.module, &llvm::errs()));
+
+				std::string ir;
+				llvm::raw_string_ostream stream{ ir };
+				partition.module->print(stream, nullptr);
+				partitions.push_back(stream.str());
+			}
+			return partitions;
+		};
+
+		const auto partitions = generate_partitions(nullptr);
+		REQUIRE(partitions.size() == 40 / 8 + 1);
+		REQUIRE(generate_partitions(&two) == partitions);
+		REQUIRE(generate_partitions(&four) == partitions);
+	}
+}
+
+TEST_CASE("Object emission", "[codegen]") {
+	const std::string source =
+		"extern print(value: i32)\n"
+		"fn answer() -> i32\n{\n\tprint(42i32)\n\tresult: i32 = 42i32\n\treturn result\n}\n";
+
+	const auto module = std::make_shared<seam::types::module>("test");
+	seam::parser::parser parser(module, 0, source);
+	module->body = parser.parse();
+
+	seam::code_generation::code_generation generator{ module.get() };
+	const auto llvm_module = generator.generate();
+	REQUIRE_FALSE(llvm_module->getTargetTriple().empty());
+
+	const auto emit = [&](const llvm::CodeGenFileType file_type)
+	{
+		llvm::SmallVector<char, 0> output;
+		llvm::raw_svector_ostream stream{ output };
+		generator.emit(*llvm_module, stream, file_type);
+		return std::string{ output.data(), output.size() };
+	};
+
+	const auto object = emit(llvm::CGFT_ObjectFile);
+	REQUIRE_FALSE(object.empty());
+	REQUIRE(emit(llvm::CGFT_ObjectFile) == object);
+
+	const auto assembly = emit(llvm::CGFT_AssemblyFile);
+	REQUIRE(assembly.find("test@answer") != std::string::npos);
+	REQUIRE(assembly.find("print") != std::string::npos);
+}
+
+TEST_CASE("Optimization levels", "[codegen]") {
+	const std::string source =
+		"extern consume(value: i32)\n"
+		"fn sum() -> i32\n{\n\ttotal: i32 = 0i32\n\ti: i32 = 0i32\n"
+		"\twhile (i < 10i32)\n\t{\n\t\ttotal = total + i\n\t\ti = i + 1i32\n\t}\n\treturn total\n}\n"
+		"fn main() @constructor\n{\n\tconsume(sum())\n}\n";
+
+	const auto generate = [&](const seam::code_generation::optimization_level level)
+	{
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser(module, 0, source);
+		module->body = parser.parse();
+
+		seam::code_generation::code_generation generator{ module.get(), nullptr, nullptr,
+			seam::code_generation::code_generation::default_partition_size, level };
+		const auto llvm_module = generator.generate();
+		REQUIRE_FALSE(llvm::verifyModule(*llvm_module, &llvm::errs()));
+
+		std::string ir;
+		llvm::raw_string_ostream stream{ ir };
+		llvm_module->print(stream, nullptr);
+		return stream.str();
+	};
+
+	SECTION("Locals stay in memory without optimisation") {
+		const auto ir = generate(seam::code_generation::optimization_level::o0);
+		REQUIRE(ir.find("alloca") != std::string::npos);
+	}
+
+	SECTION("The loop is folded into the call with optimisation") {
+		for (const auto level : { seam::code_generation::optimization_level::o1, seam::code_generation::optimization_level::o2,
+			seam::code_generation::optimization_level::o3, seam::code_generation::optimization_level::os })
+		{
+			const auto ir = generate(level);
+			REQUIRE(ir.find("alloca") == std::string::npos);
+			REQUIRE(ir.find("call void @consume(i32 45)") != std::string::npos);
+		}
+	}
+
+	SECTION("Only declared variables can be assigned") {
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser(module, 0, "fn f()\n{\n\tmissing = 1i32\n}\n");
+		REQUIRE_THROWS_WITH(parser.parse(), "cannot assign non-existent variable missing");
+	}
+
+	SECTION("Only variables can be assigned to") {
+		for (const auto target : { "f()", "(value)", "value + 1i32" })
+		{
+			const auto source = std::string{ "fn f() -> i32\n{\n\treturn 1i32\n}\nfn g(value: i32)\n{\n\t" } + target + " = 2i32\n}\n";
+			const auto module = std::make_shared<seam::types::module>("test");
+			seam::parser::parser parser(module, 0, source);
+			REQUIRE_THROWS_WITH(parser.parse(), "cannot assign to an expression which is not a variable");
+		}
+	}
+
+	SECTION("Functions returning a value return it on every path") {
+		const auto generate_function = [](const std::string& function_source)
+		{
+			const auto module = std::make_shared<seam::types::module>("test");
+			seam::parser::parser parser(module, 0, function_source);
+			module->body = parser.parse();
+
+			seam::code_generation::code_generation generator{ module.get() };
+			return generator.generate();
+		};
+
+		REQUIRE_THROWS_WITH(generate_function("fn f(v: i32) -> i32\n{\n\tif (v < 1i32)\n\t{\n\t\treturn 1i32\n\t}\n}\n"),
+			"function 'f' does not return a value on every path");
+		REQUIRE_NOTHROW(generate_function(
+			"fn f(v: i32) -> i32\n{\n\tif (v < 1i32)\n\t{\n\t\treturn 1i32\n\t}\n\telse\n\t{\n\t\treturn 2i32\n\t}\n}\n"));
+	}
+}
+
+TEST_CASE("Local storage", "[codegen]") {
+	using seam::code_generation::local_storage;
+	using seam::code_generation::optimization_level;
+
+	const std::string source =
+		"extern consume(value: i32)\n"
+		"fn sum(limit: i32) -> i32\n{\n\ttotal: i32 = 0i32\n\ti: i32 = 0i32\n"
+		"\twhile (i < limit)\n\t{\n"
+		"\t\tj: i32 = 0i32\n\t\twhile (j < i)\n\t\t{\n\t\t\tj = j + 1i32\n\t\t}\n"
+		"\t\tif (j > 5i32)\n\t\t{\n\t\t\ttotal = total + j\n\t\t}\n\t\telse\n\t\t{\n\t\t\ttotal = total - 1i32\n\t\t}\n"
+		"\t\ti = i + 1i32\n\t}\n\treturn total\n}\n"
+		"fn main() @constructor\n{\n\tconsume(sum(10i32))\n}\n";
+
+	const auto generate = [&](const local_storage locals, const optimization_level level, const auto& check)
+	{
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser(module, 0, source);
+		module->body = parser.parse();
+
+		seam::code_generation::code_generation generator{ module.get(), nullptr, nullptr,
+			seam::code_generation::code_generation::default_partition_size, level, locals };
+		const auto llvm_module = generator.generate();
+		REQUIRE_FALSE(llvm::verifyModule(*llvm_module, &llvm::errs()));
+		check(*llvm_module);
+	};
+
+	const auto count = [](const llvm::Function& function, const unsigned opcode)
+	{
+		std::size_t instructions = 0;
+		for (const auto& block : function)
+		{
+			for (const auto& instruction : block)
+			{
+				instructions += instruction.getOpcode() == opcode;
+			}
+		}
+		return instructions;
+	};
+
+	SECTION("Variables read before they are assigned are reported") {
+		for (const auto locals : { local_storage::stack, local_storage::ssa })
+		{
+			const auto module = std::make_shared<seam::types::module>("test");
+			seam::parser::parser parser(module, 0, "fn f() -> i32\n{\n\tvalue := 1i32\n\treturn value\n}\n");
+			module->body = parser.parse();
+
+			// The parser only lets variables be read once declared, so swap the statements by hand.
+			const auto function = static_cast<seam::ir::ast::statement::function_definition*>(module->body->body.front());
+			std::swap(function->body->body[0], function->body->body[1]);
+
+			seam::code_generation::code_generation generator{ module.get(), nullptr, nullptr,
+				seam::code_generation::code_generation::default_partition_size, optimization_level::o0, locals };
+			REQUIRE_THROWS_WITH(generator.generate(), "variable used before it is defined");
+		}
+	}
+
+	SECTION("Stack slots are allocated once each, in the entry block") {
+		generate(local_storage::stack, optimization_level::o0, [&](const llvm::Module& llvm_module)
+		{
+			const auto& function = *llvm_module.getFunction("test@sum");
+			REQUIRE(count(function, llvm::Instruction::Alloca) == 4); // limit, total, i and j
+
+			auto instruction = function.getEntryBlock().begin();
+			for (auto i = 0; i < 4; ++i)
+			{
+				REQUIRE((instruction++)->getOpcode() == llvm::Instruction::Alloca);
+			}
+			REQUIRE(count(function, llvm::Instruction::PHI) == 0);
+		});
+	}
+
+	SECTION("SSA construction keeps locals in registers without optimisation") {
+		generate(local_storage::ssa, optimization_level::o0, [&](const llvm::Module& llvm_module)
+		{
+			const auto& function = *llvm_module.getFunction("test@sum");
+			REQUIRE(count(function, llvm::Instruction::Alloca) == 0);
+			REQUIRE(count(function, llvm::Instruction::Load) == 0);
+			REQUIRE(count(function, llvm::Instruction::Store) == 0);
+			REQUIRE(count(function, llvm::Instruction::PHI) == 4); // total and i in the outer loop, j in the inner, total after the if
+		});
+	}
+
+	SECTION("Both storages compute the same result") {
+		for (const auto locals : { local_storage::stack, local_storage::ssa })
+		{
+			generate(locals, optimization_level::o2, [&](const llvm::Module& llvm_module)
+			{
+				std::string ir;
+				llvm::raw_string_ostream stream{ ir };
+				llvm_module.print(stream, nullptr);
+				REQUIRE(stream.str().find("call void @consume(i32 24)") != std::string::npos);
+			});
+		}
+	}
+}
+
+TEST_CASE("JIT execution", "[codegen]") {
+	const std::string source =
+		"extern record(value: i32)\n"
+		"extern missing(value: i32)\n"
+		"fn square(n: i32) -> i32\n{\n\treturn n * n\n}\n"
+		"fn never_called()\n{\n\tmissing(1i32)\n}\n"
+		"fn first() @constructor\n{\n\trecord(square(7i32))\n}\n"
+		"fn second() @constructor\n{\n\ti: i32 = 0i32\n\twhile (i < 3i32)\n\t{\n\t\trecord(i)\n\t\ti = i + 1i32\n\t}\n}\n";
+
+	static std::vector<std::int32_t> recorded;
+	recorded.clear();
+
+	const auto module = std::make_shared<seam::types::module>("test");
+	seam::parser::parser parser(module, 0, source);
+	module->body = parser.parse();
+
+	seam::code_generation::code_generation generator{ module.get() };
+	generator.generate();
+
+	const auto record = +[](const std::int32_t value) { recorded.push_back(value); };
+
+	SECTION("Functions are compiled when first called, so those never called need not resolve") {
+		seam::code_generation::jit engine{ seam::code_generation::optimization_level::o0, true };
+		engine.define("record", reinterpret_cast<void*>(record));
+		engine.add(generator.release());
+		engine.run();
+
+		REQUIRE(recorded == std::vector<std::int32_t>{ 49, 0, 1, 2 });
+	}
+
+	SECTION("Eagerly compiled modules run the same") {
+		seam::code_generation::jit engine{ seam::code_generation::optimization_level::o2, false };
+		engine.define("record", reinterpret_cast<void*>(record));
+		engine.define("missing", reinterpret_cast<void*>(record));
+		engine.add(generator.release());
+		engine.run();
+
+		REQUIRE(recorded == std::vector<std::int32_t>{ 49, 0, 1, 2 });
+	}
+}
+
+TEST_CASE("Compilation cache", "[codegen]") {
+	using seam::code_generation::optimization_level;
+
+	llvm::SmallString<128> directory;
+	REQUIRE_FALSE(llvm::sys::fs::createUniqueDirectory("seam-cache-test", directory));
+	seam::code_generation::compilation_cache cache{ directory.str().str() };
+
+	const std::string source =
+		"extern record(value: i32)\n"
+		"fn helper() -> i32\n{\n\treturn 7i32\n}\n"
+		"fn user()\n{\n\thelper()\n}\n"
+		"fn first() @constructor\n{\n\tvalue: i32 = 2i32\n\trecord(value * 3i32)\n}\n";
+
+	const auto parse = [](const std::string& text)
+	{
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser(module, 0, text);
+		module->body = parser.parse();
+		return module;
+	};
+
+	// Returns how many functions were found in the cache.
+	const auto cached_functions = [&](const std::string& text, const optimization_level level = optimization_level::o0)
+	{
+		const auto module = parse(text);
+		seam::code_generation::code_generation generator{ module.get(), nullptr, nullptr,
+			seam::code_generation::code_generation::default_partition_size, level };
+
+		const auto hits = cache.hits();
+		REQUIRE(generator.generate_objects(&cache).size() == 4); // three functions and the entry function
+		return cache.hits() - hits;
+	};
+
+	REQUIRE(cached_functions(source) == 0);
+	REQUIRE(cached_functions(source) == 3);
+
+	SECTION("Positions and variable names do not change keys") {
+		auto moved = source;
+		moved.insert(moved.find("fn first"), "\n\n\n");
+		moved.replace(moved.find("value: i32 = "), 5, "other");
+		moved.replace(moved.find("value * 3i32"), 5, "other");
+		REQUIRE(cached_functions(moved) == 3);
+	}
+
+	SECTION("Only changed functions and their callers are compiled again") {
+		auto changed_body = source;
+		changed_body.replace(changed_body.find("3i32"), 4, "4i32");
+		REQUIRE(cached_functions(changed_body) == 2);
+
+		auto changed_signature = source;
+		changed_signature.replace(changed_signature.find("-> i32\n{\n\treturn 7i32"), 21, "-> i64\n{\n\treturn 7i64");
+		REQUIRE(cached_functions(changed_signature) == 1);
+	}
+
+	SECTION("Options change keys") {
+		REQUIRE(cached_functions(source, optimization_level::o2) == 0);
+		REQUIRE(cached_functions(source, optimization_level::o2) == 3);
+	}
+
+	SECTION("Module keys change with the signatures of dependencies, not their bodies") {
+		const auto module_key = [&](const std::string& dependency, const llvm::CodeGenFileType file_type = llvm::CGFT_ObjectFile)
+		{
+			const auto module = parse(source);
+			module->dependencies.push_back(parse(dependency));
+
+			seam::code_generation::code_generation generator{ module.get() };
+			return generator.module_cache_key(source, file_type);
+		};
+
+		const auto key = module_key("fn exported() -> i32\n{\n\treturn 1i32\n}\n");
+		REQUIRE(module_key("fn exported() -> i32\n{\n\treturn 1i32\n}\n") == key);
+		REQUIRE(module_key("fn exported() -> i32\n{\n\treturn 2i32\n}\n") == key);
+		REQUIRE(module_key("fn exported() -> i64\n{\n\treturn 1i64\n}\n") != key);
+		REQUIRE(module_key("fn exported() -> i32\n{\n\treturn 1i32\n}\n", llvm::CGFT_AssemblyFile) != key);
+	}
+
+	SECTION("Cached objects run") {
+		static std::vector<std::int32_t> recorded;
+		recorded.clear();
+
+		const auto module = parse(source);
+		seam::code_generation::code_generation generator{ module.get() };
+		seam::code_generation::jit engine;
+		engine.define("record", reinterpret_cast<void*>(+[](const std::int32_t value) { recorded.push_back(value); }));
+		for (auto& object : generator.generate_objects(&cache))
+		{
+			engine.add_object(std::move(object));
+		}
+		engine.run();
+
+		REQUIRE(recorded == std::vector<std::int32_t>{ 6 });
+	}
+
+	llvm::sys::fs::remove_directories(directory);
+}
+
+TEST_CASE("Incremental compilation", "[codegen]") {
+	using seam::code_generation::dependency_graph;
+	using seam::code_generation::optimization_level;
+
+	llvm::SmallString<128> directory;
+	REQUIRE_FALSE(llvm::sys::fs::createUniqueDirectory("seam-incremental-test", directory));
+	seam::code_generation::compilation_cache cache{ directory.str().str() };
+
+	const std::string source =
+		"extern record(value: i32)\n"
+		"fn leaf() -> i32\n{\n\treturn 7i32\n}\n"
+		"fn middle() -> i32\n{\n\treturn leaf() + leaf()\n}\n"
+		"fn top() @constructor\n{\n\tvalue := middle()\n\trecord(value)\n\trecord(leaf())\n}\n";
+
+	static std::vector<std::int32_t> recorded;
+
+	// Compiles and runs the source as the driver does with a cache and the JIT, returning the functions compiled again.
+	const auto build = [&](const std::string& text, const optimization_level level = optimization_level::o0)
+	{
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser(module, 0, text);
+		seam::code_generation::code_generation generator{ module.get(), nullptr, nullptr,
+			seam::code_generation::code_generation::default_partition_size, level };
+
+		const auto entry = cache.load(dependency_graph::cache_entry(module->name));
+		auto graph = entry ? dependency_graph::read(entry->getBuffer()) : dependency_graph{};
+
+		module->body = parser.parse_syntax();
+		seam::code_generation::function_keys keys;
+		const auto changed = graph.update(module->body, text, module->symbols, generator.configuration_key(), cache, keys);
+		parser.analyse(module->body, changed);
+
+		seam::code_generation::jit engine;
+		engine.define("record", reinterpret_cast<void*>(+[](const std::int32_t value) { recorded.push_back(value); }));
+		for (auto& object : generator.generate_objects(&cache, &keys))
+		{
+			engine.add_object(std::move(object));
+		}
+
+		graph.record(changed, module->symbols, keys);
+		cache.store(dependency_graph::cache_entry(module->name), graph.write());
+
+		recorded.clear();
+		engine.run();
+
+		std::vector<std::string> names;
+		for (const auto func : changed)
+		{
+			names.emplace_back(module->symbols.name(func->signature->name));
+		}
+		return names;
+	};
+
+	using names = std::vector<std::string>;
+	REQUIRE(build(source) == names{ "leaf", "middle", "top" });
+	REQUIRE(recorded == std::vector<std::int32_t>{ 14, 7 });
+	REQUIRE(build(source).empty());
+	REQUIRE(recorded == std::vector<std::int32_t>{ 14, 7 });
+
+	SECTION("Changed bodies are compiled again by themselves") {
+		auto changed_body = source;
+		changed_body.replace(changed_body.find("7i32"), 4, "8i32");
+		REQUIRE(build(changed_body) == names{ "leaf" });
+		REQUIRE(recorded == std::vector<std::int32_t>{ 16, 8 });
+	}
+
+	SECTION("Callers of changed signatures are compiled again") {
+		auto changed_signature = source;
+		changed_signature.replace(changed_signature.find("fn leaf() -> i32"), 16, "fn leaf() -> i32 @export");
+		REQUIRE(build(changed_signature) == names{ "leaf", "middle", "top" });
+		REQUIRE(recorded == std::vector<std::int32_t>{ 14, 7 });
+	}
+
+	SECTION("Blank lines between functions change nothing") {
+		auto moved = source;
+		moved.insert(moved.find("fn middle"), "\n\n\n");
+		REQUIRE(build(moved).empty());
+	}
+
+	SECTION("Renamed variables are compiled again, and found in the cache") {
+		auto renamed = source;
+		renamed.replace(renamed.find("value := "), 5, "other");
+		renamed.replace(renamed.find("record(value)"), 13, "record(other)");
+
+		const auto hits = cache.hits();
+		REQUIRE(build(renamed) == names{ "top" });
+		REQUIRE(cache.hits() - hits == 4); // the graph and every function
+	}
+
+	SECTION("Callers of removed functions are compiled again, and report the error") {
+		auto removed = source;
+		removed.erase(removed.find("fn leaf"), removed.find("fn middle") - removed.find("fn leaf"));
+		REQUIRE_THROWS_WITH(build(removed), "cannot resolve symbol 'leaf'");
+	}
+
+	SECTION("Everything is compiled again with other options") {
+		REQUIRE(build(source, optimization_level::o2) == names{ "leaf", "middle", "top" });
+		REQUIRE(build(source, optimization_level::o2).empty());
+	}
+
+	SECTION("Damaged graphs are ignored") {
+		cache.store(dependency_graph::cache_entry("test"), "function\tdamaged");
+		REQUIRE(build(source) == names{ "leaf", "middle", "top" });
+	}
+
+	llvm::sys::fs::remove_directories(directory);
+}
+
+TEST_CASE("Build scheduling", "[build]") {
+	std::vector<std::pair<std::string, std::string>> sources = {
+		{ "app", "import maths\nimport io\nfn main() @constructor\n{\n\tshow(double(3i32))\n}\n" },
+		{ "maths", "extern record(value: i32)\nfn double(value: i32) -> i32 @export\n{\n\treturn value + value\n}\n"
+			"fn init() @constructor\n{\n\trecord(100i32)\n}\n" },
+		{ "io", "extern record(value: i32)\nfn show(value: i32) @export\n{\n\trecord(value)\n}\n"
+			"fn init() @constructor\n{\n\trecord(200i32)\n}\n" },
+	};
+
+	// Builds the sources on two threads, returning how the build ran, the IR of every module and the modules themselves.
+	const auto build = [&]()
+	{
+		std::vector<seam::build::source_file> files;
+		for (std::size_t i = 0; i < sources.size(); ++i)
+		{
+			files.push_back({ std::make_shared<seam::types::module>(sources[i].first), static_cast<std::uint32_t>(i), sources[i].second });
+		}
+
+		std::mutex mutex;
+		std::map<std::string, std::string> generated;
+		std::map<std::string, seam::code_generation::partition> released;
+		const auto generate = [&](seam::types::module& module)
+		{
+			seam::code_generation::code_generation generator{ &module, nullptr, nullptr,
+				seam::code_generation::code_generation::default_partition_size, seam::code_generation::optimization_level::o0,
+				seam::code_generation::local_storage::stack, false };
+			const auto llvm_module = generator.generate();
+
+			std::string ir;
+			llvm::raw_string_ostream stream{ ir };
+			llvm_module->print(stream, nullptr);
+			if (llvm::verifyModule(*llvm_module, &stream))
+			{
+				stream << "broken module";
+			}
+
+			std::lock_guard lock{ mutex };
+			generated.emplace(module.name, stream.str());
+			released.emplace(module.name, generator.release());
+		};
+
+		seam::utils::thread_pool pool{ 2 };
+		seam::build::scheduler scheduler{ pool };
+		auto report = scheduler.build(files, generate);
+		return std::make_tuple(std::move(report), std::move(generated), std::move(released));
+	};
+
+	SECTION("Modules are compiled once the modules they import are parsed") {
+		const auto [report, generated, released] = build();
+		REQUIRE(report.modules == std::vector<std::string>{ "app", "maths", "io" });
+		REQUIRE(report.dependencies == std::vector<std::vector<std::size_t>>{ { 1, 2 }, {}, {} });
+		REQUIRE(report.tasks.size() == 6);
+
+		const auto find = [&](const std::size_t module, const seam::build::stage stage)
+		{
+			return *std::find_if(report.tasks.cbegin(), report.tasks.cend(), [&](const seam::build::task& task)
+			{
+				return task.module == module && task.stage == stage;
+			});
+		};
+		const auto compile_app = find(0, seam::build::stage::compile);
+		for (std::size_t module = 0; module < 3; ++module)
+		{
+			const auto parse = find(module, seam::build::stage::parse);
+			REQUIRE(parse.start + parse.duration <= compile_app.start);
+		}
+
+		// Exported functions keep their names, so importing modules call them by it.
+		REQUIRE(generated.size() == 3);
+		REQUIRE(generated.at("maths").find("define i32 @double(") != std::string::npos);
+		REQUIRE(generated.at("io").find("define void @show(") != std::string::npos);
+		REQUIRE(generated.at("app").find("declare i32 @double(") != std::string::npos);
+		REQUIRE(generated.at("app").find("call void @show(") != std::string::npos);
+		for (const auto& [name, ir] : generated)
+		{
+			REQUIRE(ir.find("broken module") == std::string::npos);
+		}
+	}
+
+	SECTION("Modules link into a program which runs the constructors of imported modules first") {
+		auto [report, generated, released] = build();
+		REQUIRE(report.initialization_order() == std::vector<std::size_t>{ 1, 2, 0 });
+
+		std::vector<std::string> order;
+		for (const auto index : report.initialization_order())
+		{
+			order.push_back(report.modules[index]);
+		}
+
+		seam::types::module program{ "entry" };
+		seam::code_generation::code_generation generator{ &program };
+		generator.generate_program_entry(order);
+		released.emplace(program.name, generator.release());
+
+		// Every module defines an entry function of its own, and only the program defines the entry it starts from.
+		std::multiset<std::string> defined;
+		for (const auto& [name, generated_module] : released)
+		{
+			for (const auto& func : *generated_module.module)
+			{
+				if (!func.isDeclaration() && !func.hasLocalLinkage())
+				{
+					defined.insert(func.getName().str());
+				}
+			}
+		}
+		REQUIRE(defined == std::multiset<std::string>{ "app@entry", "double", "entry", "io@entry", "maths@entry", "show" });
+
+		static std::vector<std::int32_t> recorded;
+		recorded.clear();
+
+		// Compiled eagerly, so a symbol defined twice fails as the modules are added.
+		seam::code_generation::jit engine{ seam::code_generation::optimization_level::o0, false };
+		engine.define("record", reinterpret_cast<void*>(+[](const std::int32_t value) { recorded.push_back(value); }));
+		for (auto& [name, generated_module] : released)
+		{
+			engine.add(std::move(generated_module));
+		}
+		engine.run();
+
+		REQUIRE(recorded == std::vector<std::int32_t>{ 100, 200, 6 });
+	}
+
+	SECTION("Functions cannot take the name of entry functions") {
+		sources[1].second += "fn entry()\n{\n}\n";
+		REQUIRE_THROWS_WITH(build(), "function name 'entry' is reserved for entry functions");
+	}
+
+	SECTION("Modules which are not built are reported") {
+		sources[0].second.replace(sources[0].second.find("io"), 2, "missing");
+		REQUIRE_THROWS_WITH(build(), "cannot find module 'missing'");
+	}
+
+	SECTION("Functions which are not exported cannot be called") {
+		sources[1].second.erase(sources[1].second.find(" @export"), 8);
+		REQUIRE_THROWS_WITH(build(), "cannot resolve symbol 'double'");
+	}
+
+	SECTION("Every module which fails is reported, in the order of the sources") {
+		sources[1].second += "fn broken()\n{\n\tmissing_maths()\n}\n";
+		sources[2].second += "fn broken()\n{\n\tmissing_io()\n}\n";
+		try
+		{
+			build();
+			FAIL("both modules should fail");
+		}
+		catch (const seam::utils::exception_list& ex)
+		{
+			// app imports both, so it is never compiled and has nothing to report.
+			REQUIRE(ex.errors.size() == 2);
+			REQUIRE(std::string{ ex.errors[0].what() } == "cannot resolve symbol 'missing_maths'");
+			REQUIRE(std::string{ ex.errors[1].what() } == "cannot resolve symbol 'missing_io'");
+		}
+	}
+
+	SECTION("Imports cannot form a cycle") {
+		sources[2].second.insert(0, "import app\n");
+		REQUIRE_THROWS_WITH(build(), Catch::Contains("cannot import module") && Catch::Contains("as it imports"));
+	}
+
+	SECTION("Modules cannot share a name") {
+		sources[2].first = "maths";
+		REQUIRE_THROWS_WITH(build(), "more than one source is module 'maths'");
+	}
+
+	SECTION("Single modules report imports too") {
+		const auto module = std::make_shared<seam::types::module>("app");
+		seam::parser::parser parser(module, 0, sources[0].second);
+		REQUIRE_THROWS_WITH(parser.parse(), "cannot find module 'maths'");
+	}
+}
+
+TEST_CASE("Build report", "[build]") {
+	using seam::build::stage;
+
+	seam::build::report report;
+	report.modules = { "a", "b", "c" };
+	report.dependencies = { {}, { 0 }, { 0, 1 } };
+	report.tasks = {
+		{ 0, stage::parse, 0.000, 0.002, 0 },
+		{ 1, stage::parse, 0.000, 0.001, 1 },
+		{ 2, stage::parse, 0.001, 0.001, 1 },
+		{ 0, stage::compile, 0.002, 0.003, 0 },
+		{ 1, stage::compile, 0.002, 0.004, 1 },
+		{ 2, stage::compile, 0.006, 0.001, 1 },
+	};
+	report.workers = 2;
+	report.duration = 0.010;
+
+	// Compiling c, which finished last, waited on its worker compiling b, which waited on parsing a, the last parse it needs.
+	const auto path = report.critical_path();
+	REQUIRE(path.size() == 3);
+	REQUIRE((path[0].module == 0 && path[0].stage == stage::parse));
+	REQUIRE((path[1].module == 1 && path[1].stage == stage::compile));
+	REQUIRE((path[2].module == 2 && path[2].stage == stage::compile));
+	REQUIRE(report.critical_path_length() == Approx(0.007));
+	REQUIRE(report.work() == Approx(0.012));
+	REQUIRE(report.utilization() == Approx(0.6));
+
+	std::ostringstream text;
+	report.write_text(text);
+	REQUIRE(text.str().find("critical path: 7.000 ms, parse a then compile b then compile c") != std::string::npos);
+	REQUIRE(text.str().find("core utilization: 60.0%") != std::string::npos);
+
+	std::ostringstream trace;
+	report.write_chrome_trace(trace);
+	REQUIRE(trace.str().find("{\"name\":\"compile b\",\"cat\":\"compile\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":2000,\"dur\":4000}") != std::string::npos);
+}